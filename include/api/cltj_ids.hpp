@@ -9,7 +9,12 @@
 #include <index/cltj_index_metatrie_dyn.hpp>
 #include <index/cltj_index_spo_dyn.hpp>
 #include <index/cltj_index_spo_lite.hpp>
+#include <memory>
+#include <stdexcept>
 #include <query/ltj_algorithm.hpp>
+#include <query/ltj_prepared_query.hpp>
+#include <util/deadline.hpp>
+#include <util/lru_cache.hpp>
 #include <util/rdf_util.hpp>
 
 using namespace std::chrono;
@@ -26,7 +31,7 @@ class cltj_ids {
 
 public:
   typedef uint64_t size_type;
-  typedef uint32_t value_type;
+  typedef typename Index::value_type value_type;
   typedef Index index_type;
   typedef Trait trait_type;
   typedef uint8_t var_type;
@@ -35,24 +40,44 @@ public:
   typedef Veo veo_type;
   typedef ltj::ltj_algorithm<iterator_type, veo_type> algorithm_type;
   typedef typename algorithm_type::tuple_type tuple_type;
+  typedef typename algorithm_type::filter_type filter_type;
+  // Filters by name of the variable (without '?')
+  typedef std::unordered_map<std::string, filter_type> filters_type;
+  typedef ltj::ltj_prepared_query<const_type, var_type> prepared_type;
+  typedef std::shared_ptr<const prepared_type> prepared_ptr_type;
+  typedef ::util::lru_cache<std::string, prepared_ptr_type> plan_cache_type;
+
+  static constexpr size_type default_plan_cache_capacity = 256;
 
 private:
   index_type m_index;
+  plan_cache_type m_plan_cache{default_plan_cache_capacity};
 
   void copy(const cltj_ids &o) {
     m_index = o.m_index;
+    m_plan_cache = o.m_plan_cache;
+  }
+
+  static uint64_t to_constant(std::string &term) {
+    return ::util::rdf::get_constant(term);
+  }
+
+  static bool
+  resolve(const const_type &c, const state_type st, uint64_t &id) {
+    id = c;
+    return true;
   }
 
   void build(const std::string &dataset) {
-    vector<cltj::spo_triple> D;
+    vector<cltj::spo_triple_t<value_type>> D;
     uint64_t id_so = 0, id_p = 0;
     std::ifstream ifs(dataset);
     std::cout << "============================================================"
               << std::endl;
     std::cout << "Reading data... " << std::flush;
     // STEP1: read the data
-    uint32_t s, p, o;
-    cltj::spo_triple spo;
+    value_type s, p, o;
+    cltj::spo_triple_t<value_type> spo;
     auto start = timer::now();
     do {
       ifs >> s >> p >> o;
@@ -69,7 +94,7 @@ private:
     auto secs = duration_cast<seconds>(stop - start).count();
     std::cout << "done. [" << secs << " secs. ]" << std::endl;
 
-    size_type size_data = 3 * D.size() * sizeof(::uint32_t);
+    size_type size_data = 3 * D.size() * sizeof(value_type);
 
     // STEP2: Build index
     std::cout << "Building index... " << std::flush;
@@ -106,14 +131,173 @@ public:
       size_type limit = 1000,
       size_type timeout_seconds = 600
   ) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    return query(query_str, res, limit, deadline);
+  }
+
+  /**
+   * Same as above, but the query stops when the deadline expires or when it
+   * is cancelled from another thread.
+   */
+  template <class result_type>
+  bool query(
+      const std::string &query_str,
+      result_type &res,
+      size_type limit,
+      ::util::deadline &deadline
+  ) {
 
     std::vector<ltj::triple_pattern> query =
         ::util::rdf::ids::get_query(query_str);
     algorithm_type ltj(&query, &m_index);
+    ltj.join(res, limit, deadline);
+    return true;
+  }
+
+  /**
+   * Query whose variables are restricted to ranges or sets of ids (FILTER).
+   * The filters are applied inside the join, e.g.
+   * filters["x"] = filter_type(100, 200) for FILTER(?x >= 100 && ?x <= 200).
+   *
+   * @param query_str         Query
+   * @param filters           Filters by variable name
+   * @param res               Results
+   */
+  template <class result_type>
+  bool query(
+      const std::string &query_str,
+      const filters_type &filters,
+      result_type &res,
+      size_type limit = 1000,
+      size_type timeout_seconds = 600
+  ) {
+    ::util::rdf::ht_var_id_type ht_var_id;
+    std::vector<ltj::triple_pattern> query =
+        ::util::rdf::ids::get_query(query_str, ht_var_id);
+    algorithm_type ltj(&query, &m_index);
+    for (const auto &f : filters) {
+      auto it = ht_var_id.find(f.first);
+      if (it != ht_var_id.end())
+        ltj.filter(it->second, f.second);
+    }
     ltj.join(res, limit, timeout_seconds);
     return true;
   }
 
+  size_type count(const std::string &query_str, size_type timeout_seconds = 600) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    return count(query_str, deadline);
+  }
+
+  // Same as above, timed_out is set to true if the count is partial
+  size_type count(
+      const std::string &query_str,
+      size_type timeout_seconds,
+      bool &timed_out
+  ) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    const size_type total = count(query_str, deadline);
+    timed_out = deadline.cancelled();
+    return total;
+  }
+
+  size_type count(const std::string &query_str, ::util::deadline &deadline) {
+    std::vector<ltj::triple_pattern> query =
+        ::util::rdf::ids::get_query(query_str);
+    algorithm_type ltj(&query, &m_index);
+    return ltj.count(deadline);
+  }
+
+  /**
+   * Reports the next page of results of a query. The token is empty for the
+   * first page and it is updated after each one, so it can be sent to the
+   * client and given back to get the following page.
+   *
+   * @param query_str         Query
+   * @param page_size         Maximum number of results of the page
+   * @param token             Continuation token (binary string)
+   * @return                  False if there are no more results
+   */
+  template <class result_type>
+  bool query_page(
+      const std::string &query_str,
+      result_type &res,
+      size_type page_size,
+      std::string &token,
+      size_type timeout_seconds = 600
+  ) {
+    typename algorithm_type::continuation_type continuation;
+    if (!token.empty() && !continuation.decode(token))
+      throw std::runtime_error("Invalid continuation token");
+    std::vector<ltj::triple_pattern> query =
+        ::util::rdf::ids::get_query(query_str);
+    algorithm_type ltj(&query, &m_index);
+    bool more = ltj.join_page(res, page_size, continuation, timeout_seconds);
+    token = continuation.encode();
+    return more;
+  }
+
+  /**
+   * Parses and compiles a query template whose constants may be parameters
+   * ($name), e.g. "?x $p $o . ?x 7 ?y". Templates are cached by their
+   * normalized text, so preparing a cached template does not parse it again.
+   *
+   * @param template_str  Query template
+   * @return              Handle to execute the template with query/count
+   */
+  prepared_ptr_type prepare(const std::string &template_str) {
+    auto key = ::util::rdf::normalize(template_str);
+    prepared_ptr_type *cached = m_plan_cache.find(key);
+    if (cached)
+      return *cached;
+    prepared_ptr_type prepared(
+        new prepared_type(::util::rdf::ids::get_query_terms(key), to_constant)
+    );
+    m_plan_cache.insert(key, prepared);
+    return prepared;
+  }
+
+  /**
+   * Executes a prepared query. It only binds the constants and builds the
+   * iterators, the template is neither parsed nor compiled again.
+   *
+   * @param prepared  Prepared query
+   * @param params    Values of the parameters in order of appearance
+   * @return          False if the number of parameters is wrong
+   */
+  template <class result_type>
+  bool query(
+      const prepared_type &prepared,
+      const std::vector<const_type> &params,
+      result_type &res,
+      size_type limit = 1000,
+      size_type timeout_seconds = 600
+  ) {
+    std::vector<ltj::triple_pattern> query;
+    if (!prepared.bind(params, resolve, query))
+      return false;
+    algorithm_type ltj(&query, &m_index, prepared.plan());
+    ltj.join(res, limit, timeout_seconds);
+    return true;
+  }
+
+  size_type count(
+      const prepared_type &prepared,
+      const std::vector<const_type> &params,
+      size_type timeout_seconds = 600
+  ) {
+    std::vector<ltj::triple_pattern> query;
+    if (!prepared.bind(params, resolve, query))
+      return 0;
+    algorithm_type ltj(&query, &m_index, prepared.plan());
+    return ltj.count(timeout_seconds);
+  }
+
+  // Maximum number of cached templates (0 means unbounded)
+  void plan_cache_capacity(const size_type capacity) {
+    m_plan_cache.capacity(capacity);
+  }
+
   bool insert(const std::string &triple) {
     auto spo = ::util::rdf::ids::get_triple(triple);
     return m_index.insert(spo);
@@ -146,12 +330,14 @@ public:
   cltj_ids &operator=(cltj_ids &&o) {
     if (this != &o) {
       m_index = std::move(o.m_index);
+      m_plan_cache = std::move(o.m_plan_cache);
     }
     return *this;
   }
 
   void swap(cltj_ids &o) {
     std::swap(m_index, o.m_index);
+    m_plan_cache.swap(o.m_plan_cache);
   }
 
   size_type serialize(
@@ -8,7 +8,12 @@
 #include <dict/dict_map.hpp>
 #include <index/cltj_index_metatrie_dyn.hpp>
 #include <index/cltj_index_spo_dyn.hpp>
+#include <memory>
+#include <stdexcept>
 #include <query/ltj_algorithm.hpp>
+#include <query/ltj_prepared_query.hpp>
+#include <util/deadline.hpp>
+#include <util/lru_cache.hpp>
 #include <util/rdf_util.hpp>
 
 using namespace std::chrono;
@@ -33,16 +38,73 @@ public:
   typedef Veo veo_type;
   typedef ltj::ltj_algorithm<iterator_type, veo_type> algorithm_type;
   typedef typename algorithm_type::tuple_str_type tuple_type;
+  typedef uint8_t var_type;
+  typedef std::string const_type;
+  typedef ltj::ltj_prepared_query<const_type, var_type> prepared_type;
+  typedef std::shared_ptr<const prepared_type> prepared_ptr_type;
+  typedef ::util::lru_cache<std::string, prepared_ptr_type> plan_cache_type;
+
+  static constexpr size_type default_plan_cache_capacity = 256;
 
 private:
   dict_type m_dict_so;
   dict_type m_dict_p;
   index_type m_index;
+  plan_cache_type m_plan_cache{default_plan_cache_capacity};
 
   void copy(const cltj_rdf &o) {
     m_dict_so = o.m_dict_so;
     m_dict_p = o.m_dict_p;
     m_index = o.m_index;
+    m_plan_cache = o.m_plan_cache;
+  }
+
+  static const_type to_constant(std::string &term) {
+    return term;
+  }
+
+  // Translates the constants of a prepared query into ids
+  bool bind(
+      const prepared_type &prepared,
+      const std::vector<const_type> &params,
+      std::vector<ltj::triple_pattern> &query
+  ) {
+    dict_type &dict_so = m_dict_so;
+    dict_type &dict_p = m_dict_p;
+    return prepared.bind(
+        params,
+        [&dict_so, &dict_p](
+            const const_type &c, const state_type st, uint64_t &id
+        ) {
+          id = (st == p) ? dict_p.locate(c) : dict_so.locate(c);
+          return id != 0;
+        },
+        query
+    );
+  }
+
+  /*
+      The ids are assigned in order of appearance while reading the data.
+      This renumbers them following the (sorted) order of the map, so that
+      ordering by id is the same as ordering by string. Note that the terms
+      inserted later take new ids that do not keep this property.
+  */
+  static void sort_ids(
+      std::map<std::string, uint64_t> &map,
+      vector<cltj::spo_triple> &D,
+      const std::vector<size_type> &positions
+  ) {
+    std::vector<uint64_t> new_id(map.size() + 1);
+    uint64_t id = 0;
+    for (auto &e : map) {
+      new_id[e.second] = ++id;
+      e.second = id;
+    }
+    for (auto &spo : D) {
+      for (const size_type k : positions) {
+        spo[k] = new_id[spo[k]];
+      }
+    }
   }
 
   void build(const std::string &dataset) {
@@ -85,6 +147,9 @@ private:
       D.emplace_back(spo);
     } while (!ifs.eof());
     D.shrink_to_fit();
+    // Reassign the ids in lexicographic order of the strings
+    sort_ids(map_so, D, {0, 2});
+    sort_ids(map_p, D, {1});
     auto stop = timer::now();
     auto secs = duration_cast<seconds>(stop - start).count();
     std::cout << "done. [" << secs << " secs. ]" << std::endl;
@@ -145,6 +210,21 @@ public:
       size_type limit = 1000,
       size_type timeout_seconds = 600
   ) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    return query(query_str, res, limit, deadline);
+  }
+
+  /**
+   * Same as above, but the query stops when the deadline expires or when it
+   * is cancelled from another thread.
+   */
+  template <class result_type>
+  bool query(
+      const std::string &query_str,
+      result_type &res,
+      size_type limit,
+      ::util::deadline &deadline
+  ) {
 
     ::util::rdf::ht_var_id_type ht_var_id;
     std::vector<bool> var_in_p;
@@ -162,13 +242,233 @@ public:
     }
 
     algorithm_type ltj(&query, &m_index);
-    ltj.join_str(res, var_in_p, m_dict_so, m_dict_p, limit, timeout_seconds);
+    ltj.join_str(res, var_in_p, m_dict_so, m_dict_p, limit, deadline);
 
     m_dict_p.reset_cache(); // TODO: ao mellor hai que mellorar isto
     m_dict_so.reset_cache();
     return true;
   }
 
+  /**
+   * Results of a query sorted by a variable (ORDER BY ?var LIMIT limit). The
+   * ids are assigned in lexicographic order of the strings when the index is
+   * built, so the order is the one of the strings (except for the terms
+   * inserted afterwards).
+   *
+   * @param query_str         Query
+   * @param res               Results
+   * @param order_var         Variable of the ORDER BY (with or without '?')
+   * @param limit             Number of results (0 = all)
+   * @param descending        Descending order
+   * @return                  False if a constant is not in the dictionaries
+   */
+  template <class result_type>
+  bool query_ordered(
+      const std::string &query_str,
+      result_type &res,
+      const std::string &order_var,
+      size_type limit = 1000,
+      bool descending = false,
+      size_type timeout_seconds = 600
+  ) {
+
+    ::util::rdf::ht_var_id_type ht_var_id;
+    std::vector<bool> var_in_p;
+    std::vector<ltj::triple_pattern> query;
+
+    std::vector<cltj::user_triple> tokens =
+        ::util::rdf::str::get_query(query_str);
+    for (cltj::user_triple &token : tokens) {
+      auto p = ::util::rdf::str::get_triple_pattern(
+          token, ht_var_id, var_in_p, m_dict_so, m_dict_p
+      );
+      if (!p.first)
+        return false;
+      query.push_back(p.second);
+    }
+    const std::string name =
+        (!order_var.empty() && order_var[0] == '?') ? order_var.substr(1)
+                                                     : order_var;
+    auto it = ht_var_id.find(name);
+    // A variable that is not in the query does not constrain the order
+    var_type var = (it == ht_var_id.end()) ? (var_type)-1 : it->second;
+
+    algorithm_type ltj(&query, &m_index);
+    ::util::deadline deadline(timeout_seconds * 1000);
+    ltj.join_ordered_str(
+        res, var_in_p, m_dict_so, m_dict_p, var, limit, descending, deadline
+    );
+
+    m_dict_p.reset_cache();
+    m_dict_so.reset_cache();
+    return true;
+  }
+
+  size_type count(const std::string &query_str, size_type timeout_seconds = 600) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    return count(query_str, deadline);
+  }
+
+  // Same as above, timed_out is set to true if the count is partial
+  size_type count(
+      const std::string &query_str,
+      size_type timeout_seconds,
+      bool &timed_out
+  ) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    const size_type total = count(query_str, deadline);
+    timed_out = deadline.cancelled();
+    return total;
+  }
+
+  size_type count(const std::string &query_str, ::util::deadline &deadline) {
+
+    ::util::rdf::ht_var_id_type ht_var_id;
+    std::vector<bool> var_in_p;
+    std::vector<ltj::triple_pattern> query;
+
+    std::vector<cltj::user_triple> tokens =
+        ::util::rdf::str::get_query(query_str);
+    for (cltj::user_triple &token : tokens) {
+      auto p = ::util::rdf::str::get_triple_pattern(
+          token, ht_var_id, var_in_p, m_dict_so, m_dict_p
+      );
+      if (!p.first)
+        return 0; // Unknown constant: no solutions
+      query.push_back(p.second);
+    }
+
+    algorithm_type ltj(&query, &m_index);
+    auto cnt = ltj.count(deadline);
+
+    m_dict_p.reset_cache();
+    m_dict_so.reset_cache();
+    return cnt;
+  }
+
+  /**
+   * Reports the next page of results of a query. The token is empty for the
+   * first page and it is updated after each one, so it can be sent to the
+   * client and given back to get the following page.
+   *
+   * @param query_str         Query
+   * @param page_size         Maximum number of results of the page
+   * @param token             Continuation token (binary string)
+   * @return                  False if there are no more results
+   */
+  template <class result_type>
+  bool query_page(
+      const std::string &query_str,
+      result_type &res,
+      size_type page_size,
+      std::string &token,
+      size_type timeout_seconds = 600
+  ) {
+    typename algorithm_type::continuation_type continuation;
+    if (!token.empty() && !continuation.decode(token))
+      throw std::runtime_error("Invalid continuation token");
+
+    ::util::rdf::ht_var_id_type ht_var_id;
+    std::vector<bool> var_in_p;
+    std::vector<ltj::triple_pattern> query;
+
+    std::vector<cltj::user_triple> tokens =
+        ::util::rdf::str::get_query(query_str);
+    for (cltj::user_triple &t : tokens) {
+      auto p = ::util::rdf::str::get_triple_pattern(
+          t, ht_var_id, var_in_p, m_dict_so, m_dict_p
+      );
+      if (!p.first)
+        return false;
+      query.push_back(p.second);
+    }
+
+    algorithm_type ltj(&query, &m_index);
+    ::util::deadline deadline(timeout_seconds * 1000);
+    bool more = ltj.join_page_str(
+        res, var_in_p, m_dict_so, m_dict_p, page_size, continuation, deadline
+    );
+    token = continuation.encode();
+
+    m_dict_p.reset_cache();
+    m_dict_so.reset_cache();
+    return more;
+  }
+
+  /**
+   * Parses and compiles a query template whose constants may be parameters
+   * ($name), e.g. "?x $p $o . ?x <knows> ?y". Templates are cached by their
+   * normalized text, so preparing a cached template does not parse it again.
+   *
+   * @param template_str  Query template
+   * @return              Handle to execute the template with query/count
+   */
+  prepared_ptr_type prepare(const std::string &template_str) {
+    auto key = ::util::rdf::normalize(template_str);
+    prepared_ptr_type *cached = m_plan_cache.find(key);
+    if (cached)
+      return *cached;
+    prepared_ptr_type prepared(
+        new prepared_type(::util::rdf::str::get_query(key), to_constant)
+    );
+    m_plan_cache.insert(key, prepared);
+    return prepared;
+  }
+
+  /**
+   * Executes a prepared query. It only locates the constants in the
+   * dictionaries and builds the iterators, the template is neither parsed nor
+   * compiled again.
+   *
+   * @param prepared  Prepared query
+   * @param params    Values of the parameters in order of appearance
+   * @return          False if the number of parameters is wrong or a
+   * constant is not in the dictionaries
+   */
+  template <class result_type>
+  bool query(
+      const prepared_type &prepared,
+      const std::vector<const_type> &params,
+      result_type &res,
+      size_type limit = 1000,
+      size_type timeout_seconds = 600
+  ) {
+    std::vector<ltj::triple_pattern> query;
+    if (!bind(prepared, params, query))
+      return false;
+
+    algorithm_type ltj(&query, &m_index, prepared.plan());
+    ltj.join_str(
+        res, prepared.var_in_p(), m_dict_so, m_dict_p, limit, timeout_seconds
+    );
+
+    m_dict_p.reset_cache();
+    m_dict_so.reset_cache();
+    return true;
+  }
+
+  size_type count(
+      const prepared_type &prepared,
+      const std::vector<const_type> &params,
+      size_type timeout_seconds = 600
+  ) {
+    std::vector<ltj::triple_pattern> query;
+    if (!bind(prepared, params, query))
+      return 0; // Unknown constant: no solutions
+
+    algorithm_type ltj(&query, &m_index, prepared.plan());
+    auto cnt = ltj.count(timeout_seconds);
+
+    m_dict_p.reset_cache();
+    m_dict_so.reset_cache();
+    return cnt;
+  }
+
+  // Maximum number of cached templates (0 means unbounded)
+  void plan_cache_capacity(const size_type capacity) {
+    m_plan_cache.capacity(capacity);
+  }
+
   bool insert(const std::string &triple) {
     auto spo_str = ::util::rdf::str::get_triple(triple);
     cltj::spo_triple spo;
@@ -227,6 +527,7 @@ public:
       m_dict_so = std::move(o.m_dict_so);
       m_dict_p = std::move(o.m_dict_p);
       m_index = std::move(o.m_index);
+      m_plan_cache = std::move(o.m_plan_cache);
     }
     return *this;
   }
@@ -235,6 +536,7 @@ public:
     std::swap(m_dict_so, o.m_dict_so);
     std::swap(m_dict_p, o.m_dict_p);
     std::swap(m_index, o.m_index);
+    m_plan_cache.swap(o.m_plan_cache);
   }
 
   size_type serialize(
@@ -0,0 +1,316 @@
+#ifndef CDS_PARTITIONED_EF_HPP
+#define CDS_PARTITIONED_EF_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <sdsl/bits.hpp>
+#include <sdsl/vectors.hpp>
+#include <utility>
+#include <vector>
+
+namespace cds {
+
+/**
+ * Non-decreasing sequence of integers encoded with Elias-Fano in blocks of
+ * t_block elements (uniform partitions). Every block stores its first value
+ * and the differences with it, with its own width for the low parts, so the
+ * dense and the sparse regions of the sequence do not pay for each other.
+ *
+ * The bits of a block are the low parts of its elements followed by the high
+ * parts in unary: a 1 for each element and a 0 at the end of each bucket of
+ * 2^width values. next_geq skips to the bucket of the value with a select0
+ * inside the block, instead of bisecting.
+ *
+ * @tparam t_block  Number of elements of each block
+ */
+template <uint32_t t_block = 128> class partitioned_ef {
+
+public:
+  typedef uint64_t size_type;
+  typedef uint64_t value_type;
+
+private:
+  size_type m_size = 0;
+  sdsl::int_vector<> m_bases;   // First value of each block
+  sdsl::int_vector<> m_offsets; // Start of each block in m_bits (and the end)
+  sdsl::int_vector<8> m_widths; // Width of the low parts of each block
+  sdsl::bit_vector m_bits;
+
+  void copy(const partitioned_ef &o) {
+    m_size = o.m_size;
+    m_bases = o.m_bases;
+    m_offsets = o.m_offsets;
+    m_widths = o.m_widths;
+    m_bits = o.m_bits;
+  }
+
+  inline size_type block_size(const size_type b) const {
+    return std::min<size_type>(t_block, m_size - b * t_block);
+  }
+
+  // Start of the high parts of block b
+  inline size_type high_start(const size_type b) const {
+    return m_offsets[b] + block_size(b) * m_widths[b];
+  }
+
+  inline value_type low(const size_type b, const size_type j) const {
+    const uint8_t width = m_widths[b];
+    return width ? m_bits.get_int(m_offsets[b] + j * width, width) : 0;
+  }
+
+  /*
+      Positions are relative to h, the start of the high parts of a block.
+      The block has enough ones and zeros for every call, and m_bits has one
+      word of padding, so the reads of 64 bits do not check the end.
+  */
+  inline size_type select1(const size_type h, size_type j) const {
+    size_type p = h;
+    while (true) {
+      const uint64_t w = m_bits.get_int(p, 64);
+      const uint64_t cnt = sdsl::bits::cnt(w);
+      if (j < cnt)
+        return p - h + sdsl::bits::sel(w, j + 1);
+      j -= cnt;
+      p += 64;
+    }
+  }
+
+  inline size_type select0(const size_type h, size_type j) const {
+    size_type p = h;
+    while (true) {
+      const uint64_t w = ~m_bits.get_int(p, 64);
+      const uint64_t cnt = sdsl::bits::cnt(w);
+      if (j < cnt)
+        return p - h + sdsl::bits::sel(w, j + 1);
+      j -= cnt;
+      p += 64;
+    }
+  }
+
+  // First one at a position >= p
+  inline size_type next1(const size_type h, const size_type p) const {
+    size_type q = h + p;
+    while (true) {
+      const uint64_t w = m_bits.get_int(q, 64);
+      if (w)
+        return q - h + sdsl::bits::lo(w);
+      q += 64;
+    }
+  }
+
+  /*
+      First element >= x among the elements j0..j1 of block b.
+      Returns its value and its index in the block, or j1 + 1 if there is not.
+  */
+  std::pair<value_type, size_type> next_geq_block(
+      const value_type x,
+      const size_type b,
+      const size_type j0,
+      const size_type j1
+  ) const {
+    const value_type base = m_bases[b];
+    const uint8_t width = m_widths[b];
+    const size_type h = high_start(b);
+    size_type j = j0, p;
+    if (x <= base) {
+      p = select1(h, j);
+    } else {
+      const value_type hx = (x - base) >> width;
+      const size_type zeros = m_offsets[b + 1] - h - block_size(b);
+      if (hx >= zeros)
+        return std::make_pair(0, j1 + 1);
+      // Start of the bucket of x, after the zero that ends bucket hx - 1
+      p = hx ? select0(h, hx - 1) + 1 : 0;
+      j = p - hx; // Elements in the buckets before hx
+      if (j > j1)
+        return std::make_pair(0, j1 + 1);
+      if (j < j0) {
+        j = j0;
+        p = select1(h, j);
+      } else {
+        p = next1(h, p);
+      }
+    }
+    // Only the elements in the bucket of x can be smaller than it
+    while (true) {
+      const value_type v = base + (((p - j) << width) | low(b, j));
+      if (v >= x)
+        return std::make_pair(v, j);
+      if (j == j1)
+        return std::make_pair(0, j1 + 1);
+      ++j;
+      p = next1(h, p + 1);
+    }
+  }
+
+public:
+  partitioned_ef() = default;
+
+  /**
+   *
+   * @param values  Non-decreasing sequence with size() and operator[]
+   */
+  template <class Container> explicit partitioned_ef(const Container &values) {
+    m_size = values.size();
+    const size_type blocks = (m_size + t_block - 1) / t_block;
+    m_bases = sdsl::int_vector<>(blocks, 0, 64);
+    m_offsets = sdsl::int_vector<>(blocks + 1, 0, 64);
+    m_widths = sdsl::int_vector<8>(blocks, 0);
+    size_type n_bits = 0;
+    for (size_type b = 0; b < blocks; ++b) {
+      const size_type first = b * t_block, n = block_size(b);
+      const value_type base = values[first];
+      const value_type u = values[first + n - 1] - base;
+      const uint8_t width = (u > n) ? sdsl::bits::hi(u / n) : 0;
+      m_bases[b] = base;
+      m_widths[b] = width;
+      m_offsets[b] = n_bits;
+      n_bits += n * width + n + (u >> width) + 1;
+    }
+    m_offsets[blocks] = n_bits;
+    m_bits = sdsl::bit_vector(n_bits + 64, 0);
+    for (size_type b = 0; b < blocks; ++b) {
+      const size_type first = b * t_block, n = block_size(b);
+      const uint8_t width = m_widths[b];
+      const size_type h = high_start(b);
+      for (size_type j = 0; j < n; ++j) {
+        const value_type d = values[first + j] - m_bases[b];
+        if (width) {
+          const value_type mask =
+              (width == 64) ? -1ULL : ((1ULL << width) - 1);
+          m_bits.set_int(m_offsets[b] + j * width, d & mask, width);
+        }
+        m_bits[h + (d >> width) + j] = 1;
+      }
+    }
+    sdsl::util::bit_compress(m_bases);
+    sdsl::util::bit_compress(m_offsets);
+  }
+
+  //! Copy constructor
+  partitioned_ef(const partitioned_ef &o) {
+    copy(o);
+  }
+
+  //! Move constructor
+  partitioned_ef(partitioned_ef &&o) {
+    *this = std::move(o);
+  }
+
+  //! Copy Operator=
+  partitioned_ef &operator=(const partitioned_ef &o) {
+    if (this != &o) {
+      copy(o);
+    }
+    return *this;
+  }
+
+  //! Move Operator=
+  partitioned_ef &operator=(partitioned_ef &&o) {
+    if (this != &o) {
+      m_size = o.m_size;
+      m_bases = std::move(o.m_bases);
+      m_offsets = std::move(o.m_offsets);
+      m_widths = std::move(o.m_widths);
+      m_bits = std::move(o.m_bits);
+    }
+    return *this;
+  }
+
+  void swap(partitioned_ef &o) {
+    std::swap(m_size, o.m_size);
+    m_bases.swap(o.m_bases);
+    m_offsets.swap(o.m_offsets);
+    m_widths.swap(o.m_widths);
+    m_bits.swap(o.m_bits);
+  }
+
+  inline size_type size() const {
+    return m_size;
+  }
+
+  inline value_type operator[](const size_type i) const {
+    const size_type b = i / t_block, j = i % t_block;
+    const size_type p = select1(high_start(b), j);
+    return m_bases[b] + (((p - j) << m_widths[b]) | low(b, j));
+  }
+
+  /**
+   * First element >= x in [i, f]
+   *
+   * @param x   Value to search
+   * @param i   First position of the range
+   * @param f   Last position of the range
+   * @return    Value and position of the element, or (0, f + 1) if all the
+   *            elements of the range are smaller than x
+   */
+  std::pair<value_type, size_type>
+  next_geq(const value_type x, const size_type i, const size_type f) const {
+    const size_type bi = i / t_block, bf = f / t_block;
+    // First block in (bi, bf] that starts with a value >= x
+    size_type lo = bi + 1, hi = bf + 1, mid;
+    while (lo < hi) {
+      mid = (lo + hi) / 2;
+      if (m_bases[mid] < x) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    // x is in the block before it, or it is its first element
+    const size_type b = lo - 1, first = b * t_block;
+    const size_type beg = (b == bi) ? i : first;
+    const size_type end = std::min(f, first + block_size(b) - 1);
+    const auto r = next_geq_block(x, b, beg - first, end - first);
+    if (r.second <= end - first)
+      return std::make_pair(r.first, first + r.second);
+    if (lo <= bf)
+      return std::make_pair((value_type)m_bases[lo], lo * t_block);
+    return std::make_pair(0, f + 1);
+  }
+
+  // Prefetches the bits of the block of position i
+  inline void prefetch(const size_type i) const {
+#if defined(__GNUC__)
+    const size_type b = i / t_block;
+    const uint64_t *data = m_bits.data() + (m_offsets[b] >> 6);
+    __builtin_prefetch(data);
+    __builtin_prefetch(data + 8);
+#endif
+  }
+
+  size_type size_in_bytes() const {
+    return sdsl::size_in_bytes(m_bases) + sdsl::size_in_bytes(m_offsets) +
+           sdsl::size_in_bytes(m_widths) + sdsl::size_in_bytes(m_bits);
+  }
+
+  //! Serializes the data structure into the given ostream
+  size_type serialize(
+      std::ostream &out,
+      sdsl::structure_tree_node *v = nullptr,
+      std::string name = ""
+  ) const {
+    sdsl::structure_tree_node *child =
+        sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+    size_type written_bytes = 0;
+    written_bytes += sdsl::write_member(m_size, out, child, "size");
+    written_bytes += m_bases.serialize(out, child, "bases");
+    written_bytes += m_offsets.serialize(out, child, "offsets");
+    written_bytes += m_widths.serialize(out, child, "widths");
+    written_bytes += m_bits.serialize(out, child, "bits");
+    sdsl::structure_tree::add_size(child, written_bytes);
+    return written_bytes;
+  }
+
+  void load(std::istream &in) {
+    sdsl::read_member(m_size, in);
+    m_bases.load(in);
+    m_offsets.load(in);
+    m_widths.load(in);
+    m_bits.load(in);
+  }
+};
+
+} // namespace cds
+
+#endif // CDS_PARTITIONED_EF_HPP
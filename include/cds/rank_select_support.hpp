@@ -0,0 +1,285 @@
+#ifndef CDS_RANK_SELECT_SUPPORT_HPP
+#define CDS_RANK_SELECT_SUPPORT_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <sdsl/bits.hpp>
+#include <sdsl/vectors.hpp>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace cds {
+
+/**
+ * Rank, select and succ of a bit pattern over one directory.
+ *
+ * The rank directory is the one of rank9: two words per block of 512 bits,
+ * the number of pattern bits before the block and seven 9-bit counts
+ * relative to it, one per word of the block. select is rank-sampled: the
+ * block of one pattern bit out of every 2^t_sample_log is kept, the block
+ * of the kth bit is found from its sample with the counts of the
+ * directory, then its word with the relative counts, and then the bit with
+ * pdep/tzcnt (BMI2) or the broadword select of sdsl::bits.
+ *
+ * succ looks for the bit in the rest of the block of the position (the
+ * usual case in the sibling runs of a trie) and otherwise it is
+ * select(rank + 1). It replaces the pair select_support_mcl and
+ * succ_support_v of the tries with a single structure.
+ *
+ * @tparam t_b           Bit pattern (`0` or `1`)
+ * @tparam t_sample_log  log2 of the pattern bits between select samples
+ */
+template <uint8_t t_b = 0, uint8_t t_sample_log = 9>
+class rank_select_support {
+private:
+  static_assert(
+      t_b == 1u or t_b == 0u,
+      "rank_select_support: bit pattern must be `0`or `1`"
+  );
+
+public:
+  typedef sdsl::bit_vector bit_vector_type;
+  typedef sdsl::int_vector_size_type size_type;
+  enum { bit_pat = t_b };
+
+private:
+  const sdsl::bit_vector *m_v = nullptr; // pointer to the supported bit_vector
+  sdsl::int_vector<64> m_counts; // 2 words per block of 512 bits (+ the end)
+  sdsl::int_vector<> m_samples;  // Block of the pattern bits 1, 2^s + 1...
+  size_type m_count = 0;         // Pattern bits of the bit_vector
+
+  void copy(const rank_select_support &p) {
+    m_v = p.m_v;
+    m_counts = p.m_counts;
+    m_samples = p.m_samples;
+    m_count = p.m_count;
+  }
+
+  inline size_type words() const {
+    return (m_v->size() + 63) >> 6;
+  }
+
+  inline size_type blocks() const {
+    return (words() + 7) >> 3;
+  }
+
+  // Word w of the bit_vector with the pattern bits set
+  inline uint64_t word(const size_type w) const {
+    const uint64_t x = m_v->data()[w];
+    return t_b ? x : ~x;
+  }
+
+  // Pattern bits in the first j words of block b (j < 8)
+  inline size_type relative(const size_type b, const size_type j) const {
+    return j ? (m_counts[2 * b + 1] >> (9 * (j - 1))) & 0x1FF : 0;
+  }
+
+  /*
+      Receives a word and r < popcount(x)
+      Returns the position of its rth set bit (from 0)
+  */
+  static inline uint32_t select_word(const uint64_t x, const uint32_t r) {
+#if defined(__BMI2__)
+    return __builtin_ctzll(_pdep_u64(1ULL << r, x));
+#else
+    return sdsl::bits::sel(x, r + 1);
+#endif
+  }
+
+  void build() {
+    const size_type n = m_v->size(), n_words = words(), n_blocks = blocks();
+    m_counts = sdsl::int_vector<64>(2 * n_blocks + 2, 0);
+    size_type count = 0;
+    for (size_type b = 0; b < n_blocks; ++b) {
+      m_counts[2 * b] = count;
+      uint64_t rel = 0, packed = 0;
+      for (size_type j = 0; j < 8; ++j) {
+        const size_type w = 8 * b + j;
+        if (j > 0) {
+          packed |= rel << (9 * (j - 1));
+        }
+        if (w < n_words) {
+          uint64_t x = word(w);
+          if (w == n_words - 1 && (n & 63)) {
+            x &= (1ULL << (n & 63)) - 1;
+          }
+          rel += sdsl::bits::cnt(x);
+        }
+      }
+      m_counts[2 * b + 1] = packed;
+      count += rel;
+    }
+    m_counts[2 * n_blocks] = count;
+    m_count = count;
+
+    m_samples = sdsl::int_vector<>(
+        (count + (1ULL << t_sample_log) - 1) >> t_sample_log, 0, 64
+    );
+    size_type next = 1;
+    for (size_type b = 0; b < n_blocks; ++b) {
+      for (; next <= m_counts[2 * b + 2]; next += (1ULL << t_sample_log)) {
+        m_samples[(next - 1) >> t_sample_log] = b;
+      }
+    }
+    sdsl::util::bit_compress(m_samples);
+  }
+
+public:
+  rank_select_support() = default;
+
+  explicit rank_select_support(const sdsl::bit_vector *v) {
+    set_vector(v);
+    if (v != nullptr) {
+      build();
+    }
+  }
+
+  //! Copy constructor
+  rank_select_support(const rank_select_support &p) {
+    copy(p);
+  }
+
+  //! Move constructor
+  rank_select_support(rank_select_support &&p) {
+    *this = std::move(p);
+  }
+
+  //! Copy Operator=
+  rank_select_support &operator=(const rank_select_support &p) {
+    if (this != &p) {
+      copy(p);
+    }
+    return *this;
+  }
+
+  //! Move Operator=
+  rank_select_support &operator=(rank_select_support &&p) {
+    if (this != &p) {
+      m_v = p.m_v;
+      m_counts = std::move(p.m_counts);
+      m_samples = std::move(p.m_samples);
+      m_count = p.m_count;
+    }
+    return *this;
+  }
+
+  void swap(rank_select_support &p) {
+    if (this != &p) {
+      m_counts.swap(p.m_counts);
+      m_samples.swap(p.m_samples);
+      std::swap(m_count, p.m_count);
+    }
+  }
+
+  /*
+      Receives a position i <= size()
+      Returns the number of pattern bits in [0, i)
+  */
+  inline size_type rank(const size_type i) const {
+    const size_type w = i >> 6, b = w >> 3;
+    size_type r = m_counts[2 * b] + relative(b, w & 7);
+    if (i & 63) {
+      r += sdsl::bits::cnt(word(w) & ((1ULL << (i & 63)) - 1));
+    }
+    return r;
+  }
+
+  /*
+      Receives 1 <= k <= count()
+      Returns the position of the kth pattern bit
+  */
+  inline size_type select(const size_type k) const {
+    const size_type s = (k - 1) >> t_sample_log;
+    size_type lo = m_samples[s];
+    size_type hi =
+        (s + 1 < m_samples.size()) ? size_type(m_samples[s + 1]) : blocks() - 1;
+    // Last block with less than k pattern bits before it
+    if (hi - lo <= 8) {
+      while (lo < hi && m_counts[2 * (lo + 1)] < k) {
+        ++lo;
+      }
+    } else {
+      size_type mid;
+      while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        if (m_counts[2 * mid] < k) {
+          lo = mid;
+        } else {
+          hi = mid - 1;
+        }
+      }
+    }
+    const size_type r = k - m_counts[2 * lo];
+    size_type j = 0;
+    while (j < 7 && relative(lo, j + 1) < r) {
+      ++j;
+    }
+    const size_type w = 8 * lo + j;
+    return (w << 6) + select_word(word(w), r - relative(lo, j) - 1);
+  }
+
+  /*
+      Receives a position i
+      Returns the position of the first pattern bit >= i (or the size)
+  */
+  inline size_type succ(const size_type i) const {
+    const size_type n = m_v->size();
+    if (i >= n)
+      return n;
+    size_type w = i >> 6;
+    const size_type end = std::min(words(), (w | 7) + 1);
+    uint64_t x = word(w) & (-1ULL << (i & 63));
+    while (!x && ++w < end) {
+      x = word(w);
+    }
+    if (x) // the last word has pattern bits after the end if t_b = 0
+      return std::min<size_type>((w << 6) + sdsl::bits::lo(x), n);
+    if (w >= words())
+      return n;
+    const size_type r = m_counts[2 * (w >> 3)];
+    return (r < m_count) ? select(r + 1) : n;
+  }
+
+  inline size_type operator()(const size_type k) const {
+    return select(k);
+  }
+
+  inline size_type count() const {
+    return m_count;
+  }
+
+  size_type size() const {
+    return m_v->size();
+  }
+
+  void set_vector(const sdsl::bit_vector *v = nullptr) {
+    m_v = v;
+  }
+
+  size_type serialize(
+      std::ostream &out,
+      sdsl::structure_tree_node *v = nullptr,
+      std::string name = ""
+  ) const {
+    size_type written_bytes = 0;
+    sdsl::structure_tree_node *child =
+        sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+    written_bytes += m_counts.serialize(out, child, "counts");
+    written_bytes += m_samples.serialize(out, child, "samples");
+    written_bytes += sdsl::write_member(m_count, out, child, "count");
+    sdsl::structure_tree::add_size(child, written_bytes);
+    return written_bytes;
+  }
+
+  void load(std::istream &in, const sdsl::bit_vector *v = nullptr) {
+    set_vector(v);
+    m_counts.load(in);
+    m_samples.load(in);
+    sdsl::read_member(m_count, in);
+  }
+};
+
+} // namespace cds
+
+#endif // CDS_RANK_SELECT_SUPPORT_HPP
@@ -0,0 +1,126 @@
+#ifndef CDS_SELECT_SUCC_SUPPORT_HPP
+#define CDS_SELECT_SUCC_SUPPORT_HPP
+
+#include <cds/succ_support_v.hpp>
+#include <cstdint>
+#include <sdsl/select_support_mcl.hpp>
+#include <sdsl/vectors.hpp>
+
+namespace cds {
+
+/**
+ * select and succ of a bit pattern with sdsl::select_support_mcl and
+ * succ_support_v, the two structures of the compact tries, behind the
+ * interface of rank_select_support (without rank). The serialized form is
+ * the one the tries wrote before: succ and then select.
+ *
+ * @tparam t_b  Bit pattern (`0` or `1`)
+ */
+template <uint8_t t_b = 0> class select_succ_support {
+
+public:
+  typedef sdsl::bit_vector bit_vector_type;
+  typedef sdsl::int_vector_size_type size_type;
+  enum { bit_pat = t_b };
+
+private:
+  succ_support_v<t_b> m_succ;
+  sdsl::select_support_mcl<t_b> m_select;
+
+  void copy(const select_succ_support &p) {
+    m_succ = p.m_succ;
+    m_select = p.m_select;
+  }
+
+public:
+  select_succ_support() = default;
+
+  explicit select_succ_support(const sdsl::bit_vector *v) {
+    if (v != nullptr) {
+      sdsl::util::init_support(m_succ, v);
+      sdsl::util::init_support(m_select, v);
+    }
+  }
+
+  //! Copy constructor
+  select_succ_support(const select_succ_support &p) {
+    copy(p);
+  }
+
+  //! Move constructor
+  select_succ_support(select_succ_support &&p) {
+    *this = std::move(p);
+  }
+
+  //! Copy Operator=
+  select_succ_support &operator=(const select_succ_support &p) {
+    if (this != &p) {
+      copy(p);
+    }
+    return *this;
+  }
+
+  //! Move Operator=
+  select_succ_support &operator=(select_succ_support &&p) {
+    if (this != &p) {
+      m_succ = std::move(p.m_succ);
+      m_select = std::move(p.m_select);
+    }
+    return *this;
+  }
+
+  void swap(select_succ_support &p) {
+    if (this != &p) {
+      m_succ.swap(p.m_succ);
+      m_select.swap(p.m_select);
+    }
+  }
+
+  /*
+      Receives 1 <= k <= number of pattern bits
+      Returns the position of the kth pattern bit
+  */
+  inline size_type select(const size_type k) const {
+    return m_select(k);
+  }
+
+  inline size_type operator()(const size_type k) const {
+    return select(k);
+  }
+
+  /*
+      Receives a position i <= size()
+      Returns the position of the first pattern bit at or after i, or size()
+  */
+  inline size_type succ(const size_type i) const {
+    return m_succ(i);
+  }
+
+  void set_vector(const sdsl::bit_vector *v = nullptr) {
+    m_succ.set_vector(v);
+    m_select.set_vector(v);
+  }
+
+  size_type serialize(
+      std::ostream &out,
+      sdsl::structure_tree_node *v = nullptr,
+      std::string name = ""
+  ) const {
+    size_type written_bytes = 0;
+    sdsl::structure_tree_node *child =
+        sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+    written_bytes += m_succ.serialize(out, child, "succ");
+    written_bytes += m_select.serialize(out, child, "select");
+    sdsl::structure_tree::add_size(child, written_bytes);
+    return written_bytes;
+  }
+
+  void load(std::istream &in, const sdsl::bit_vector *v = nullptr) {
+    m_succ.load(in, v);
+    m_select.load(in, v);
+  }
+};
+
+} // namespace cds
+
+#endif // CDS_SELECT_SUCC_SUPPORT_HPP
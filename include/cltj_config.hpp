@@ -15,7 +15,9 @@ using namespace std;
 */
 // typedef CompactTrieIterator CurrentIterator;
 // typedef CompactTrie CTrie;
-typedef std::array<uint32_t, 3> spo_triple;
+// Triple of IDs; spo_triple_t<uint64_t> holds IDs beyond 2^32
+template <class t_id> using spo_triple_t = std::array<t_id, 3>;
+typedef spo_triple_t<uint32_t> spo_triple;
 typedef std::array<std::string, 3> user_triple;
 typedef uint8_t spo_order_type[3];
 typedef spo_order_type spo_orders_type[6];
@@ -40,7 +42,8 @@ struct comparator_order {
   comparator_order(uint64_t pi) {
     i = pi;
   };
-  inline bool operator()(const spo_triple &t1, const spo_triple &t2) {
+  template <class t_triple>
+  inline bool operator()(const t_triple &t1, const t_triple &t2) {
     if (t1[spo_orders[i][0]] == t2[spo_orders[i][0]]) {
       if (t1[spo_orders[i][1]] == t2[spo_orders[i][1]]) {
         return t1[spo_orders[i][2]] < t2[spo_orders[i][2]];
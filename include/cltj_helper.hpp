@@ -5,17 +5,21 @@
 #ifndef CLTJ_HELPER_HPP
 #define CLTJ_HELPER_HPP
 
+#include <algorithm>
+#include <array>
 #include <cltj_config.hpp>
 #include <cstdint>
+#include <sdsl/vectors.hpp>
 #include <vector>
 
 namespace cltj {
 
 namespace helper {
 
+template <class t_triple>
 static bool equal(
-    const spo_triple &a,
-    const spo_triple &b,
+    const t_triple &a,
+    const t_triple &b,
     const spo_order_type &order,
     const uint64_t l
 ) {
@@ -26,9 +30,10 @@ static bool equal(
   return true;
 }
 
+template <class t_triple>
 static bool same_parent(
-    const spo_triple &a,
-    const spo_triple &b,
+    const t_triple &a,
+    const t_triple &b,
     const spo_order_type &order,
     const uint64_t l
 ) {
@@ -39,20 +44,55 @@ static bool same_parent(
   return true;
 }
 
+/*
+    Receives the sorted triples [beg, end) and the levels [level, 3)
+    Reserves in syms and lengths the exact number of nodes and runs of
+    those levels, so they do not grow by doubling on large datasets
+*/
+template <class t_iterator, class t_sym>
+static void reserve_levels(
+    t_iterator beg,
+    t_iterator end,
+    const spo_order_type &order,
+    uint64_t level,
+    std::vector<t_sym> &syms,
+    std::vector<uint64_t> &lengths
+) {
+  // nodes[l] is the number of nodes at level l
+  std::array<uint64_t, 3> nodes = {{1, 1, 1}};
+  for (t_iterator prev = beg, curr = beg + 1; curr != end; ++prev, ++curr) {
+    uint64_t l = 0; // first level where they differ
+    while (l < 3 && (*prev)[order[l]] == (*curr)[order[l]]) {
+      ++l;
+    }
+    for (; l < 3; ++l) {
+      ++nodes[l];
+    }
+  }
+  // The runs of level l are the nodes of level l - 1 (one at the root)
+  uint64_t n_syms = 0, n_lengths = 0;
+  for (uint64_t l = level; l < 3; ++l) {
+    n_syms += nodes[l];
+    n_lengths += l ? nodes[l - 1] : 1;
+  }
+  syms.reserve(syms.size() + n_syms);
+  lengths.reserve(lengths.size() + n_lengths);
+}
+
+template <class t_triple, class t_sym>
 static void sym_level(
-    const vector<spo_triple> &D,
+    const vector<t_triple> &D,
     const spo_order_type &order,
     uint64_t level,
-    std::vector<uint32_t> &syms,
+    std::vector<t_sym> &syms,
     std::vector<uint64_t> &lengths
 ) {
-  spo_triple prev, curr;
+  reserve_levels(D.begin(), D.end(), order, level, syms, lengths);
   uint64_t children;
-  for (uint32_t l = level; l < 3; ++l) {
+  for (uint64_t l = level; l < 3; ++l) {
     children = 1;
     for (uint64_t i = 1; i < D.size(); ++i) {
-      prev = D[i - 1];
-      curr = D[i];
+      const t_triple &prev = D[i - 1], &curr = D[i];
       if (!helper::equal(prev, curr, order, l)) {
         syms.emplace_back(prev[order[l]]);
         if (!same_parent(
@@ -65,23 +105,25 @@ static void sym_level(
         }
       }
     }
-    syms.emplace_back(curr[order[l]]);
+    syms.emplace_back(D.back()[order[l]]);
     lengths.emplace_back(children);
   }
 }
 
+template <class t_iterator, class t_sym>
 static void sym_level(
-    vector<spo_triple>::iterator beg,
-    vector<spo_triple>::iterator end,
+    t_iterator beg,
+    t_iterator end,
     const spo_order_type &order,
     uint64_t level,
-    std::vector<uint32_t> &syms,
+    std::vector<t_sym> &syms,
     std::vector<uint64_t> &lengths
 ) {
-  vector<spo_triple>::iterator prev, curr;
+  reserve_levels(beg, end, order, level, syms, lengths);
+  t_iterator prev, curr;
   uint64_t children;
 
-  for (uint32_t l = level; l < 3; ++l) {
+  for (uint64_t l = level; l < 3; ++l) {
     children = 1;
     prev = beg;
     curr = beg + 1;
@@ -104,6 +146,70 @@ static void sym_level(
     lengths.emplace_back(children);
   }
 }
+/*
+    Receives the triples D sorted by order
+    Fills bv and seq of the metatrie of D: the symbols of levels 0, 1 and 2
+    (only level 1 if it is not full) followed by a mock 0, and run_bit in
+    bv at the start of each run of siblings and at the mock. It makes two
+    passes over D (counts, then symbols) and writes bv and seq in place,
+    so there are no intermediate vectors of 64-bit integers. seq has the
+    given width, or the one of the largest symbol if it is 0.
+*/
+template <class t_triple>
+static void metatrie_levels(
+    const vector<t_triple> &D,
+    const spo_order_type &order,
+    const bool full,
+    const bool run_bit,
+    sdsl::bit_vector &bv,
+    sdsl::int_vector<> &seq,
+    uint8_t width = 0
+) {
+  uint64_t n0 = 0, n1 = 0, max_sym = 0;
+  for (uint64_t i = 0; i < D.size(); ++i) {
+    const bool new0 = i == 0 || D[i][order[0]] != D[i - 1][order[0]];
+    if (new0 || D[i][order[1]] != D[i - 1][order[1]]) {
+      max_sym = std::max<uint64_t>(max_sym, D[i][order[1]]);
+      ++n1;
+    }
+    if (full) {
+      max_sym = std::max<uint64_t>(max_sym, D[i][order[2]]);
+      if (new0) {
+        max_sym = std::max<uint64_t>(max_sym, D[i][order[0]]);
+        ++n0;
+      }
+    }
+  }
+  const uint64_t n = full ? n0 + n1 + D.size() : n1;
+  bv = sdsl::bit_vector(n + 1, !run_bit);
+  if (width == 0) {
+    width = max_sym ? sdsl::bits::hi(max_sym) + 1 : 1;
+  }
+  seq = sdsl::int_vector<>(n + 1, 0, width); // seq[n] = 0 is the mock
+  uint64_t p0 = 0, p1 = full ? n0 : 0, p2 = n0 + n1;
+  bv[0] = run_bit;
+  for (uint64_t i = 0; i < D.size(); ++i) {
+    const bool new0 = i == 0 || D[i][order[0]] != D[i - 1][order[0]];
+    const bool new1 = new0 || D[i][order[1]] != D[i - 1][order[1]];
+    if (new0) {
+      if (full) {
+        seq[p0++] = D[i][order[0]];
+      }
+      bv[p1] = run_bit;
+    }
+    if (new1) {
+      seq[p1++] = D[i][order[1]];
+      if (full) {
+        bv[p2] = run_bit;
+      }
+    }
+    if (full) {
+      seq[p2++] = D[i][order[2]];
+    }
+  }
+  bv[n] = run_bit;
+}
+
 } // namespace helper
 } // namespace cltj
 #endif // CLTJ_HELPER_HPP
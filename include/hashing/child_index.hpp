@@ -0,0 +1,184 @@
+#pragma once
+#include "mphf_bdz.hpp"
+#include "storage/baseline.hpp"
+#include <cstdint>
+#include <sdsl/int_vector.hpp>
+#include <sdsl/structure_tree.hpp>
+#include <sdsl/util.hpp>
+#include <vector>
+
+namespace cltj {
+namespace hashing {
+
+/**
+ * @brief Side index of a trie that maps (node, symbol) to the position of the
+ * child in O(1), for the nodes whose degree is at least a threshold.
+ *
+ * The children of a node are a sorted range of the sequence of the trie, and
+ * the ranges are delimited by the zeros of its bitvector (layout of
+ * cltj::compact_trie). A node is identified by the position of its last
+ * child, which is the end of every seek on its range. The keys
+ * (last, symbol) are mixed and mapped to [0, n) with the MPHF, which stores
+ * the distance from each child to the last one. The fingerprints discard most
+ * of the symbols that are not children, and the position is verified against
+ * the sequence, so a lookup never returns a wrong position.
+ */
+template <typename StorageStrategy = BaselineStorage>
+class ChildIndex {
+  public:
+    using size_type = size_t;
+
+    static constexpr uint32_t DEFAULT_MIN_DEGREE = 256;
+    static constexpr uint64_t NOT_FOUND = -1ULL;
+    // Seeds of the keys tried when the MPHF cannot be built
+    static constexpr uint32_t MAX_SEEDS = 4;
+
+  private:
+    MPHF<StorageStrategy, policies::WithFingerprints> mphf_;
+    sdsl::int_vector<> distances_;  // Distance from each child to the last one
+    uint32_t min_degree_;
+    uint64_t nodes_;  // Number of indexed nodes
+    uint64_t seed_;   // Seed of the keys of the MPHF
+
+    // Bijective mixer of splitmix64
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    /**
+     * @brief Key of a child: positions and symbols are full 64-bit words, so
+     * the position of the node (and the seed) is mixed first and then the
+     * symbol is added and mixed again. The keys of the children of a node
+     * never collide, and the mixer spreads their structure (consecutive
+     * symbols of the same node), which the linear hash functions of BDZ do
+     * not. The seed changes the keys when the MPHF cannot be built with them.
+     */
+    static uint64_t key(uint64_t last, uint64_t symbol, uint64_t seed) {
+        return mix(mix(last + seed * 0x9E3779B97F4A7C15ULL) + symbol);
+    }
+
+  public:
+    ChildIndex() : min_degree_(DEFAULT_MIN_DEGREE), nodes_(0), seed_(0) {}
+
+    // Not copyable nor movable, like the MPHF
+    ChildIndex(const ChildIndex&) = delete;
+    ChildIndex& operator=(const ChildIndex&) = delete;
+    ChildIndex(ChildIndex&&) = delete;
+    ChildIndex& operator=(ChildIndex&&) = delete;
+
+    /**
+     * @brief Build the index over the nodes with at least min_degree children
+     * @param bv Bitvector of the trie (a zero before the children of each node)
+     * @param seq Sequence of symbols of the trie
+     * @param min_degree Minimum number of children of an indexed node
+     * @return true if successful, false if the MPHF could not be built with
+     * any of the seeds (then no node is indexed)
+     */
+    template <typename BitVector, typename Sequence>
+    bool build(const BitVector& bv, const Sequence& seq, uint32_t min_degree = DEFAULT_MIN_DEGREE) {
+        min_degree_ = min_degree;
+        nodes_ = 0;
+        std::vector<uint64_t> lasts;
+        std::vector<uint64_t> distances;
+        uint64_t beg = 0;
+        for (uint64_t z = 1; z < bv.size(); ++z) {
+            if (bv[z])
+                continue;
+            // Children of the node are seq[beg..z-1]
+            if (z - beg >= min_degree_) {
+                ++nodes_;
+                for (uint64_t p = beg; p < z; ++p) {
+                    lasts.push_back(z - 1);
+                    distances.push_back(z - 1 - p);
+                }
+            }
+            beg = z;
+        }
+        distances_ = sdsl::int_vector<>(lasts.size());
+        if (lasts.empty()) {
+            return true;
+        }
+        std::vector<uint64_t> keys(lasts.size());
+        bool built = false;
+        for (seed_ = 0; seed_ < MAX_SEEDS && !built; ++seed_) {
+            for (size_t i = 0; i < keys.size(); ++i) {
+                keys[i] = key(lasts[i], seq[lasts[i] - distances[i]], seed_);
+            }
+            built = mphf_.build(keys);
+        }
+        --seed_;
+        if (!built) {
+            nodes_ = 0;
+            distances_ = sdsl::int_vector<>();
+            return false;
+        }
+        for (size_t i = 0; i < keys.size(); ++i) {
+            distances_[mphf_.query(keys[i])] = distances[i];
+        }
+        sdsl::util::bit_compress(distances_);
+        return true;
+    }
+
+    /**
+     * @brief Position of a symbol among the children in [first, last]
+     * @param seq Sequence of symbols of the trie
+     * @param symbol Symbol to find
+     * @param first First position of the range
+     * @param last Position of the last child of the node
+     * @return Position of the symbol, or NOT_FOUND if it is not in the range
+     * (or the node is not indexed)
+     */
+    template <typename Sequence>
+    uint64_t find(const Sequence& seq, uint64_t symbol, uint64_t first, uint64_t last) const {
+        if (nodes_ == 0)
+            return NOT_FOUND;
+        const uint32_t idx = mphf_.lookup(key(last, symbol, seed_));
+        if (idx >= mphf_.n())
+            return NOT_FOUND;
+        const uint64_t distance = distances_[idx];
+        if (distance > last - first)
+            return NOT_FOUND;
+        const uint64_t pos = last - distance;
+        return (seq[pos] == symbol) ? pos : NOT_FOUND;
+    }
+
+    // Whether a node with that number of children is indexed
+    bool covers(uint64_t degree) const { return nodes_ > 0 && degree >= min_degree_; }
+
+    uint32_t min_degree() const { return min_degree_; }
+    uint64_t nodes() const { return nodes_; }
+    uint64_t seed() const { return seed_; }
+    uint64_t keys() const { return distances_.size(); }
+    const MPHF<StorageStrategy, policies::WithFingerprints>& mphf() const { return mphf_; }
+
+    size_t size_in_bytes() const { return mphf_.size_in_bytes() + sdsl::size_in_bytes(distances_); }
+
+    size_t serialize(std::ostream& out, sdsl::structure_tree_node* v = nullptr, std::string name = "") const {
+        sdsl::structure_tree_node* child =
+            sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+        size_t written_bytes = 0;
+        written_bytes += mphf_.serialize(out, child, "mphf_");
+        written_bytes += distances_.serialize(out, child, "distances_");
+        written_bytes += sdsl::write_member(min_degree_, out, child, "min_degree_");
+        written_bytes += sdsl::write_member(nodes_, out, child, "nodes_");
+        written_bytes += sdsl::write_member(seed_, out, child, "seed_");
+        sdsl::structure_tree::add_size(child, written_bytes);
+        return written_bytes;
+    }
+
+    void load(std::istream& in) {
+        mphf_.load(in);
+        distances_.load(in);
+        sdsl::read_member(min_degree_, in);
+        sdsl::read_member(nodes_, in);
+        sdsl::read_member(seed_, in);
+    }
+};
+
+}  // namespace hashing
+}  // namespace cltj
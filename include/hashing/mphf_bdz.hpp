@@ -178,7 +178,7 @@ class MPHF {
         // Core data structures (essential for queries)
         written_bytes += storage_.serialize(out, child, "storage_");
         if constexpr (FingerprintPolicy::enabled) {
-            written_bytes += sdsl::write_member(Q_, out, child, "Q_");
+            written_bytes += Q_.serialize(out, child, "Q_");
         }
         written_bytes += sdsl::write_member(m_, out, child, "m_");
         written_bytes += sdsl::write_member(n_, out, child, "n_");
@@ -203,7 +203,7 @@ class MPHF {
         // Core data structures
         storage_.load(in);
         if constexpr (FingerprintPolicy::enabled) {
-            sdsl::read_member(Q_, in);
+            Q_.load(in);
         }
         sdsl::read_member(m_, in);
         sdsl::read_member(n_, in);
@@ -226,12 +226,7 @@ class MPHF {
      */
     bool contains(uint64_t key) const {
         if constexpr (FingerprintPolicy::enabled) {
-            if (n_ == 0)
-                return false;
-            uint32_t idx = query(key);
-            if (idx >= n_)
-                return false;
-            return Q_[idx] == fingerprint(key);
+            return lookup(key) < n_;
         } else {
             static_assert(
                 FingerprintPolicy::enabled,
@@ -242,6 +237,28 @@ class MPHF {
         }
     }
 
+    /**
+     * @brief Query the MPHF for a key that may not be in the set.
+     * Keys whose fingerprint does not match are rejected, so it can have
+     * false positives, but no false negatives.
+     * @param key The key to query.
+     * @return Hash value in range [0, n) if the key is likely in the set, n
+     * otherwise.
+     */
+    uint32_t lookup(uint64_t key) const {
+        static_assert(
+            FingerprintPolicy::enabled,
+            "lookup() requires WithFingerprints policy. "
+            "Use MPHF<policies::WithFingerprints>"
+        );
+        if (n_ == 0)
+            return n_;
+        uint32_t idx = query(key);
+        if (idx >= n_ || Q_[idx] != fingerprint(key))
+            return n_;
+        return idx;
+    }
+
     /**
      * @brief Single attempt to build MPHF
      * Algorithm:
@@ -67,7 +67,7 @@ class BaselineStorage : public StorageStrategy<BaselineStorage> {
         sdsl::structure_tree_node* child =
             sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
         size_t written_bytes = 0;
-        written_bytes += sdsl::write_member(G_, out, child, "G_");
+        written_bytes += G_.serialize(out, child, "G_");
         written_bytes += used_positions_.serialize(out, child, "used_positions_");
         written_bytes += rank_support_.serialize(out, child, "rank_support_");
         sdsl::structure_tree::add_size(child, written_bytes);
@@ -75,7 +75,7 @@ class BaselineStorage : public StorageStrategy<BaselineStorage> {
     }
 
     void load(std::istream& in) {
-        sdsl::read_member(G_, in);
+        G_.load(in);
         used_positions_.load(in);
         rank_support_.load(in);
         rank_support_.set_vector(&used_positions_);
@@ -6,6 +6,7 @@
 #define CLTJ_INDEX_METATRIE_DYN_HPP
 
 #include <cltj_config.hpp>
+#include <cltj_helper.hpp>
 #include <metatrie/cltj_compact_metatrie_dyn.hpp>
 
 namespace cltj {
@@ -46,150 +47,21 @@ private:
   }
 
   trie_type create_full_trie(vector<spo_triple> &D, uint8_t order) {
-
     std::sort(D.begin(), D.end(), comparator_order(order));
-
-    uint64_t c0 = 1, cur_value = D[0][spo_orders[order][0]];
-    std::vector<uint64_t> v0;
-    std::vector<uint64_t> seq;
-
-    for (uint64_t i = 1; i < D.size(); i++) {
-      if (D[i][spo_orders[order][0]] != D[i - 1][spo_orders[order][0]]) {
-        seq.push_back(cur_value);
-        cur_value = D[i][spo_orders[order][0]];
-        v0.push_back(c0);
-        c0 = 1;
-      } else
-        c0++;
-    }
-    seq.push_back(cur_value);
-    v0.push_back(c0);
-
-    uint64_t c1, c2;
-    std::vector<uint64_t> v1, v2;
-
-    for (uint64_t i = 0, k = 0; i < v0.size(); i++) {
-      c1 = 1;
-      c2 = 1;
-      for (uint64_t j = 1; j < v0[i]; j++) {
-        k++;
-        if (D[k][spo_orders[order][1]] != D[k - 1][spo_orders[order][1]]) {
-          v2.push_back(c2);
-          seq.push_back(D[k - 1][spo_orders[order][1]]);
-          c2 = 1;
-          c1++;
-        } else
-          c2++;
-      }
-      seq.push_back(D[k][spo_orders[order][1]]);
-      v2.push_back(c2);
-      v1.push_back(c1);
-      k++;
-    }
-    uint64_t c = v0.size() + 1;
-
-    for (uint64_t i = 0; i < v1.size(); i++)
-      c += v1[i];
-
-    for (uint64_t i = 0; i < v2.size(); i++)
-      c += v2[i];
-
-    sdsl::bit_vector bv = sdsl::bit_vector(c, 0);
-    sdsl::int_vector<> seq_compact =
-        sdsl::int_vector<>(seq.size() + D.size() + 1);
-
-    uint64_t j = 0;
-
-    bv[0] = 1;
-    bv[v0.size()] = 1;
-    j = v0.size();
-
-    for (uint64_t i = 0; i < v1.size(); i++) {
-      j += v1[i];
-      bv[j] = 1;
-    }
-
-    for (uint64_t i = 0; i < v2.size(); i++) {
-      j += v2[i];
-      bv[j] = 1;
-    }
-
-    for (j = 0; j < seq.size(); j++)
-      seq_compact[j] = seq[j];
-
-    for (uint64_t i = 0; i < D.size(); i++)
-      seq_compact[j++] = D[i][spo_orders[order][2]];
-    seq_compact[j] = 0; // mock
-
-    /*            cout << "*** Trie para el orden " << (uint64_t)order << " ***"
-       << endl; for (uint64_t i = 0; i < bv.size(); i++) { cout << bv[i];
-                }
-                cout << endl;
-                for (uint64_t i = 0; i < seq_compact.size(); i++) {
-                    cout << seq_compact[i] << " ";
-                }
-                cout << endl;
-    */
-    return trie_type(seq_compact, bv);
+    sdsl::bit_vector bv;
+    sdsl::int_vector<> seq;
+    // dyn_louds reads the words of seq, so it keeps 64 bits per symbol
+    helper::metatrie_levels(D, spo_orders[order], true, true, bv, seq, 64);
+    return trie_type(seq, bv);
   }
 
   trie_type create_partial_trie(vector<spo_triple> &D, uint8_t order) {
-
     std::sort(D.begin(), D.end(), comparator_order(order));
-
-    uint64_t c0 = 1;
-    std::vector<uint64_t> v0;
-    std::vector<uint64_t> seq;
-
-    for (uint64_t i = 1; i < D.size(); i++) {
-      if (D[i][spo_orders[order][0]] != D[i - 1][spo_orders[order][0]]) {
-        v0.push_back(c0);
-        c0 = 1;
-      } else
-        c0++;
-    }
-    v0.push_back(c0);
-
-    uint64_t c1, c2;
-    std::vector<uint64_t> v1, v2;
-
-    for (uint64_t i = 0, k = 0; i < v0.size(); i++) {
-      c1 = 1;
-      c2 = 1;
-      for (uint64_t j = 1; j < v0[i]; j++) {
-        k++;
-        if (D[k][spo_orders[order][1]] != D[k - 1][spo_orders[order][1]]) {
-          v2.push_back(c2);
-          seq.push_back(D[k - 1][spo_orders[order][1]]);
-          c2 = 1;
-          c1++;
-        } else
-          c2++;
-      }
-      seq.push_back(D[k][spo_orders[order][1]]);
-      v2.push_back(c2);
-      v1.push_back(c1);
-      k++;
-    }
-
-    uint64_t c = 0;
-    for (uint64_t i = 0; i < v1.size(); i++)
-      c += v1[i];
-
-    sdsl::bit_vector bv = sdsl::bit_vector(c + 1, 0);
-    sdsl::int_vector<> seq_compact = sdsl::int_vector<>(seq.size() + 1);
-
-    bv[0] = 1;
-    uint64_t j = 1;
-    for (uint64_t i = 0; i < v1.size(); i++) {
-      j += v1[i];
-      bv[j - 1] = 1;
-    }
-
-    for (j = 0; j < seq.size(); j++)
-      seq_compact[j] = seq[j];
-    seq_compact[seq.size()] = 0; // mock
-    return trie_type(seq_compact, bv);
+    sdsl::bit_vector bv;
+    sdsl::int_vector<> seq;
+    // dyn_louds reads the words of seq, so it keeps 64 bits per symbol
+    helper::metatrie_levels(D, spo_orders[order], false, true, bv, seq, 64);
+    return trie_type(seq, bv);
   }
 
   void copy(const cltj_index_metatrie_dyn &o) {
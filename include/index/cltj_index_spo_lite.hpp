@@ -8,8 +8,13 @@
 #include <cltj_config.hpp>
 #include <cltj_helper.hpp>
 #include <trie/cltj_compact_trie.hpp>
+#include <trie/cltj_compact_trie_ef.hpp>
+#include <trie/cltj_compact_trie_interleaved.hpp>
 #include <trie/cltj_compact_trie_stats.hpp>
 #include <trie/cltj_uncompact_trie.hpp>
+#if __cplusplus >= 201703L
+#include <trie/cltj_compact_trie_hashed.hpp>
+#endif
 
 namespace cltj {
 
@@ -17,7 +22,7 @@ template <class Trie> class cltj_index_spo_lite {
 
 public:
   typedef uint64_t size_type;
-  typedef uint32_t value_type;
+  typedef typename Trie::value_type value_type;
   typedef Trie trie_type;
 
 private:
@@ -34,11 +39,12 @@ public:
   const std::array<size_type, 3> &gaps = m_gaps;
   cltj_index_spo_lite() = default;
 
-  cltj_index_spo_lite(vector<spo_triple> &D) {
+  //! From the triples D, with IDs of type t_id
+  template <class t_id> cltj_index_spo_lite(vector<spo_triple_t<t_id>> &D) {
 
     for (size_type i = 0; i < 6; ++i) {
       std::sort(D.begin(), D.end(), comparator_order(i));
-      std::vector<uint32_t> syms;
+      std::vector<t_id> syms;
       std::vector<size_type> lengths;
       helper::sym_level(D, spo_orders[i], i % 2, syms, lengths);
       if (i % 2 == 0) {
@@ -48,6 +54,15 @@ public:
     }
   }
 
+  //! From an index with another trie type (the tries are converted)
+  template <class OtherTrie>
+  explicit cltj_index_spo_lite(const cltj_index_spo_lite<OtherTrie> &o) {
+    for (size_type i = 0; i < 6; ++i) {
+      m_tries[i] = trie_type(o.tries[i]);
+    }
+    m_gaps = o.gaps;
+  }
+
   //! Copy constructor
   cltj_index_spo_lite(const cltj_index_spo_lite &o) {
     copy(o);
@@ -134,6 +149,17 @@ public:
 typedef cltj::cltj_index_spo_lite<cltj::compact_trie> compact_ltj;
 typedef cltj::cltj_index_spo_lite<cltj::uncompact_trie> uncompact_ltj;
 typedef cltj::cltj_index_spo_lite<cltj::compact_trie_stats> compact_ltj_stats;
+typedef cltj::cltj_index_spo_lite<cltj::compact_trie_ef> compact_ltj_ef;
+typedef cltj::cltj_index_spo_lite<cltj::compact_trie_interleaved>
+    compact_ltj_interleaved;
+typedef cltj::cltj_index_spo_lite<cltj::compact_trie_rs> compact_ltj_rs;
+// IDs of 64 bits, from triples of spo_triple_t<uint64_t>
+typedef cltj::cltj_index_spo_lite<cltj::compact_trie_t<uint64_t>>
+    compact_ltj_64;
+#if __cplusplus >= 201703L
+// MPHF side index on the high-degree nodes (needs C++17)
+typedef cltj::cltj_index_spo_lite<cltj::compact_trie_hashed> compact_ltj_hashed;
+#endif
 
 } // namespace cltj
 
@@ -9,6 +9,7 @@
 #include <sdsl/select_support_mcl.hpp>
 #include <sdsl/vectors.hpp>
 #include <string>
+#include <util/prefetch.hpp>
 #include <vector>
 
 namespace cltj {
@@ -18,6 +19,7 @@ class compact_metatrie {
 public:
   typedef uint64_t size_type;
   typedef uint32_t value_type;
+  typedef sdsl::int_vector<> seq_type;
 
 private:
   sdsl::bit_vector m_bv;
@@ -114,7 +116,7 @@ public:
       Receives index of current node and the child that is required
       Returns index of the nth child of current node
   */
-  inline size_type child(uint32_t it, uint32_t n) const {
+  inline size_type child(size_type it, size_type n) const {
     return m_select0(it + 1 + n);
   }
 
@@ -134,11 +136,11 @@ public:
     return m_select0(i + 2);
   }
 
-  pair<uint32_t, uint32_t>
-  binary_search_seek(uint32_t val, uint32_t i, uint32_t f) const {
+  pair<value_type, size_type>
+  binary_search_seek(value_type val, size_type i, size_type f) const {
     if (m_seq[f] < val)
       return make_pair(0, f + 1);
-    uint32_t mid;
+    size_type mid;
     while (i < f) {
       mid = (i + f) / 2;
       if (m_seq[mid] < val) {
@@ -150,6 +152,39 @@ public:
     return make_pair(m_seq[i], i);
   }
 
+  /*
+      Same result as binary_search_seek, but the search gallops from i
+      (1, 2, 4... positions ahead) before bisecting. Successive seeks in
+      leapfrog are usually close to the previous position, so this costs
+      O(log d) accesses, where d is the distance from i to the result.
+  */
+  pair<value_type, size_type>
+  gallop_seek(value_type val, size_type i, size_type f) const {
+    size_type hi = i, step = 1;
+    while (m_seq[hi] < val) {
+      if (hi == f)
+        return make_pair(0, f + 1);
+      i = hi + 1;
+      hi = (f - hi > step) ? hi + step : f;
+      step <<= 1;
+    }
+    size_type mid;
+    while (i < hi) {
+      mid = (i + hi) / 2;
+      if (m_seq[mid] < val) {
+        i = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return make_pair(m_seq[i], i);
+  }
+
+  // Prefetches the first positions that gallop_seek(val, i, f) probes
+  inline void prefetch_gallop(size_type i, size_type f) const {
+    ::util::prefetch_gallop(m_seq, i, f);
+  }
+
   void print() const {
     for (size_type i = 0; i < m_bv.size(); ++i) {
       std::cout << (uint)m_bv[i];
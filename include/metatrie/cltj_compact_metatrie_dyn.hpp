@@ -17,6 +17,7 @@ template <uint default_width = 32> class compact_metatrie_dyn {
 public:
   typedef uint64_t size_type;
   typedef uint32_t value_type;
+  typedef dyn_cds::dyn_louds seq_type;
 
 private:
   dyn_cds::dyn_louds m_seq;
@@ -106,7 +107,7 @@ public:
     m_seq.remove(node_pos, more);
   }
 
-  inline size_type child(uint32_t it, uint32_t n, uint32_t gap = 1) const {
+  inline size_type child(size_type it, size_type n, size_type gap = 1) const {
     return m_seq.select(it + gap + n);
   }
 
@@ -133,16 +134,28 @@ public:
     return m_seq.next(i, j, val);
   }
 
-  std::pair<uint32_t, uint64_t>
-  binary_search_seek(uint32_t val, uint32_t i, uint32_t f) const {
+  std::pair<value_type, size_type>
+  binary_search_seek(value_type val, size_type i, size_type f) const {
+    return m_seq.next(i, f, val);
+  }
+
+  /*
+      The dynamic sequence already searches forward from the block of i, and
+      a random access costs a tree descent, so galloping is left to next().
+  */
+  std::pair<value_type, size_type>
+  gallop_seek(value_type val, size_type i, size_type f) const {
     return m_seq.next(i, f, val);
   }
 
-  pair<uint32_t, uint32_t>
-  binary_search(uint32_t val, uint32_t i, uint32_t f) const {
+  // A random access costs a tree descent, so there is nothing to prefetch
+  inline void prefetch_gallop(size_type, size_type) const {}
+
+  pair<value_type, size_type>
+  binary_search(value_type val, size_type i, size_type f) const {
     if (m_seq[f] < val)
       return make_pair(0, f + 1);
-    uint32_t mid;
+    size_type mid;
     while (i < f) {
       mid = (i + f) / 2;
       if (m_seq[mid] < val) {
@@ -23,23 +23,38 @@
 #include <triple_pattern.hpp>
 // #include <ltj_iterator.hpp>
 #include <dict/dict_map.hpp>
-#include <query/alternation_complexity.hpp>
-#include <query/intersection_stats.hpp>
 #include <query/ltj_iterator_basic.hpp>
 #include <query/ltj_iterator_lite.hpp>
+#include <query/ltj_cache.hpp>
+#include <query/ltj_continuation.hpp>
+#include <query/ltj_filter.hpp>
 #include <query/ltj_iterator_metatrie.hpp>
+#include <query/ltj_join_tree.hpp>
+#include <query/ltj_plan.hpp>
+#include <query/stats_policy.hpp>
 #include <results/results.hpp>
+#include <util/deadline.hpp>
 #include <util/rdf_util.hpp>
+#include <util/work_stealing_pool.hpp>
 #include <veo/veo_adaptive.hpp>
 #include <veo/veo_simple.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
 #define EXPT_TIME_SOL 0
 
 namespace ltj {
 
 template <
     class iterator_t = ltj_iterator_lite<cltj::compact_ltj, uint8_t, uint64_t>,
-    class veo_t = veo::veo_adaptive<iterator_t, util::trait_size>>
+    class veo_t = veo::veo_adaptive<iterator_t, util::trait_size>,
+    class stats_t = stats::stats_none>
 class ltj_algorithm {
 
 public:
@@ -50,21 +65,189 @@ public:
   typedef typename ltj_iter_type::index_scheme_type index_scheme_type;
   typedef typename ltj_iter_type::value_type const_type;
   typedef veo_t veo_type;
+  typedef stats_t stats_type;
+  typedef ltj_plan<var_type> plan_type;
   typedef unordered_map<var_type, vector<ltj_iter_type *>>
       var_to_iterators_type;
   typedef vector<pair<var_type, const_type>> tuple_type;
   typedef vector<std::string> tuple_str_type;
+  typedef typename ltj_iter_type::range_type range_type;
+  typedef vector<pair<var_type, range_type>> factors_type;
+  typedef ::util::results_factorized<var_type, const_type, range_type>
+      results_factorized_type;
+  typedef ltj_continuation<var_type, const_type> continuation_type;
+  typedef ltj_filter<const_type> filter_type;
+  typedef ltj_cache<var_type, const_type> cache_type;
+  typedef ltj_join_tree<var_type> join_tree_type;
   typedef chrono::high_resolution_clock::time_point time_point_type;
   // typedef ::util::results_collector<tuple_type> results_type;
 
+  typedef struct {
+    tuple_type prefix; // Bindings of the variables before the split level
+    value_type lo;     // First candidate of the split level
+    value_type hi;     // Last candidate of the split level (inclusive)
+  } parallel_task_type;
+  typedef ::util::work_stealing_pool<parallel_task_type> pool_type;
+
+  // Tasks created per thread when splitting the first variable
+  static constexpr size_type parallel_tasks_per_thread = 8;
+  // Minimum number of candidates of a level to be split among workers
+  static constexpr size_type parallel_split_size = 64;
+  // Results buffered by a worker before merging them into the shared results
+  static constexpr size_type parallel_flush_size = 1024;
+  // Ratio between the largest and the smallest list of an intersection
+  // from which the smallest one drives it and the others only probe
+  static constexpr size_type seek_skew_ratio = 32;
+  // Entries of the cache of suffixes and maximum solutions of a cached suffix
+  static constexpr size_type default_cache_capacity = 4096;
+  static constexpr size_type default_cache_list_size = 256;
+  // Maximum size of a candidate set of the semi-join reduction
+  static constexpr size_type default_semijoin_candidates = 1 << 16;
+
+  template <class results_type> struct parallel_context_type {
+    pool_type *pool;
+    results_type *res;
+    std::mutex res_mutex;
+    std::atomic<size_type> n_results{0};
+    std::vector<std::vector<tuple_type>> buffers;
+    ::util::deadline *deadline;
+    size_type limit_results;
+    std::atomic<bool> replay_failed{false}; // See search_task
+  };
+
 private:
   const vector<triple_pattern> *m_ptr_triple_patterns;
   veo_type m_veo;
   index_scheme_type *m_ptr_ring;
   vector<ltj_iter_type> m_iterators;
   var_to_iterators_type m_var_to_iterators;
+  plan_type m_plan;
+  vector<vector<ltj_iter_type *>> m_var_iterators; // Iterators by variable
+  vector<vector<state_type>> m_var_states; // Position in each iterator
+  vector<filter_type> m_filters;            // Filters by variable
+  vector<bool> m_var_filtered;
+  // Intersections of each variable driven by its smallest list (see seek)
+  vector<bool> m_var_skewed;
+  vector<size_type> m_seek_sizes; // Children of each list of an intersection
+  cache_type m_cache; // Suffix results (disabled by default)
   bool m_is_empty = false;
-  std::vector<IntersectionStats> m_stats;
+  stats_type m_stats;
+  // Connected components of the query (empty if it is connected)
+  vector<vector<triple_pattern>> m_components;
+  vector<std::unique_ptr<ltj_algorithm>> m_component_algorithms;
+
+  // Frame of the explicit stack of the cursor (see next())
+  struct cursor_frame_type {
+    var_type var;
+    bool lonely;      // Its candidates are the range of a single iterator
+    range_type range; // Candidates of a lonely variable
+    size_type pos;    // Next candidate in range
+    value_type c;     // Current binding (0 before the first one)
+    bool bound;       // The iterators went down with c
+  };
+  vector<cursor_frame_type> m_cursor_frames; // One per level of the VEO
+  tuple_type m_cursor_tuple;
+  bool m_cursor_started = false;
+  bool m_cursor_finished = false;
+
+  struct tuple_buffer_type {
+    vector<tuple_type> tuples;
+    inline void add(const tuple_type &t) {
+      tuples.push_back(t);
+    }
+    inline size_type size() const {
+      return tuples.size();
+    }
+  };
+
+  // Adapts a functor to the interface of the results (add and size)
+  template <class Emit> struct emit_results_type {
+    Emit &emit;
+    size_type n = 0;
+    explicit emit_results_type(Emit &e) : emit(e) {
+    }
+    inline void add(const tuple_type &t) {
+      emit(t);
+      ++n;
+    }
+    inline size_type size() const {
+      return n;
+    }
+  };
+
+  // Best k solutions by the value of a variable (0 = all of them)
+  struct top_k_type {
+    struct entry_type {
+      const_type key;
+      size_type seq; // Order of arrival, to break ties
+      tuple_type tuple;
+    };
+    var_type var;
+    size_type k;
+    bool descending;
+    size_type n = 0;
+    vector<entry_type> heap; // The worst entry is at the top
+
+    top_k_type(const var_type v, const size_type k_, const bool desc)
+        : var(v), k(k_), descending(desc) {
+    }
+
+    // True if a goes before b in the output
+    inline bool before(const entry_type &a, const entry_type &b) const {
+      if (a.key != b.key)
+        return descending ? a.key > b.key : a.key < b.key;
+      return a.seq < b.seq;
+    }
+
+    void add(const tuple_type &t) {
+      const_type key = 0;
+      for (const auto &b : t) {
+        if (b.first == var) {
+          key = b.second;
+          break;
+        }
+      }
+      auto cmp = [this](const entry_type &a, const entry_type &b) {
+        return before(a, b);
+      };
+      entry_type e{key, n++, t};
+      if (k == 0 || heap.size() < k) {
+        heap.push_back(std::move(e));
+        std::push_heap(heap.begin(), heap.end(), cmp);
+      } else if (before(e, heap.front())) {
+        std::pop_heap(heap.begin(), heap.end(), cmp);
+        heap.back() = std::move(e);
+        std::push_heap(heap.begin(), heap.end(), cmp);
+      }
+    }
+
+    inline size_type size() const {
+      return heap.size();
+    }
+
+    template <class Results> void report(Results &res) {
+      auto cmp = [this](const entry_type &a, const entry_type &b) {
+        return before(a, b);
+      };
+      std::sort_heap(heap.begin(), heap.end(), cmp);
+      for (const auto &e : heap) {
+        res.add(e.tuple);
+      }
+      heap.clear();
+    }
+  };
+
+  // Restores the priority of the VEO when the search that changed it ends
+  struct priority_guard_type {
+    veo_type &veo;
+    typename veo_type::priority_type priority;
+    explicit priority_guard_type(veo_type &v)
+        : veo(v), priority(v.get_priority()) {
+    }
+    ~priority_guard_type() {
+      veo.set_priority(priority);
+    }
+  };
 
   void copy(const ltj_algorithm &o) {
     m_ptr_triple_patterns = o.m_ptr_triple_patterns;
@@ -72,8 +255,193 @@ private:
     m_ptr_ring = o.m_ptr_ring;
     m_iterators = o.m_iterators;
     m_var_to_iterators = o.m_var_to_iterators;
+    m_plan = o.m_plan;
+    m_var_iterators = o.m_var_iterators;
+    m_var_states = o.m_var_states;
+    m_filters = o.m_filters;
+    m_var_filtered = o.m_var_filtered;
+    m_var_skewed = o.m_var_skewed;
+    m_seek_sizes = o.m_seek_sizes;
+    m_cache = o.m_cache;
     m_is_empty = o.m_is_empty;
     m_stats = o.m_stats;
+    m_cursor_frames = o.m_cursor_frames;
+    m_cursor_tuple = o.m_cursor_tuple;
+    m_cursor_started = o.m_cursor_started;
+    m_cursor_finished = o.m_cursor_finished;
+    // The tables of iterators and the filters of the iterators point to o
+    const ltj_iter_type *base = o.m_iterators.data();
+    for (auto &e : m_var_to_iterators) {
+      for (auto &it : e.second) {
+        it = &m_iterators[it - base];
+      }
+    }
+    for (auto &itrs : m_var_iterators) {
+      for (auto &it : itrs) {
+        it = &m_iterators[it - base];
+      }
+    }
+    m_veo.rebind(base, &m_iterators, &m_var_to_iterators);
+    for (size_type var = 0; var < m_var_filtered.size(); ++var) {
+      if (!m_var_filtered[var])
+        continue;
+      for (size_type i = 0; i < m_var_iterators[var].size(); ++i) {
+        m_var_iterators[var][i]->filter(m_var_states[var][i], &m_filters[var]);
+      }
+    }
+    m_components.clear();
+    m_component_algorithms.clear();
+    if (!m_is_empty) {
+      decompose();
+      for (auto &component : m_component_algorithms) {
+        for (size_type var = 0; var < m_var_filtered.size(); ++var) {
+          if (m_var_filtered[var])
+            component->filter(var, m_filters[var]);
+        }
+      }
+    }
+  }
+
+  /*
+      Splits the triple patterns into the connected components of the graph
+      of shared variables. When there is more than one, each component is
+      solved once by its own ltj_algorithm and the results are their product
+  */
+  void decompose() {
+    const vector<triple_pattern> &patterns = *m_ptr_triple_patterns;
+    vector<size_type> parent(patterns.size());
+    for (size_type i = 0; i < patterns.size(); ++i) {
+      parent[i] = i;
+    }
+    auto find = [&parent](size_type i) {
+      while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+      }
+      return i;
+    };
+    for (size_type var = 0; var < m_plan.size(); ++var) {
+      const auto &occs = m_plan.occurrences(var);
+      for (size_type k = 1; k < occs.size(); ++k) {
+        parent[find(occs[k].pattern)] = find(occs[0].pattern);
+      }
+    }
+
+    // Patterns without variables were already checked by their iterators
+    vector<size_type> comp_of_root(patterns.size(), -1ULL);
+    vector<vector<triple_pattern>> components;
+    for (size_type i = 0; i < patterns.size(); ++i) {
+      const triple_pattern &triple = patterns[i];
+      if (!triple.s_is_variable() && !triple.p_is_variable() &&
+          !triple.o_is_variable())
+        continue;
+      const size_type root = find(i);
+      if (comp_of_root[root] == -1ULL) {
+        comp_of_root[root] = components.size();
+        components.emplace_back();
+      }
+      components[comp_of_root[root]].push_back(triple);
+    }
+    if (components.size() <= 1)
+      return;
+
+    m_components = std::move(components);
+    for (const auto &component : m_components) {
+      m_component_algorithms.emplace_back(
+          new ltj_algorithm(&component, m_ptr_ring)
+      );
+    }
+  }
+
+  // Adapts two functors to the interface of the results (add and size)
+  template <class Add, class Size> struct functor_results_type {
+    Add &add_f;
+    Size &size_f;
+    functor_results_type(Add &a, Size &s) : add_f(a), size_f(s) {
+    }
+    inline void add(const tuple_type &t) {
+      add_f(t);
+    }
+    inline size_type size() const {
+      return size_f();
+    }
+  };
+
+  /**
+   * Reports the product of the results of the components. All of them but
+   * the first one are solved once and kept; the first one is enumerated by
+   * its own search, which stops with the limit, and each of its tuples is
+   * combined with the kept ones. With a limit, a kept component only stores
+   * the tuples needed for limit_results results given the sizes of the
+   * components after it.
+   *
+   * @param emit              Functor called as emit(tuple) for each result
+   * @param size              Functor that returns the number of results
+   * @param limit_results     Limit of results
+   * @param deadline          Deadline of the search
+   */
+  template <class Emit, class Size>
+  void join_components(
+      Emit emit,
+      Size size,
+      const size_type limit_results,
+      ::util::deadline &deadline
+  ) {
+    const size_type n = m_component_algorithms.size();
+    vector<tuple_buffer_type> partial(n);
+    size_type after = 1; // Product of the sizes of the components after k
+    for (size_type k = n - 1; k > 0; --k) {
+      size_type limit = 0;
+      if (limit_results > 0) {
+        limit = (after >= limit_results)
+                    ? 1
+                    : (limit_results + after - 1) / after;
+      }
+      m_component_algorithms[k]->join(partial[k], limit, deadline);
+      if (deadline.cancelled() || partial[k].size() == 0)
+        return;
+      if (limit_results > 0 && after < limit_results)
+        after *= partial[k].size();
+    }
+
+    // Enumerates the product (the last component changes first)
+    tuple_type t;
+    vector<size_type> pos(n, 0);
+    vector<size_type> offset(n + 1, 0);
+    auto product = [&](const tuple_type &t0) {
+      t.assign(t0.begin(), t0.end());
+      offset[1] = t0.size();
+      for (size_type k = 1; k < n; ++k) {
+        const tuple_type &tk = partial[k].tuples[0];
+        pos[k] = 0;
+        offset[k + 1] = offset[k] + tk.size();
+        t.insert(t.end(), tk.begin(), tk.end());
+      }
+      while (true) {
+        if (limit_results > 0 && size() == limit_results)
+          return;
+        if (deadline.expired())
+          return;
+        emit(t);
+        size_type k = n - 1;
+        while (++pos[k] == partial[k].size()) {
+          pos[k] = 0;
+          const tuple_type &tk = partial[k].tuples[0];
+          std::copy(tk.begin(), tk.end(), t.begin() + offset[k]);
+          if (--k == 0)
+            return;
+        }
+        const tuple_type &tk = partial[k].tuples[pos[k]];
+        std::copy(tk.begin(), tk.end(), t.begin() + offset[k]);
+      }
+    };
+    // Not through join, a component is never split again
+    ltj_algorithm &first = *m_component_algorithms[0];
+    if (first.m_is_empty)
+      return;
+    functor_results_type<decltype(product), Size> res(product, size);
+    tuple_type t0(first.m_veo.size());
+    first.search(0, t0, res, deadline, limit_results);
   }
 
   inline void
@@ -87,6 +455,245 @@ private:
     }
   }
 
+  /*
+      A lonely variable appears in a single iterator at its last level, so
+      its candidates are a range of the trie (seek_all) that does not need to
+      be intersected. A set filter cannot be applied to the range, so those
+      variables are sought one by one.
+  */
+  inline bool is_lonely(const var_type x_j) const {
+    const vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+    return itrs.size() == 1 && itrs[0]->in_last_level() &&
+           !(m_var_filtered[x_j] && m_filters[x_j].has_set());
+  }
+
+  /*
+      Undoes the binding of x_j when the search stops in the middle of its
+      level, so the iterators and the VEO are as before the call to next().
+  */
+  inline void stop_level(const var_type x_j) {
+    for (ltj_iter_type *iter : m_var_iterators[x_j]) {
+      iter->up(x_j);
+      iter->leap_done();
+    }
+    m_veo.up();
+    m_veo.done();
+  }
+
+  inline size_type min_children(const var_type x_j) const {
+    const vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+    const vector<state_type> &states = m_var_states[x_j];
+    size_type min = -1ULL;
+    for (size_type i = 0; i < itrs.size(); ++i) {
+      const size_type n = itrs[i]->children(states[i]);
+      if (n < min)
+        min = n;
+    }
+    return min;
+  }
+
+  template <class results_type>
+  static void
+  flush_results(parallel_context_type<results_type> &ctx, const size_type w) {
+    auto &buffer = ctx.buffers[w];
+    if (buffer.empty())
+      return;
+    std::lock_guard<std::mutex> lock(ctx.res_mutex);
+    for (const auto &t : buffer) {
+      ctx.res->add(t);
+    }
+    buffer.clear();
+  }
+
+  /*
+      Returns the other unbound variable in the triple pattern of iter when
+      it is lonely, so both can be counted with a single subtree size.
+      Otherwise, returns x_j.
+  */
+  var_type lonely_partner(
+      const ltj_iter_type *iter,
+      const var_type x_j,
+      const vector<bool> &bound
+  ) {
+    const triple_pattern &triple =
+        (*m_ptr_triple_patterns)[iter - m_iterators.data()];
+    const term_pattern *terms[3] = {
+        &triple.term_s, &triple.term_p, &triple.term_o
+    };
+    var_type partner = x_j;
+    size_type n_unbound = 0;
+    for (const term_pattern *term : terms) {
+      if (!term->is_variable)
+        continue;
+      const var_type var = (var_type)term->value;
+      if (bound[var])
+        continue;
+      ++n_unbound;
+      if (var != x_j)
+        partner = var;
+    }
+    if (n_unbound != 2 || m_var_iterators[partner].size() > 1)
+      return x_j;
+    return partner;
+  }
+
+  // Some binding of the variables from i on extends the current position
+  bool semijoin_extends(
+      ltj_iter_type &it,
+      const vector<pair<var_type, state_type>> &vars,
+      const size_type i
+  ) {
+    if (i == vars.size())
+      return true;
+    const state_type state = vars[i].second;
+    value_type c = it.leap(state);
+    bool found = (c != 0) && (i + 1 == vars.size());
+    while (c != 0 && !found) {
+      it.down(state, c);
+      found = semijoin_extends(it, vars, i + 1);
+      it.up(vars[i].first);
+      if (!found)
+        c = it.leap(state, c + 1);
+    }
+    it.leap_done();
+    return found;
+  }
+
+  // Values of the last variable below every binding of the previous ones
+  bool semijoin_collect(
+      ltj_iter_type &it,
+      const vector<pair<var_type, state_type>> &vars,
+      const size_type i,
+      const size_type max_values,
+      vector<const_type> &values
+  ) {
+    const state_type state = vars[i].second;
+    bool ok = true;
+    value_type c = it.leap(state);
+    while (c != 0) {
+      if (i + 1 == vars.size()) {
+        ok = values.size() < max_values;
+        if (ok)
+          values.push_back(c);
+      } else {
+        it.down(state, c);
+        ok = semijoin_collect(it, vars, i + 1, max_values, values);
+        it.up(vars[i].first);
+      }
+      if (!ok)
+        break;
+      c = it.leap(state, c + 1);
+    }
+    it.leap_done();
+    return ok;
+  }
+
+  /*
+      Values of var in the pattern e that can be extended to the rest of its
+      variables (with their filters), in increasing order. Returns false if
+      there are more than max_values or the pattern repeats a variable.
+  */
+  bool semijoin_project(
+      const size_type e,
+      const var_type var,
+      const size_type max_values,
+      vector<const_type> &values
+  ) {
+    const triple_pattern &triple = m_ptr_triple_patterns->at(e);
+    ltj_iter_type &it = m_iterators[e];
+    vector<pair<var_type, state_type>> vars = {{var, it.state_of(var)}};
+    const term_pattern *terms[3] = {
+        &triple.term_s, &triple.term_p, &triple.term_o
+    };
+    size_type n_var = 0;
+    for (const term_pattern *term : terms) {
+      if (!term->is_variable)
+        continue;
+      ++n_var;
+      const var_type u = (var_type)term->value;
+      if (u != var)
+        vars.emplace_back(u, it.state_of(u));
+    }
+    if (vars.size() != n_var)
+      return false;
+    // Driven by a smaller candidate set of another variable, the values of
+    // var are collected below each of its bindings and then sorted
+    size_type driver = 0, min_size = it.children(vars[0].second);
+    for (size_type i = 1; i < vars.size(); ++i) {
+      const filter_type &f = m_filters[vars[i].first];
+      if (m_var_filtered[vars[i].first] && f.has_set() &&
+          f.values().size() < min_size) {
+        driver = i;
+        min_size = f.values().size();
+      }
+    }
+    if (driver != 0) {
+      std::swap(vars[1], vars[driver]);
+      std::rotate(vars.begin(), vars.begin() + 1, vars.end());
+      if (!semijoin_collect(it, vars, 0, max_values, values))
+        return false;
+      std::sort(values.begin(), values.end());
+      values.erase(std::unique(values.begin(), values.end()), values.end());
+      return true;
+    }
+    const state_type state = vars[0].second;
+    value_type c = it.leap(state);
+    while (c != 0) {
+      it.down(state, c);
+      const bool ok = semijoin_extends(it, vars, 1);
+      it.up(var);
+      if (ok) {
+        if (values.size() == max_values) {
+          it.leap_done();
+          return false;
+        }
+        values.push_back(c);
+      }
+      c = it.leap(state, c + 1);
+    }
+    it.leap_done();
+    return true;
+  }
+
+  /*
+      Semi-join of the pattern e with the candidates of its other variables.
+      When none of them is filtered, the candidates of var in e are just the
+      range of its trie, so they are only installed if that range is less
+      than half of the range of var in any other pattern.
+  */
+  void semijoin_filter(
+      const size_type e,
+      const var_type var,
+      const size_type max_values
+  ) {
+    if (m_is_empty || m_var_iterators[var].size() < 2)
+      return;
+    const triple_pattern &triple = m_ptr_triple_patterns->at(e);
+    const term_pattern *terms[3] = {
+        &triple.term_s, &triple.term_p, &triple.term_o
+    };
+    bool reduced = false;
+    for (const term_pattern *term : terms) {
+      if (term->is_variable && term->value != var)
+        reduced = reduced || m_var_filtered[term->value];
+    }
+    if (!reduced) {
+      ltj_iter_type *it = &m_iterators[e];
+      const size_type n = it->children(it->state_of(var));
+      if (n > max_values)
+        return;
+      const vector<ltj_iter_type *> &itrs = m_var_iterators[var];
+      for (size_type i = 0; i < itrs.size(); ++i) {
+        if (itrs[i] != it && itrs[i]->children(m_var_states[var][i]) < 2 * n)
+          return;
+      }
+    }
+    vector<const_type> values;
+    if (semijoin_project(e, var, max_values, values)) {
+      filter(var, filter_type(std::move(values)));
+    }
+  }
+
   void from_id_to_str(
       tuple_type &t,
       tuple_str_type &t_str,
@@ -105,7 +712,7 @@ private:
 
 public:
   const std::vector<IntersectionStats> &get_stats() const {
-    return m_stats;
+    return m_stats.get();
   }
 
   ltj_algorithm() = default;
@@ -113,10 +720,23 @@ public:
   ltj_algorithm(
       const vector<triple_pattern> *triple_patterns,
       index_scheme_type *ring
+  )
+      : ltj_algorithm(triple_patterns, ring, plan_type(*triple_patterns)) {
+  }
+
+  /*
+      Uses a plan compiled for a query with the same shape (see
+      plan_type::same_shape), so it is not recompiled for each execution
+  */
+  ltj_algorithm(
+      const vector<triple_pattern> *triple_patterns,
+      index_scheme_type *ring,
+      const plan_type &plan
   ) {
 
     m_ptr_triple_patterns = triple_patterns;
     m_ptr_ring = ring;
+    m_plan = plan;
 
     size_type i = 0;
     m_iterators.reserve(m_ptr_triple_patterns->size());
@@ -141,9 +761,25 @@ public:
       ++i;
     }
 
+    // Dense arrays of iterators and positions by variable
+    m_var_iterators.resize(m_plan.size());
+    m_var_states.resize(m_plan.size());
+    m_filters.resize(m_plan.size());
+    m_var_filtered.assign(m_plan.size(), false);
+    m_var_skewed.assign(m_plan.size(), false);
+    for (size_type var = 0; var < m_plan.size(); ++var) {
+      for (const auto &occ : m_plan.occurrences(var)) {
+        m_var_iterators[var].push_back(&(m_iterators[occ.pattern]));
+        m_var_states[var].push_back(occ.state);
+      }
+      if (m_var_iterators[var].size() > m_seek_sizes.size())
+        m_seek_sizes.resize(m_var_iterators[var].size());
+    }
+
     m_veo = veo_type(
         m_ptr_triple_patterns, &m_iterators, &m_var_to_iterators, m_ptr_ring
     );
+    decompose();
   }
 
   //! Copy constructor
@@ -172,8 +808,23 @@ public:
       m_ptr_ring = move(o.m_ptr_ring);
       m_iterators = move(o.m_iterators);
       m_var_to_iterators = move(o.m_var_to_iterators);
+      m_plan = move(o.m_plan);
+      m_var_iterators = move(o.m_var_iterators);
+      m_var_states = move(o.m_var_states);
+      m_filters = move(o.m_filters);
+      m_var_filtered = move(o.m_var_filtered);
+      m_var_skewed = move(o.m_var_skewed);
+      m_seek_sizes = move(o.m_seek_sizes);
+      m_cache = move(o.m_cache);
       m_is_empty = o.m_is_empty;
       m_stats = move(o.m_stats);
+      m_components = move(o.m_components);
+      m_component_algorithms = move(o.m_component_algorithms);
+      m_cursor_frames = move(o.m_cursor_frames);
+      m_cursor_tuple = move(o.m_cursor_tuple);
+      m_cursor_started = o.m_cursor_started;
+      m_cursor_finished = o.m_cursor_finished;
+      m_veo.rebind(m_iterators.data(), &m_iterators, &m_var_to_iterators);
     }
     return *this;
   }
@@ -184,8 +835,122 @@ public:
     std::swap(m_ptr_ring, o.m_ptr_ring);
     std::swap(m_iterators, o.m_iterators);
     std::swap(m_var_to_iterators, o.m_var_to_iterators);
+    std::swap(m_plan, o.m_plan);
+    std::swap(m_var_iterators, o.m_var_iterators);
+    std::swap(m_var_states, o.m_var_states);
+    std::swap(m_filters, o.m_filters);
+    std::swap(m_var_filtered, o.m_var_filtered);
+    std::swap(m_var_skewed, o.m_var_skewed);
+    std::swap(m_seek_sizes, o.m_seek_sizes);
+    m_cache.swap(o.m_cache);
     std::swap(m_is_empty, o.m_is_empty);
     std::swap(m_stats, o.m_stats);
+    std::swap(m_components, o.m_components);
+    std::swap(m_component_algorithms, o.m_component_algorithms);
+    std::swap(m_cursor_frames, o.m_cursor_frames);
+    std::swap(m_cursor_tuple, o.m_cursor_tuple);
+    std::swap(m_cursor_started, o.m_cursor_started);
+    std::swap(m_cursor_finished, o.m_cursor_finished);
+    m_veo.rebind(m_iterators.data(), &m_iterators, &m_var_to_iterators);
+    o.m_veo.rebind(o.m_iterators.data(), &o.m_iterators, &o.m_var_to_iterators);
+  }
+
+  /**
+   * Enables the cache of suffixes (cached LTJ) for join and count. The
+   * solutions of the unbound variables only depend on the bindings of the
+   * bound variables that share a pattern with them, so when that set is
+   * smaller than the bound variables, the count or the list of solutions of
+   * the suffix is cached and reused for other bindings of the rest. It is
+   * only enabled when the query has two variables that do not share any
+   * pattern (otherwise no suffix can be reused).
+   *
+   * @param capacity  Maximum number of cached suffixes (LRU eviction)
+   * @param max_list  Suffixes with more solutions are not cached, so the
+   * memory is bounded by capacity * max_list tuples
+   * @return          True if the cache was enabled
+   */
+  bool enable_cache(
+      const size_type capacity = default_cache_capacity,
+      const size_type max_list = default_cache_list_size
+  ) {
+    if (m_is_empty)
+      return false;
+    bool enabled = m_cache.enable(*m_ptr_triple_patterns, capacity, max_list);
+    for (auto &component : m_component_algorithms) {
+      enabled = component->enable_cache(capacity, max_list) || enabled;
+    }
+    return enabled;
+  }
+
+  /**
+   * Restricts the values of a variable (FILTER on a range or a set of ids).
+   * The filter is applied inside the iterators, so the join skips the
+   * values that do not pass it instead of enumerating and discarding them.
+   * Several filters on the same variable are intersected. It must be called
+   * before the search.
+   *
+   * @param var     Variable (ignored if it is not in the query)
+   * @param f       Filter
+   */
+  void filter(const var_type var, const filter_type &f) {
+    if (m_is_empty || var >= m_plan.size() || m_var_iterators[var].empty())
+      return;
+    m_filters[var].intersect(f);
+    m_var_filtered[var] = true;
+    if (m_filters[var].empty()) {
+      m_is_empty = true;
+      return;
+    }
+    vector<ltj_iter_type *> &itrs = m_var_iterators[var];
+    const vector<state_type> &states = m_var_states[var];
+    for (size_type i = 0; i < itrs.size(); ++i) {
+      itrs[i]->filter(states[i], &m_filters[var]);
+    }
+    for (auto &component : m_component_algorithms) {
+      component->filter(var, f);
+    }
+  }
+
+  /**
+   * Semi-join reduction of an alpha-acyclic query (Yannakakis). Going up
+   * its join tree, each pattern reduces the candidates of the variables it
+   * shares with its parent to the values that extend to its own variables;
+   * then going down, each pattern reduces all its join variables. The
+   * candidates are installed as set filters, so the join skips the values
+   * that cannot be part of a solution instead of exploring dead prefixes.
+   * It must be called before the search.
+   *
+   * @param max_values  Candidate sets with more values are not installed
+   * (the reduction is not selective enough to pay off)
+   * @return            False if the query is cyclic (plain LTJ is used)
+   */
+  bool semijoin_reduce(
+      const size_type max_values = default_semijoin_candidates
+  ) {
+    if (m_is_empty)
+      return false;
+    const join_tree_type tree(*m_ptr_triple_patterns);
+    if (!tree.acyclic())
+      return false;
+    const vector<size_type> &order = tree.order();
+    for (const size_type e : order) {
+      const size_type parent = tree.parent(e);
+      if (parent == join_tree_type::no_parent)
+        continue;
+      const uint64_t shared = tree.vars(e) & tree.vars(parent);
+      for (size_type v = 0; v < join_tree_type::max_vars; ++v) {
+        if (shared >> v & 1)
+          semijoin_filter(e, (var_type)v, max_values);
+      }
+    }
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+      const uint64_t vars = tree.vars(*it);
+      for (size_type v = 0; v < join_tree_type::max_vars; ++v) {
+        if (vars >> v & 1)
+          semijoin_filter(*it, (var_type)v, max_values);
+      }
+    }
+    return true;
   }
 
   /**
@@ -199,12 +964,40 @@ public:
             results_type &res,
             const size_type limit_results = 0,
             const size_type timeout_seconds = 0
+  ) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    join(res, limit_results, deadline);
+  };
+
+  /**
+   *
+   * @param res               Results
+   * @param limit_results     Limit of results
+   * @param deadline          Deadline of the search. It can be cancelled
+   * from another thread.
+   */
+  template <class results_type>
+  void join(
+      results_type &res,
+      const size_type limit_results,
+      ::util::deadline &deadline
   ) {
     if (m_is_empty)
       return;
-    time_point_type start = chrono::high_resolution_clock::now();
+    if (!m_component_algorithms.empty()) {
+      join_components(
+          [&res](const tuple_type &t) { res.add(t); },
+          [&res]() { return res.size(); }, limit_results, deadline
+      );
+      return;
+    }
     tuple_type t(m_veo.size());
-    search(0, t, res, start, limit_results, timeout_seconds);
+    if (m_cache.enabled()) {
+      m_cache.reset_records();
+      search_cached(0, 0, t, res, deadline, limit_results);
+      return;
+    }
+    search(0, t, res, deadline, limit_results);
   };
 
   /**
@@ -221,83 +1014,658 @@ public:
                 dict::basic_map &dict_p,
                 const size_type limit_results = 0,
                 const size_type timeout_seconds = 0
+  ) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    join_str(res, in_p, dict_so, dict_p, limit_results, deadline);
+  };
+
+  /**
+   *
+   * @param res               Results
+   * @param limit_results     Limit of results
+   * @param deadline          Deadline of the search
+   */
+  template <class results_type>
+  void join_str(
+      results_type &res,
+      const std::vector<bool> &in_p,
+      dict::basic_map &dict_so,
+      dict::basic_map &dict_p,
+      const size_type limit_results,
+      ::util::deadline &deadline
   ) {
     if (m_is_empty)
       return;
-    time_point_type start = chrono::high_resolution_clock::now();
-    tuple_type t(m_veo.size());
     tuple_str_type t_str(m_veo.size());
+    if (!m_component_algorithms.empty()) {
+      join_components(
+          [&](const tuple_type &t) {
+            tuple_type tc(t);
+            from_id_to_str(tc, t_str, in_p, dict_so, dict_p);
+            res.add(t_str);
+          },
+          [&res]() { return res.size(); }, limit_results, deadline
+      );
+      return;
+    }
+    tuple_type t(m_veo.size());
     search_str(
-        0, t, t_str, res, in_p, dict_so, dict_p, start, limit_results,
-        timeout_seconds
+        0, t, t_str, res, in_p, dict_so, dict_p, deadline, limit_results
     );
   };
 
   /**
+   * Counts the solutions without enumerating them. The bindings of lonely
+   * variables are never visited: a lonely variable in the last level adds
+   * the number of children of its node, and two lonely variables in the
+   * same triple pattern add the size of the subtree of the fixed node.
+   * Disconnected queries are counted as the product of their components.
+   * If the search times out the count is partial: use the overload with
+   * timed_out, or the one with a deadline and check deadline.cancelled().
    *
-   * @param j                 Index of the variable
-   * @param tuple             Tuple of the current search
-   * @param res               Results
-   * @param start             Initial time to check timeout
+   * @param timeout_seconds   Timeout in seconds
+   * @return                  Number of solutions
+   */
+  size_type count(const size_type timeout_seconds = 0) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    return count(deadline);
+  };
+
+  /**
+   *
+   * @param timeout_seconds   Timeout in seconds
+   * @param timed_out         Set to true if the count is partial
+   * @return                  Number of solutions found before the timeout
+   */
+  size_type count(const size_type timeout_seconds, bool &timed_out) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    const size_type total = count(deadline);
+    timed_out = deadline.cancelled();
+    return total;
+  };
+
+  size_type count(::util::deadline &deadline) {
+    if (m_is_empty)
+      return 0;
+    if (!m_component_algorithms.empty()) {
+      size_type total = 1;
+      for (auto &component : m_component_algorithms) {
+        total *= component->count(deadline);
+        if (total == 0 || deadline.cancelled())
+          break;
+      }
+      return total;
+    }
+    if (m_cache.enabled()) {
+      tuple_type t(m_veo.size());
+      size_type total = 0;
+      search_count_cached(0, 0, t, total, deadline);
+      return total;
+    }
+    vector<bool> bound(m_var_iterators.size(), false);
+    size_type total = 0;
+    search_count(0, 1, total, bound, deadline);
+    return total;
+  };
+
+  /**
+   * Projection of the solutions onto some variables (SELECT). The projected
+   * variables are chosen first by the VEO, and once all of them are bound the
+   * remaining ones only need one witness (DISTINCT) or their count (bag
+   * semantics), so they are never enumerated. DISTINCT only keeps a set of
+   * reported tuples when the VEO had to bind some variable that is not
+   * projected before the projected ones.
+   * The order of the VEO is restored when it returns, also when the search
+   * stops early, so other searches can run on the same object after it.
+   *
+   * @param res               Results (tuples of the projected variables)
+   * @param projection        Projected variables
+   * @param distinct          Reports each tuple once (otherwise as many
+   * times as solutions it has)
    * @param limit_results     Limit of results
    * @param timeout_seconds   Timeout in seconds
    */
   template <class results_type>
-  bool search_str(
-      const size_type j,
-      tuple_type &tuple,
-      tuple_str_type &t_str,
+  void join_projected(
       results_type &res,
-      const std::vector<bool> &in_p,
-      dict::basic_map &dict_so,
-      dict::basic_map &dict_p,
-      const time_point_type start,
+      const vector<var_type> &projection,
+      const bool distinct = true,
       const size_type limit_results = 0,
       const size_type timeout_seconds = 0
   ) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    join_projected(res, projection, distinct, limit_results, deadline);
+  };
 
-    //(Optional) Check timeout
-    if (timeout_seconds > 0) {
-      time_point_type stop = chrono::high_resolution_clock::now();
-      auto sec = chrono::duration_cast<chrono::seconds>(stop - start).count();
-      if (sec > timeout_seconds) {
-        return false;
+  template <class results_type>
+  void join_projected(
+      results_type &res,
+      const vector<var_type> &projection,
+      const bool distinct,
+      const size_type limit_results,
+      ::util::deadline &deadline
+  ) {
+    if (m_is_empty)
+      return;
+    vector<bool> projected(m_plan.size(), false);
+    vector<var_type> vars;
+    for (const var_type var : projection) {
+      // Variables that are not in the query are ignored
+      if (var < m_plan.size() && !m_var_iterators[var].empty() &&
+          !projected[var]) {
+        projected[var] = true;
+        vars.push_back(var);
       }
     }
+    priority_guard_type guard(m_veo);
+    m_veo.prioritize(vars);
+    tuple_type t(m_veo.size());
+    std::set<tuple_type> reported;
+    search_projected(
+        0, 0, false, t, projected, vars.size(), distinct, reported, res,
+        deadline, limit_results
+    );
+  };
 
-    //(Optional) Check limit
-    if (limit_results > 0 && res.size() == limit_results) {
-      return false;
-    }
+  /**
+   * Factorized version of join. A lonely variable in the last level of its
+   * trie is not enumerated: the results get a reference to the range of its
+   * candidates instead, so independent lonely variables are reported as one
+   * prefix and a list of ranges rather than as their cartesian product.
+   *
+   * @param res               Results (e.g. results_factorized_type)
+   * @param limit_results     Limit of entries (prefixes) of the results
+   * @param timeout_seconds   Timeout in seconds
+   */
+  template <class results_type>
+  void join_factorized(
+      results_type &res,
+      const size_type limit_results = 0,
+      const size_type timeout_seconds = 0
+  ) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    join_factorized(res, limit_results, deadline);
+  };
 
-    if (j == m_veo.size()) {
-      // Report results
-      // res.emplace_back(tuple);
-      from_id_to_str(tuple, t_str, in_p, dict_so, dict_p);
-      res.add(t_str);
-    } else {
-      var_type x_j = m_veo.next();
-      // cout << "Variable: " << (uint64_t) x_j << endl;
-      // cout << (uint64_t) x_j << endl;
-      vector<ltj_iter_type *> &itrs = m_var_to_iterators[x_j];
+  template <class results_type>
+  void join_factorized(
+      results_type &res,
+      const size_type limit_results,
+      ::util::deadline &deadline
+  ) {
+    if (m_is_empty)
+      return;
+    tuple_type t;
+    t.reserve(m_veo.size());
+    factors_type factors;
+    search_factorized(0, t, factors, res, deadline, limit_results);
+  };
+
+  /**
+   * Resumable version of join: reports the next page of results after the
+   * position stored in token, and updates the token with the last reported
+   * result. The token can be encoded and used later to resume the search
+   * with a new ltj_algorithm for the same query and index (an ltj_algorithm
+   * solves a single page). If the deadline expires, the token still points
+   * to the last reported result, so no result is lost or repeated.
+   *
+   * @param res               Results
+   * @param page_size         Maximum number of results of the page
+   * @param token             Continuation token (default-constructed for
+   * the first page)
+   * @param deadline          Deadline of the search
+   * @return                  False if the search finished
+   */
+  template <class results_type>
+  bool join_page(
+      results_type &res,
+      const size_type page_size,
+      continuation_type &token,
+      ::util::deadline &deadline
+  ) {
+    return join_page_emit(
+        [&res](const tuple_type &t) { res.add(t); }, page_size, token,
+        deadline
+    );
+  };
+
+  template <class results_type>
+  bool join_page(
+      results_type &res,
+      const size_type page_size,
+      continuation_type &token,
+      const size_type timeout_seconds = 0
+  ) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    return join_page(res, page_size, token, deadline);
+  };
+
+  template <class results_type>
+  bool join_page_str(
+      results_type &res,
+      const std::vector<bool> &in_p,
+      dict::basic_map &dict_so,
+      dict::basic_map &dict_p,
+      const size_type page_size,
+      continuation_type &token,
+      ::util::deadline &deadline
+  ) {
+    tuple_str_type t_str(m_veo.size());
+    return join_page_emit(
+        [&](const tuple_type &t) {
+          tuple_type tc(t);
+          from_id_to_str(tc, t_str, in_p, dict_so, dict_p);
+          res.add(t_str);
+        },
+        page_size, token, deadline
+    );
+  };
+
+  template <class Emit>
+  bool join_page_emit(
+      Emit emit,
+      const size_type page_size,
+      continuation_type &token,
+      ::util::deadline &deadline
+  ) {
+    const size_type fingerprint =
+        continuation_type::fingerprint(*m_ptr_triple_patterns);
+    if (token.started() && token.query_fingerprint() != fingerprint) {
+      throw std::runtime_error("The continuation token is for another query");
+    }
+    if (token.finished() || page_size == 0)
+      return !token.finished();
+    if (m_is_empty) {
+      token.finish(fingerprint);
+      return false;
+    }
+    tuple_type t(m_veo.size());
+    const tuple_type from = token.last();
+    size_type n_page = 0;
+    bool done = search_page(
+        0, t, emit, page_size, n_page, from, !from.empty(), token, fingerprint,
+        deadline
+    );
+    if (done) {
+      token.finish(fingerprint);
+      return false;
+    }
+    return true;
+  };
+
+  /**
+   * Top-k solutions in order of the id of a variable (ORDER BY ?x LIMIT k).
+   * The children of every node of the tries are sorted by id, so when the
+   * VEO can bind the variable first the solutions come out in ascending
+   * order and the search stops after k of them. Otherwise (another variable
+   * must go first, or the order is descending) all the solutions are
+   * enumerated and the best k are kept in a heap. Ties are reported in the
+   * order of the search.
+   * The order of the VEO is restored when it returns, also when the search
+   * stops early, so other searches can run on the same object after it.
+   *
+   * @param res               Results
+   * @param var               Variable of the ORDER BY
+   * @param k                 Number of results (0 = all)
+   * @param descending        Descending order
+   * @param timeout_seconds   Timeout in seconds
+   * @return                  True if the search followed the order of var
+   * (no heap was needed)
+   */
+  template <class results_type>
+  bool join_ordered(
+      results_type &res,
+      const var_type var,
+      const size_type k = 0,
+      const bool descending = false,
+      const size_type timeout_seconds = 0
+  ) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    return join_ordered(res, var, k, descending, deadline);
+  };
+
+  template <class results_type>
+  bool join_ordered(
+      results_type &res,
+      const var_type var,
+      const size_type k,
+      const bool descending,
+      ::util::deadline &deadline
+  ) {
+    return join_ordered_emit(
+        [&res](const tuple_type &t) { res.add(t); }, var, k, descending,
+        deadline
+    );
+  };
+
+  template <class results_type>
+  bool join_ordered_str(
+      results_type &res,
+      const std::vector<bool> &in_p,
+      dict::basic_map &dict_so,
+      dict::basic_map &dict_p,
+      const var_type var,
+      const size_type k,
+      const bool descending,
+      ::util::deadline &deadline
+  ) {
+    tuple_str_type t_str(m_veo.size());
+    return join_ordered_emit(
+        [&](const tuple_type &t) {
+          tuple_type tc(t);
+          from_id_to_str(tc, t_str, in_p, dict_so, dict_p);
+          res.add(t_str);
+        },
+        var, k, descending, deadline
+    );
+  };
+
+  template <class Emit>
+  bool join_ordered_emit(
+      Emit emit,
+      const var_type var,
+      const size_type k,
+      const bool descending,
+      ::util::deadline &deadline
+  ) {
+    if (m_is_empty)
+      return true;
+    emit_results_type<Emit> out(emit);
+    if (var >= m_plan.size() || m_var_iterators[var].empty()) {
+      // Not in the query: any order is valid
+      tuple_type t(m_veo.size());
+      search(0, t, out, deadline, k);
+      return true;
+    }
+    priority_guard_type guard(m_veo);
+    if (!descending) {
+      m_veo.prioritize(vector<var_type>(1, var));
+      // Probe the first choice of the VEO (next and done are paired)
+      const bool first = m_veo.next() == var;
+      m_veo.done();
+      if (first) {
+        tuple_type t(m_veo.size());
+        search(0, t, out, deadline, k);
+        return true;
+      }
+    }
+
+    // Fallback: bounded heap with the best k solutions
+    top_k_type top(var, k, descending);
+    if (!m_component_algorithms.empty()) {
+      join_components(
+          [&top](const tuple_type &t) { top.add(t); },
+          []() { return (size_type)0; }, 0, deadline
+      );
+    } else {
+      tuple_type t(m_veo.size());
+      search(0, t, top, deadline);
+    }
+    top.report(out);
+    return false;
+  };
+
+  /**
+   * Pull-based enumeration: reports the next solution. The search keeps an
+   * explicit stack with one frame per level instead of recursing, so it
+   * stops after each solution and goes on at the next call. The caller
+   * decides when to consume the results, and several cursors can be
+   * interleaved on a single thread. The VEO follows the same
+   * next/down/up/done protocol as search().
+   * Note that disconnected queries are not split into components here, so
+   * their solutions are the ones of join() but in another order.
+   *
+   * @param tuple     Next solution
+   * @param deadline  Deadline of the search
+   * @return          False if there are no more solutions or the deadline
+   * expired. In the latter case exhausted() is false and the cursor can be
+   * resumed.
+   */
+  bool next(tuple_type &tuple, ::util::deadline &deadline) {
+    return cursor_next(tuple, [&deadline]() { return deadline.expired(); });
+  };
+
+  bool next(tuple_type &tuple) {
+    return cursor_next(tuple, []() { return false; });
+  };
+
+  // True once the cursor has reported all the solutions
+  inline bool exhausted() const {
+    return m_is_empty || m_cursor_finished;
+  }
+
+  /**
+   * Parallel version of join. The values of the first variable are split
+   * into ranges, and each range is a task that runs on a work-stealing pool.
+   * Each task solves its part of the query with the iterators and VEO of its
+   * worker, and large ranges at deeper levels are split again whenever a
+   * worker becomes idle. A split task replays the bindings of its prefix, so
+   * it throws if the VEO of another worker does not choose the same
+   * variables.
+   * Note that the index must support concurrent reads (the dynamic tries
+   * restructure themselves on access, so only static indexes are safe).
+   *
+   * @param res               Results
+   * @param n_threads         Number of threads (0 = hardware concurrency)
+   * @param limit_results     Limit of results
+   * @param timeout_seconds   Timeout in seconds
+   */
+  template <class results_type>
+  void join_parallel(
+      results_type &res,
+      size_type n_threads = 0,
+      const size_type limit_results = 0,
+      const size_type timeout_seconds = 0
+  ) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    join_parallel(res, n_threads, limit_results, deadline);
+  };
+
+  template <class results_type>
+  void join_parallel(
+      results_type &res,
+      size_type n_threads,
+      const size_type limit_results,
+      ::util::deadline &deadline
+  ) {
+    if (m_is_empty)
+      return;
+    if (n_threads == 0)
+      n_threads = std::thread::hardware_concurrency();
+    if (n_threads <= 1 || m_veo.size() == 0) {
+      join(res, limit_results, deadline);
+      return;
+    }
+
+    // 1. First binding of the first variable
+    var_type x_0 = m_veo.next();
+    if (is_lonely(x_0)) {
+      // A single list: nothing worth splitting
+      m_veo.done();
+      join(res, limit_results, deadline);
+      return;
+    }
+    const value_type first = seek(x_0);
+    if (first == 0) {
+      m_veo.done();
+      return;
+    }
+
+    // 2. Splitting the values of x_0 into ranges. The bindings are a subset
+    // of the children of every iterator, so the ranges are cut at the
+    // children of the iterator with the fewest of them, which are read
+    // from its trie without enumerating the intersection.
+    vector<ltj_iter_type *> &itrs = m_var_iterators[x_0];
+    const vector<state_type> &states = m_var_states[x_0];
+    size_type i_min = 0;
+    for (size_type i = 1; i < itrs.size(); ++i) {
+      if (itrs[i]->children(states[i]) < itrs[i_min]->children(states[i_min]))
+        i_min = i;
+    }
+    const auto children = itrs[i_min]->seek_all(x_0);
+    pool_type pool(n_threads);
+    size_type n_tasks = n_threads * parallel_tasks_per_thread;
+    if (n_tasks > children.size())
+      n_tasks = children.size();
+    size_type w = 0;
+    for (size_type k = 0; k < n_tasks; ++k) {
+      parallel_task_type task;
+      task.lo = (k == 0) ? first : children[k * children.size() / n_tasks];
+      task.hi = (k + 1 == n_tasks)
+                    ? children[children.size() - 1]
+                    : children[(k + 1) * children.size() / n_tasks] - 1;
+      if (task.lo <= task.hi) {
+        pool.push(w, std::move(task));
+        w = (w + 1 == n_threads) ? 0 : w + 1;
+      }
+    }
+    for (auto &itr : itrs) {
+      itr->leap_done(); // The range was not exhausted by seek
+    }
+    m_veo.done();
+
+    // 3. Solving the tasks
+    parallel_context_type<results_type> ctx;
+    ctx.pool = &pool;
+    ctx.res = &res;
+    ctx.buffers.resize(n_threads);
+    ctx.deadline = &deadline;
+    ctx.limit_results = limit_results;
+    // Each worker builds its own instance once and reuses it for its tasks
+    vector<std::unique_ptr<ltj_algorithm>> locals(n_threads);
+    pool.run([this, &ctx, &locals](size_type w, parallel_task_type &task) {
+      if (!locals[w]) {
+        locals[w].reset(new ltj_algorithm(m_ptr_triple_patterns, m_ptr_ring));
+        for (size_type var = 0; var < m_var_filtered.size(); ++var) {
+          if (m_var_filtered[var])
+            locals[w]->filter(var, m_filters[var]);
+        }
+      }
+      if (!locals[w]->search_task(w, task, ctx))
+        locals[w].reset(); // Stopped in the middle of the search
+      flush_results(ctx, w);
+    });
+    if (ctx.replay_failed) {
+      throw std::runtime_error(
+          "A task of the parallel search could not be replayed"
+      );
+    }
+  };
+
+  /**
+   *
+   * @param w                 Worker that solves the task
+   * @param task              Task to solve
+   * @param ctx               Context shared by the workers
+   * @return                  False if the search stopped in the middle (the
+   * iterators and the VEO are not back at the root)
+   */
+  template <class results_type>
+  bool search_task(
+      const size_type w,
+      const parallel_task_type &task,
+      parallel_context_type<results_type> &ctx
+  ) {
+    tuple_type tuple(m_veo.size());
+    // 1. Replaying the bindings of the prefix. The VEO must return the same
+    // variables as in the worker that split the task, otherwise the bindings
+    // cannot be replayed and the parallel search fails.
+    size_type j = 0;
+    bool replayed = true;
+    for (const auto &b : task.prefix) {
+      var_type x_j = m_veo.next();
+      if (x_j != b.first) {
+        m_veo.done();
+        ctx.replay_failed = true;
+        ctx.pool->stop();
+        replayed = false;
+        break;
+      }
+      vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+      const vector<state_type> &states = m_var_states[x_j];
+      if (!is_lonely(x_j)) {
+        seek_from(x_j, b.second); // Sets the iterators on the binding
+      }
+      tuple[j] = b;
+      for (size_type i = 0; i < itrs.size(); ++i) {
+        itrs[i]->down(states[i], b.second);
+      }
+      m_veo.down();
+      ++j;
+    }
+    // 2. Search on the range of the split level
+    if (replayed && !search_parallel(w, j, tuple, ctx, task.lo, task.hi))
+      return false;
+    // 3. Undoing the prefix, so the next task starts from the root
+    while (j > 0) {
+      --j;
+      const var_type x_j = tuple[j].first;
+      for (ltj_iter_type *iter : m_var_iterators[x_j]) {
+        iter->up(x_j);
+        iter->leap_done(); // The replay left the leap in the binding
+      }
+      m_veo.up();
+      m_veo.done();
+    }
+    return true;
+  }
+
+  /**
+   *
+   * @param w                 Worker that runs the search
+   * @param j                 Index of the variable
+   * @param tuple             Tuple of the current search
+   * @param ctx               Context shared by the workers
+   * @param lo                Minimum value for the variable j
+   * @param hi                Maximum value for the variable j
+   */
+  template <class results_type>
+  bool search_parallel(
+      const size_type w,
+      const size_type j,
+      tuple_type &tuple,
+      parallel_context_type<results_type> &ctx,
+      const value_type lo = 0,
+      const value_type hi = -1ULL
+  ) {
+
+    if (ctx.pool->stopped()) {
+      return false;
+    }
+
+    // Check deadline and cancellation
+    if (ctx.deadline->expired()) {
+      ctx.pool->stop();
+      return false;
+    }
+
+    if (j == m_veo.size()) {
+      // Report results (checking the global limit)
+      const size_type k = ctx.n_results.fetch_add(1);
+      if (ctx.limit_results > 0 && k >= ctx.limit_results) {
+        ctx.pool->stop();
+        return false;
+      }
+      auto &buffer = ctx.buffers[w];
+      buffer.push_back(tuple);
+      if (buffer.size() == parallel_flush_size) {
+        flush_results(ctx, w);
+      }
+    } else {
+      var_type x_j = m_veo.next();
+      vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+      const vector<state_type> &states = m_var_states[x_j];
       bool ok;
-      if (itrs.size() == 1 && itrs[0]->in_last_level()) { // Lonely variables
-        // cout << "Seeking (last level)" << endl;
+      if (is_lonely(x_j)) { // Lonely variables
         auto results = itrs[0]->seek_all(x_j);
-        // cout << "Results: " << results.size() << endl;
-        // cout << "Seek (last level): (" << (uint64_t) x_j << ": size=" <<
-        // results.size() << ")" <<endl;
         for (const auto &c : results) {
           // 1. Adding result to tuple
           tuple[j] = {x_j, c};
           // 2. Going down in the trie by setting x_j = c (\mu(t_i) in paper)
-          itrs[0]->down(x_j, c);
+          itrs[0]->down(states[0], c);
           m_veo.down();
-          // 2. Search with the next variable x_{j+1}
-          ok = search_str(
-              j + 1, tuple, t_str, res, in_p, dict_so, dict_p, start,
-              limit_results, timeout_seconds
-          );
+          // 3. Search with the next variable x_{j+1}
+          ok = search_parallel(w, j + 1, tuple, ctx);
           if (!ok)
             return false;
           // 4. Going up in the trie by removing x_j = c
@@ -305,22 +1673,19 @@ public:
           m_veo.up();
         }
       } else {
-        value_type c = seek(x_j);
-        // cout << "Seek (init): (" << (uint64_t) x_j << ": " << c << ")"
-        // <<endl;
-        while (c != 0) { // If empty c=0
+        const bool splittable = j + 1 < m_veo.size() &&
+                                min_children(x_j) >= parallel_split_size;
+        value_type c = (lo == 0) ? seek(x_j) : seek_from(x_j, lo);
+        while (c != 0 && c <= hi) { // If empty c=0
           // 1. Adding result to tuple
           tuple[j] = {x_j, c};
           // 2. Going down in the tries by setting x_j = c (\mu(t_i) in paper)
-          for (ltj_iter_type *iter : itrs) {
-            iter->down(x_j, c);
+          for (size_type i = 0; i < itrs.size(); ++i) {
+            itrs[i]->down(states[i], c);
           }
           m_veo.down();
           // 3. Search with the next variable x_{j+1}
-          ok = search_str(
-              j + 1, tuple, t_str, res, in_p, dict_so, dict_p, start,
-              limit_results, timeout_seconds
-          );
+          ok = search_parallel(w, j + 1, tuple, ctx);
           if (!ok)
             return false;
           // 4. Going up in the tries by removing x_j = c
@@ -328,10 +1693,23 @@ public:
             iter->up(x_j);
           }
           m_veo.up();
-          // 5. Next constant for x_j
+          // 5. Donating the remaining candidates to an idle worker
+          if (splittable && c < hi && ctx.pool->idle() > 0 &&
+              ctx.pool->is_empty(w)) {
+            parallel_task_type task;
+            task.prefix.assign(tuple.begin(), tuple.begin() + j);
+            task.lo = c + 1;
+            task.hi = hi;
+            ctx.pool->push(w, std::move(task));
+            break;
+          }
+          // 6. Next constant for x_j
           c = seek(x_j, c + 1);
-          // cout << "Seek (bucle): (" << (uint64_t) x_j << ": " << c << ")"
-          // <<endl;
+        }
+        if (c != 0) { // The range was not exhausted by seek
+          for (auto &itr : itrs) {
+            itr->leap_done();
+          }
         }
       }
       m_veo.done();
@@ -344,28 +1722,25 @@ public:
    * @param j                 Index of the variable
    * @param tuple             Tuple of the current search
    * @param res               Results
-   * @param start             Initial time to check timeout
+   * @param deadline          Deadline of the search
    * @param limit_results     Limit of results
-   * @param timeout_seconds   Timeout in seconds
    */
   template <class results_type>
-  bool search(
+  bool search_str(
       const size_type j,
       tuple_type &tuple,
+      tuple_str_type &t_str,
       results_type &res,
-      const time_point_type start,
-      const size_type limit_results = 0,
-      const size_type timeout_seconds = 0
+      const std::vector<bool> &in_p,
+      dict::basic_map &dict_so,
+      dict::basic_map &dict_p,
+      ::util::deadline &deadline,
+      const size_type limit_results = 0
   ) {
 
-    //(Optional) Check timeout
-    if (timeout_seconds > 0) {
-      time_point_type stop = chrono::high_resolution_clock::now();
-      auto sec = chrono::duration_cast<chrono::seconds>(stop - start).count();
-      if (sec > timeout_seconds) {
-        return false;
-      }
-    }
+    // Check deadline and cancellation
+    if (deadline.expired())
+      return false;
 
     //(Optional) Check limit
     if (limit_results > 0 && res.size() == limit_results) {
@@ -375,26 +1750,16 @@ public:
     if (j == m_veo.size()) {
       // Report results
       // res.emplace_back(tuple);
-      res.add(tuple);
-#if EXPT_TIME_SOL
-      if (res.size() % 1000 == 0) {
-        time_point_type stop = chrono::high_resolution_clock::now();
-        auto sec = chrono::duration_cast<chrono::seconds>(stop - start).count();
-        std::cerr << res.size() << ";" << sec << std::endl;
-      }
-#endif
-      /*cout << "Add result" << endl;
-      for(const auto &dat : tuple){
-          cout << "{" << (uint64_t) dat.first << "=" << dat.second << "} ";
-      }
-      cout << endl;*/
+      from_id_to_str(tuple, t_str, in_p, dict_so, dict_p);
+      res.add(t_str);
     } else {
       var_type x_j = m_veo.next();
       // cout << "Variable: " << (uint64_t) x_j << endl;
       // cout << (uint64_t) x_j << endl;
-      vector<ltj_iter_type *> &itrs = m_var_to_iterators[x_j];
+      vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+      const vector<state_type> &states = m_var_states[x_j];
       bool ok;
-      if (itrs.size() == 1 && itrs[0]->in_last_level()) { // Lonely variables
+      if (is_lonely(x_j)) { // Lonely variables
         // cout << "Seeking (last level)" << endl;
         auto results = itrs[0]->seek_all(x_j);
         // cout << "Results: " << results.size() << endl;
@@ -404,52 +1769,42 @@ public:
           // 1. Adding result to tuple
           tuple[j] = {x_j, c};
           // 2. Going down in the trie by setting x_j = c (\mu(t_i) in paper)
-          itrs[0]->down(x_j, c);
+          itrs[0]->down(states[0], c);
           m_veo.down();
           // 2. Search with the next variable x_{j+1}
-          ok = search(j + 1, tuple, res, start, limit_results, timeout_seconds);
-          if (!ok)
+          ok = search_str(
+              j + 1, tuple, t_str, res, in_p, dict_so, dict_p, deadline,
+              limit_results
+          );
+          if (!ok) {
+            stop_level(x_j);
             return false;
+          }
           // 4. Going up in the trie by removing x_j = c
           itrs[0]->up(x_j);
           m_veo.up();
         }
       } else {
-        // TODO: Make stats optional
-        IntersectionStats stats;
-        stats.variable_id = x_j;
-        stats.depth = j;
-
-        // Collect list sizes from each iterator
-        for (ltj_iter_type *iter : itrs) {
-          // Determine which state/variable this iterator represents
-          state_type state = o; // default
-          if (iter->is_variable_subject(x_j)) {
-            state = s;
-          } else if (iter->is_variable_predicate(x_j)) {
-            state = p;
-          }
-          stats.list_sizes.push_back(iter->children(state));
-        }
-
         value_type c = seek(x_j);
         // cout << "Seek (init): (" << (uint64_t) x_j << ": " << c << ")"
         // <<endl;
         while (c != 0) { // If empty c=0
-          // Count each result found
-          stats.result_size++;
-
           // 1. Adding result to tuple
           tuple[j] = {x_j, c};
           // 2. Going down in the tries by setting x_j = c (\mu(t_i) in paper)
-          for (ltj_iter_type *iter : itrs) {
-            iter->down(x_j, c);
+          for (size_type i = 0; i < itrs.size(); ++i) {
+            itrs[i]->down(states[i], c);
           }
           m_veo.down();
           // 3. Search with the next variable x_{j+1}
-          ok = search(j + 1, tuple, res, start, limit_results, timeout_seconds);
-          if (!ok)
+          ok = search_str(
+              j + 1, tuple, t_str, res, in_p, dict_so, dict_p, deadline,
+              limit_results
+          );
+          if (!ok) {
+            stop_level(x_j);
             return false;
+          }
           // 4. Going up in the tries by removing x_j = c
           for (ltj_iter_type *iter : itrs) {
             iter->up(x_j);
@@ -460,13 +1815,6 @@ public:
           // cout << "Seek (bucle): (" << (uint64_t) x_j << ": " << c << ")"
           // <<endl;
         }
-
-        // TODO: Make stats optional
-        stats.alternation_complexity =
-            calculate_alternation_complexity(itrs, x_j);
-
-        // TODO: compute leapfrog_seeks (needs to be done in seek)
-        m_stats.push_back(stats);
       }
       m_veo.done();
     }
@@ -475,26 +1823,921 @@ public:
 
   /**
    *
-   * @param x_j   Variable
-   * @param c     Constant. If it is unknown the value is -1
-   * @return      The next constant that matches the intersection between the
-   * triples of x_j. If the intersection is empty, it returns 0.
+   * @param j                 Index of the variable
+   * @param tuple             Tuple of the current search
+   * @param res               Results
+   * @param deadline          Deadline of the search
+   * @param limit_results     Limit of results
    */
+  template <class results_type>
+  bool search(
+      const size_type j,
+      tuple_type &tuple,
+      results_type &res,
+      ::util::deadline &deadline,
+      const size_type limit_results = 0
+  ) {
 
-  value_type seek(const var_type x_j, value_type c = -1) {
-    vector<ltj_iter_type *> &itrs = m_var_to_iterators[x_j];
-    value_type c_i, c_prev = 0, i = 0, n_ok = 0;
+    // Check deadline and cancellation
+    if (deadline.expired())
+      return false;
 
-    while (true) {
-      // Compute leap for each triple that contains x_j
-      // std::cout << "Leap of " << (::uint64_t) x_j << " in iterator: " << i <<
-      // std::endl;
+    //(Optional) Check limit
+    if (limit_results > 0 && res.size() == limit_results) {
+      return false;
+    }
+
+    if (j == m_veo.size()) {
+      // Report results
+      // res.emplace_back(tuple);
+      res.add(tuple);
+#if EXPT_TIME_SOL
+      if (res.size() % 1000 == 0) {
+        auto sec = deadline.elapsed_milliseconds() / 1000;
+        std::cerr << res.size() << ";" << sec << std::endl;
+      }
+#endif
+      /*cout << "Add result" << endl;
+      for(const auto &dat : tuple){
+          cout << "{" << (uint64_t) dat.first << "=" << dat.second << "} ";
+      }
+      cout << endl;*/
+    } else {
+      var_type x_j = m_veo.next();
+      // cout << "Variable: " << (uint64_t) x_j << endl;
+      // cout << (uint64_t) x_j << endl;
+      vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+      const vector<state_type> &states = m_var_states[x_j];
+      bool ok;
+      if (is_lonely(x_j)) { // Lonely variables
+        // cout << "Seeking (last level)" << endl;
+        auto results = itrs[0]->seek_all(x_j);
+        // cout << "Results: " << results.size() << endl;
+        // cout << "Seek (last level): (" << (uint64_t) x_j << ": size=" <<
+        // results.size() << ")" <<endl;
+        for (const auto &c : results) {
+          // 1. Adding result to tuple
+          tuple[j] = {x_j, c};
+          // 2. Going down in the trie by setting x_j = c (\mu(t_i) in paper)
+          itrs[0]->down(states[0], c);
+          m_veo.down();
+          // 2. Search with the next variable x_{j+1}
+          ok = search(j + 1, tuple, res, deadline, limit_results);
+          if (!ok) {
+            stop_level(x_j);
+            return false;
+          }
+          // 4. Going up in the trie by removing x_j = c
+          itrs[0]->up(x_j);
+          m_veo.up();
+        }
+      } else {
+        m_stats.begin(itrs, x_j, j);
+
+        value_type c = seek(x_j);
+        // cout << "Seek (init): (" << (uint64_t) x_j << ": " << c << ")"
+        // <<endl;
+        while (c != 0) { // If empty c=0
+          m_stats.add_result();
+
+          // 1. Adding result to tuple
+          tuple[j] = {x_j, c};
+          // 2. Going down in the tries by setting x_j = c (\mu(t_i) in paper)
+          for (size_type i = 0; i < itrs.size(); ++i) {
+            itrs[i]->down(states[i], c);
+          }
+          m_veo.down();
+          // 3. Search with the next variable x_{j+1}
+          ok = search(j + 1, tuple, res, deadline, limit_results);
+          if (!ok) {
+            stop_level(x_j);
+            return false;
+          }
+          // 4. Going up in the tries by removing x_j = c
+          for (ltj_iter_type *iter : itrs) {
+            iter->up(x_j);
+          }
+          m_veo.up();
+          // 5. Next constant for x_j
+          c = seek(x_j, c + 1);
+          // cout << "Seek (bucle): (" << (uint64_t) x_j << ": " << c << ")"
+          // <<endl;
+        }
+
+        m_stats.end(itrs, x_j);
+      }
+      m_veo.done();
+    }
+    return true;
+  };
+
+  /**
+   * Same as search, but the solutions of a suffix are taken from the cache
+   * when it was already solved for the same bindings of its adhesion.
+   *
+   * @param j                 Index of the variable
+   * @param bound             Bound variables (bitmap)
+   * @param tuple             Tuple of the current search
+   * @param res               Results
+   * @param deadline          Deadline of the search
+   * @param limit_results     Limit of results
+   */
+  template <class results_type>
+  bool search_cached(
+      const size_type j,
+      const uint64_t bound,
+      tuple_type &tuple,
+      results_type &res,
+      ::util::deadline &deadline,
+      const size_type limit_results = 0
+  ) {
+
+    // Check deadline and cancellation
+    if (deadline.expired())
+      return false;
+
+    //(Optional) Check limit
+    if (limit_results > 0 && res.size() == limit_results)
+      return false;
+
+    if (j == m_veo.size()) {
+      res.add(tuple);
+      if (m_cache.recording()) {
+        m_cache.record(tuple);
+      }
+      return true;
+    }
+
+    if (!m_cache.cacheable(bound, j))
+      return search_cached_level(
+          j, bound, tuple, res, deadline, limit_results
+      );
+
+    typename cache_type::key_type key;
+    m_cache.key(bound, tuple, j, key);
+    const tuple_type *suffixes = m_cache.find_list(key);
+    if (suffixes != nullptr) {
+      const size_type len = m_veo.size() - j;
+      for (size_type i = 0; i < suffixes->size(); i += len) {
+        if (deadline.expired())
+          return false;
+        if (limit_results > 0 && res.size() == limit_results)
+          return false;
+        std::copy(
+            suffixes->begin() + i, suffixes->begin() + i + len,
+            tuple.begin() + j
+        );
+        res.add(tuple);
+        if (m_cache.recording()) {
+          m_cache.record(tuple);
+        }
+      }
+      return true;
+    }
+    m_cache.begin_record(j, key);
+    if (!search_cached_level(j, bound, tuple, res, deadline, limit_results))
+      return false;
+    m_cache.end_record();
+    return true;
+  };
+
+  // Binds the variable of level j and goes on with search_cached
+  template <class results_type>
+  bool search_cached_level(
+      const size_type j,
+      const uint64_t bound,
+      tuple_type &tuple,
+      results_type &res,
+      ::util::deadline &deadline,
+      const size_type limit_results
+  ) {
+    var_type x_j = m_veo.next();
+    vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+    const vector<state_type> &states = m_var_states[x_j];
+    const uint64_t bound_j = bound | (1ULL << x_j);
+    bool ok;
+    if (is_lonely(x_j)) { // Lonely variables
+      auto results = itrs[0]->seek_all(x_j);
+      for (const auto &c : results) {
+        tuple[j] = {x_j, c};
+        itrs[0]->down(states[0], c);
+        m_veo.down();
+        ok = search_cached(j + 1, bound_j, tuple, res, deadline, limit_results);
+        if (!ok) {
+          stop_level(x_j);
+          return false;
+        }
+        itrs[0]->up(x_j);
+        m_veo.up();
+      }
+    } else {
+      value_type c = seek(x_j);
+      while (c != 0) { // If empty c=0
+        tuple[j] = {x_j, c};
+        for (size_type i = 0; i < itrs.size(); ++i) {
+          itrs[i]->down(states[i], c);
+        }
+        m_veo.down();
+        ok = search_cached(j + 1, bound_j, tuple, res, deadline, limit_results);
+        if (!ok) {
+          stop_level(x_j);
+          return false;
+        }
+        for (ltj_iter_type *iter : itrs) {
+          iter->up(x_j);
+        }
+        m_veo.up();
+        c = seek(x_j, c + 1);
+      }
+    }
+    m_veo.done();
+    return true;
+  };
+
+  /**
+   * Counts the solutions of the suffix that starts at level j, using the
+   * cache of suffixes.
+   *
+   * @param j                 Index of the variable
+   * @param bound             Bound variables (bitmap)
+   * @param tuple             Tuple of the current search
+   * @param n                 Number of solutions of the suffix
+   * @param deadline          Deadline of the search
+   */
+  bool search_count_cached(
+      const size_type j,
+      const uint64_t bound,
+      tuple_type &tuple,
+      size_type &n,
+      ::util::deadline &deadline
+  ) {
+
+    // Check deadline and cancellation
+    if (deadline.expired())
+      return false;
+
+    n = 0;
+    if (j == m_veo.size()) {
+      n = 1;
+      return true;
+    }
+
+    typename cache_type::key_type key;
+    const bool cacheable = m_cache.cacheable(bound, j);
+    if (cacheable) {
+      m_cache.key(bound, tuple, j, key);
+      const size_type *cached = m_cache.find_count(key);
+      if (cached != nullptr) {
+        n = *cached;
+        return true;
+      }
+    }
+
+    var_type x_j = m_veo.next();
+    vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+    const vector<state_type> &states = m_var_states[x_j];
+    const uint64_t bound_j = bound | (1ULL << x_j);
+    size_type n_suffix;
+    bool ok;
+    if (is_lonely(x_j)) {
+      // Lonely variable: no other variable depends on its binding
+      const size_type n_x = m_var_filtered[x_j]
+                                ? itrs[0]->seek_all(x_j).size()
+                                : itrs[0]->subtree_size_fixed2();
+      if (n_x > 0) {
+        tuple[j] = {x_j, 0};
+        m_veo.down();
+        ok = search_count_cached(j + 1, bound_j, tuple, n_suffix, deadline);
+        if (!ok) {
+          m_veo.up();
+          m_veo.done();
+          return false;
+        }
+        m_veo.up();
+        n = n_x * n_suffix;
+      }
+    } else {
+      value_type c = seek(x_j);
+      while (c != 0) { // If empty c=0
+        tuple[j] = {x_j, c};
+        for (size_type i = 0; i < itrs.size(); ++i) {
+          itrs[i]->down(states[i], c);
+        }
+        m_veo.down();
+        ok = search_count_cached(j + 1, bound_j, tuple, n_suffix, deadline);
+        if (!ok) {
+          stop_level(x_j);
+          return false;
+        }
+        n += n_suffix;
+        for (ltj_iter_type *iter : itrs) {
+          iter->up(x_j);
+        }
+        m_veo.up();
+        c = seek(x_j, c + 1);
+      }
+    }
+    m_veo.done();
+    if (cacheable) {
+      m_cache.insert_count(key, n);
+    }
+    return true;
+  };
+
+  /**
+   *
+   * @param j                 Index of the variable
+   * @param factor            Solutions represented by the current bindings
+   * @param total             Number of solutions
+   * @param bound             Variables that are bound or already counted
+   * @param deadline          Deadline of the search
+   */
+  bool search_count(
+      const size_type j,
+      const size_type factor,
+      size_type &total,
+      vector<bool> &bound,
+      ::util::deadline &deadline
+  ) {
+
+    // Check deadline and cancellation
+    if (deadline.expired())
+      return false;
+
+    if (j == m_veo.size()) {
+      total += factor;
+    } else {
+      var_type x_j = m_veo.next();
+      vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+      const vector<state_type> &states = m_var_states[x_j];
+      bool ok;
+      if (bound[x_j]) { // Counted with its lonely partner
+        m_veo.down();
+        ok = search_count(j + 1, factor, total, bound, deadline);
+        if (!ok) {
+          m_veo.up();
+          m_veo.done();
+          return false;
+        }
+        m_veo.up();
+      } else if (is_lonely(x_j)) {
+        // Lonely variable: as many bindings as children (in its filter)
+        const size_type n = m_var_filtered[x_j]
+                                ? itrs[0]->seek_all(x_j).size()
+                                : itrs[0]->subtree_size_fixed2();
+        m_veo.down();
+        ok = search_count(j + 1, factor * n, total, bound, deadline);
+        if (!ok) {
+          m_veo.up();
+          m_veo.done();
+          return false;
+        }
+        m_veo.up();
+      } else {
+        const var_type y = (itrs.size() == 1 && !m_var_filtered[x_j])
+                               ? lonely_partner(itrs[0], x_j, bound)
+                               : x_j;
+        if (y != x_j && !m_var_filtered[y]) {
+          // Two lonely variables: as many bindings as leaves
+          bound[y] = true;
+          m_veo.down();
+          ok = search_count(
+              j + 1, factor * itrs[0]->subtree_size_fixed1(states[0]), total,
+              bound, deadline
+          );
+          if (!ok) {
+            m_veo.up();
+            m_veo.done();
+            return false;
+          }
+          m_veo.up();
+          bound[y] = false;
+        } else {
+          bound[x_j] = true;
+          value_type c = seek(x_j);
+          while (c != 0) { // If empty c=0
+            // 1. Going down in the tries by setting x_j = c
+            for (size_type i = 0; i < itrs.size(); ++i) {
+              itrs[i]->down(states[i], c);
+            }
+            m_veo.down();
+            // 2. Count with the next variable x_{j+1}
+            ok = search_count(j + 1, factor, total, bound, deadline);
+            if (!ok) {
+              stop_level(x_j);
+              return false;
+            }
+            // 3. Going up in the tries by removing x_j = c
+            for (ltj_iter_type *iter : itrs) {
+              iter->up(x_j);
+            }
+            m_veo.up();
+            // 4. Next constant for x_j
+            c = seek(x_j, c + 1);
+          }
+          bound[x_j] = false;
+        }
+      }
+      m_veo.done();
+    }
+    return true;
+  };
+
+  /**
+   *
+   * @param j                 Index of the variable
+   * @param n_bound           Number of projected variables that are bound
+   * @param mixed             Whether a variable that is not projected was
+   * bound before the projected ones (duplicates are possible)
+   * @param tuple             Tuple of the current search
+   * @param projected         Whether each variable is projected
+   * @param n_projected       Number of projected variables
+   * @param distinct          Removes duplicates
+   * @param reported          Reported tuples when mixed is true
+   * @param res               Results
+   * @param deadline          Deadline of the search
+   * @param limit_results     Limit of results
+   */
+  template <class results_type>
+  bool search_projected(
+      const size_type j,
+      const size_type n_bound,
+      const bool mixed,
+      tuple_type &tuple,
+      const vector<bool> &projected,
+      const size_type n_projected,
+      const bool distinct,
+      std::set<tuple_type> &reported,
+      results_type &res,
+      ::util::deadline &deadline,
+      const size_type limit_results
+  ) {
+
+    // Check deadline and cancellation
+    if (deadline.expired())
+      return false;
+
+    //(Optional) Check limit
+    if (limit_results > 0 && res.size() == limit_results)
+      return false;
+
+    if (n_bound == n_projected) {
+      // The rest of the variables are existential
+      size_type n = 0;
+      if (distinct) {
+        n = search_exists(j) ? 1 : 0;
+      } else {
+        vector<bool> bound(m_var_iterators.size(), false);
+        for (size_type i = 0; i < j; ++i) {
+          bound[tuple[i].first] = true;
+        }
+        if (!search_count(j, 1, n, bound, deadline))
+          return false;
+      }
+      if (n == 0)
+        return true;
+      tuple_type t;
+      t.reserve(n_projected);
+      for (size_type i = 0; i < j; ++i) {
+        if (projected[tuple[i].first])
+          t.push_back(tuple[i]);
+      }
+      if (distinct && mixed && !reported.insert(t).second)
+        return true;
+      for (size_type k = 0; k < n; ++k) {
+        if (limit_results > 0 && res.size() == limit_results)
+          return false;
+        res.add(t);
+      }
+      return true;
+    }
+
+    var_type x_j = m_veo.next();
+    vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+    const vector<state_type> &states = m_var_states[x_j];
+    const size_type n_bound_next = n_bound + (projected[x_j] ? 1 : 0);
+    const bool mixed_next = mixed || !projected[x_j];
+    bool ok;
+    if (is_lonely(x_j)) { // Lonely variables
+      auto results = itrs[0]->seek_all(x_j);
+      for (const auto &c : results) {
+        tuple[j] = {x_j, c};
+        itrs[0]->down(states[0], c);
+        m_veo.down();
+        ok = search_projected(
+            j + 1, n_bound_next, mixed_next, tuple, projected, n_projected,
+            distinct, reported, res, deadline, limit_results
+        );
+        if (!ok) {
+          stop_level(x_j);
+          return false;
+        }
+        itrs[0]->up(x_j);
+        m_veo.up();
+      }
+    } else {
+      value_type c = seek(x_j);
+      while (c != 0) { // If empty c=0
+        // 1. Adding result to tuple
+        tuple[j] = {x_j, c};
+        // 2. Going down in the tries by setting x_j = c
+        for (size_type i = 0; i < itrs.size(); ++i) {
+          itrs[i]->down(states[i], c);
+        }
+        m_veo.down();
+        // 3. Search with the next variable x_{j+1}
+        ok = search_projected(
+            j + 1, n_bound_next, mixed_next, tuple, projected, n_projected,
+            distinct, reported, res, deadline, limit_results
+        );
+        if (!ok) {
+          stop_level(x_j);
+          return false;
+        }
+        // 4. Going up in the tries by removing x_j = c
+        for (ltj_iter_type *iter : itrs) {
+          iter->up(x_j);
+        }
+        m_veo.up();
+        // 5. Next constant for x_j
+        c = seek(x_j, c + 1);
+      }
+    }
+    m_veo.done();
+    return true;
+  };
+
+  /**
+   *
+   * @param j                 Index of the variable
+   * @param tuple             Tuple of the current search
+   * @param emit              Functor called as emit(tuple) for each result
+   * @param page_size         Maximum number of results of the page
+   * @param n_page            Results reported in the page
+   * @param from              Last tuple reported by the previous page
+   * @param resuming          Whether the bindings so far are those of from
+   * @param token             Continuation token
+   * @param fingerprint       Fingerprint of the query
+   * @param deadline          Deadline of the search
+   * @return                  False if the search stopped before its end
+   */
+  template <class Emit>
+  bool search_page(
+      const size_type j,
+      tuple_type &tuple,
+      Emit &emit,
+      const size_type page_size,
+      size_type &n_page,
+      const tuple_type &from,
+      const bool resuming,
+      continuation_type &token,
+      const size_type fingerprint,
+      ::util::deadline &deadline
+  ) {
+
+    // Check deadline and cancellation
+    if (deadline.expired())
+      return false;
+
+    if (j == m_veo.size()) {
+      if (resuming) // Reported by the previous page
+        return true;
+      emit(tuple);
+      token.set(fingerprint, tuple);
+      return ++n_page < page_size;
+    }
+
+    var_type x_j = m_veo.next();
+    vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+    const vector<state_type> &states = m_var_states[x_j];
+    value_type start = 0;
+    if (resuming) {
+      if (from.size() != m_veo.size() || from[j].first != x_j) {
+        throw std::runtime_error(
+            "The continuation token does not match the index"
+        );
+      }
+      start = from[j].second;
+    }
+    bool ok;
+    if (is_lonely(x_j)) { // Lonely variables
+      auto results = itrs[0]->seek_all(x_j);
+      size_type i = 0;
+      if (resuming) { // First candidate >= start
+        size_type hi = results.size();
+        while (i < hi) {
+          const size_type mid = i + (hi - i) / 2;
+          if (results[mid] < start) {
+            i = mid + 1;
+          } else {
+            hi = mid;
+          }
+        }
+      }
+      for (; i < results.size(); ++i) {
+        const value_type c = results[i];
+        tuple[j] = {x_j, c};
+        itrs[0]->down(states[0], c);
+        m_veo.down();
+        ok = search_page(
+            j + 1, tuple, emit, page_size, n_page, from,
+            resuming && c == start, token, fingerprint, deadline
+        );
+        if (!ok) {
+          stop_level(x_j);
+          return false;
+        }
+        itrs[0]->up(x_j);
+        m_veo.up();
+      }
+    } else {
+      value_type c = resuming ? seek_from(x_j, start) : seek(x_j);
+      while (c != 0) { // If empty c=0
+        // 1. Adding result to tuple
+        tuple[j] = {x_j, c};
+        // 2. Going down in the tries by setting x_j = c
+        for (size_type i = 0; i < itrs.size(); ++i) {
+          itrs[i]->down(states[i], c);
+        }
+        m_veo.down();
+        // 3. Search with the next variable x_{j+1}
+        ok = search_page(
+            j + 1, tuple, emit, page_size, n_page, from,
+            resuming && c == start, token, fingerprint, deadline
+        );
+        if (!ok) {
+          stop_level(x_j);
+          return false;
+        }
+        // 4. Going up in the tries by removing x_j = c
+        for (ltj_iter_type *iter : itrs) {
+          iter->up(x_j);
+        }
+        m_veo.up();
+        // 5. Next constant for x_j
+        c = seek(x_j, c + 1);
+      }
+    }
+    m_veo.done();
+    return true;
+  };
+
+  /*
+      Checks if the current bindings can be extended to a solution. It stops
+      at the first one and leaves the iterators and the VEO as they were.
+  */
+  bool search_exists(const size_type j) {
+    if (j == m_veo.size())
+      return true;
+    var_type x_j = m_veo.next();
+    vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+    const vector<state_type> &states = m_var_states[x_j];
+    bool found = false;
+    if (is_lonely(x_j) && !m_var_filtered[x_j]) {
+      // Lonely variable: the node has children and no other variable
+      // depends on its binding
+      m_veo.down();
+      found = search_exists(j + 1);
+      m_veo.up();
+    } else {
+      value_type c = seek(x_j);
+      while (c != 0 && !found) {
+        for (size_type i = 0; i < itrs.size(); ++i) {
+          itrs[i]->down(states[i], c);
+        }
+        m_veo.down();
+        found = search_exists(j + 1);
+        for (ltj_iter_type *iter : itrs) {
+          iter->up(x_j);
+        }
+        m_veo.up();
+        if (!found)
+          c = seek(x_j, c + 1);
+      }
+      if (c != 0) { // The range was not exhausted by seek
+        for (auto &itr : itrs) {
+          itr->leap_done();
+        }
+      }
+    }
+    m_veo.done();
+    return found;
+  }
+
+  /**
+   *
+   * @param j                 Index of the variable
+   * @param tuple             Bindings of the current search
+   * @param factors           Ranges of the lonely variables of the search
+   * @param res               Results
+   * @param deadline          Deadline of the search
+   * @param limit_results     Limit of entries of the results
+   */
+  template <class results_type>
+  bool search_factorized(
+      const size_type j,
+      tuple_type &tuple,
+      factors_type &factors,
+      results_type &res,
+      ::util::deadline &deadline,
+      const size_type limit_results = 0
+  ) {
+
+    // Check deadline and cancellation
+    if (deadline.expired())
+      return false;
+
+    //(Optional) Check limit
+    if (limit_results > 0 && res.size() == limit_results)
+      return false;
+
+    if (j == m_veo.size()) {
+      res.add(tuple, factors);
+    } else {
+      var_type x_j = m_veo.next();
+      vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+      const vector<state_type> &states = m_var_states[x_j];
+      bool ok;
+      if (is_lonely(x_j)) {
+        // Lonely variable: its range is reported instead of its bindings.
+        // No other variable is bound by this iterator, so it stays as it is.
+        // A filter can clip the range to empty, and then there are no
+        // solutions under the current bindings.
+        const range_type range = itrs[0]->seek_all(x_j);
+        if (!range.empty()) {
+          factors.emplace_back(x_j, range);
+          m_veo.down();
+          ok = search_factorized(
+              j + 1, tuple, factors, res, deadline, limit_results
+          );
+          if (!ok) {
+            m_veo.up();
+            m_veo.done();
+            return false;
+          }
+          m_veo.up();
+          factors.pop_back();
+        }
+      } else {
+        value_type c = seek(x_j);
+        while (c != 0) { // If empty c=0
+          // 1. Adding result to tuple
+          tuple.emplace_back(x_j, c);
+          // 2. Going down in the tries by setting x_j = c
+          for (size_type i = 0; i < itrs.size(); ++i) {
+            itrs[i]->down(states[i], c);
+          }
+          m_veo.down();
+          // 3. Search with the next variable x_{j+1}
+          ok = search_factorized(
+              j + 1, tuple, factors, res, deadline, limit_results
+          );
+          if (!ok) {
+            stop_level(x_j);
+            return false;
+          }
+          // 4. Going up in the tries by removing x_j = c
+          for (ltj_iter_type *iter : itrs) {
+            iter->up(x_j);
+          }
+          m_veo.up();
+          tuple.pop_back();
+          // 5. Next constant for x_j
+          c = seek(x_j, c + 1);
+        }
+      }
+      m_veo.done();
+    }
+    return true;
+  };
+
+  template <class Expired>
+  bool cursor_next(tuple_type &tuple, Expired expired) {
+    if (m_is_empty || m_cursor_finished)
+      return false;
+    if (!m_cursor_started) {
+      m_cursor_started = true;
+      m_cursor_tuple.resize(m_veo.size());
+      if (m_veo.size() == 0) { // Only the empty solution
+        m_cursor_finished = true;
+        tuple = m_cursor_tuple;
+        return true;
+      }
+      m_cursor_frames.reserve(m_veo.size());
+      cursor_push();
+    }
+    while (!m_cursor_frames.empty()) {
+      if (expired())
+        return false;
+      cursor_frame_type &f = m_cursor_frames.back();
+      // Going up in the tries by removing the previous binding
+      if (f.bound) {
+        cursor_up(f);
+      }
+      if (cursor_advance(f)) {
+        // Going down in the tries by setting x_j = c
+        const size_type j = m_cursor_frames.size() - 1;
+        m_cursor_tuple[j] = {f.var, f.c};
+        cursor_down(f);
+        if (j + 1 == m_veo.size()) {
+          tuple = m_cursor_tuple;
+          return true;
+        }
+        cursor_push();
+      } else {
+        if (!f.lonely) {
+          m_stats.end(m_var_iterators[f.var], f.var);
+        }
+        m_veo.done();
+        m_cursor_frames.pop_back();
+      }
+    }
+    m_cursor_finished = true;
+    return false;
+  }
+
+  // Opens the next level of the VEO
+  void cursor_push() {
+    cursor_frame_type f;
+    f.var = m_veo.next();
+    vector<ltj_iter_type *> &itrs = m_var_iterators[f.var];
+    f.lonely = is_lonely(f.var);
+    if (f.lonely) {
+      f.range = itrs[0]->seek_all(f.var);
+    } else {
+      m_stats.begin(itrs, f.var, m_cursor_frames.size());
+    }
+    f.pos = 0;
+    f.c = 0;
+    f.bound = false;
+    m_cursor_frames.push_back(f);
+  }
+
+  // Next candidate of the level. Returns false when there are no more.
+  bool cursor_advance(cursor_frame_type &f) {
+    if (f.lonely) {
+      if (f.pos == f.range.size())
+        return false;
+      f.c = f.range[f.pos++];
+      return true;
+    }
+    f.c = (f.c == 0) ? seek(f.var) : seek(f.var, f.c + 1);
+    if (f.c == 0)
+      return false;
+    m_stats.add_result();
+    return true;
+  }
+
+  void cursor_down(cursor_frame_type &f) {
+    vector<ltj_iter_type *> &itrs = m_var_iterators[f.var];
+    const vector<state_type> &states = m_var_states[f.var];
+    for (size_type i = 0; i < itrs.size(); ++i) {
+      itrs[i]->down(states[i], f.c);
+    }
+    m_veo.down();
+    f.bound = true;
+  }
+
+  void cursor_up(cursor_frame_type &f) {
+    for (ltj_iter_type *iter : m_var_iterators[f.var]) {
+      iter->up(f.var);
+    }
+    m_veo.up();
+    f.bound = false;
+  }
+
+  /**
+   *
+   * @param x_j   Variable
+   * @param c     Constant. If it is unknown the value is -1
+   * @return      The next constant that matches the intersection between the
+   * triples of x_j. If the intersection is empty, it returns 0.
+   */
+
+  value_type seek(const var_type x_j, value_type c = -1) {
+    vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+    vector<state_type> &states = m_var_states[x_j];
+    if (c == -1 && itrs.size() > 1) {
+      sort_iterators(x_j);
+    }
+    if (m_var_skewed[x_j])
+      return seek_skewed(x_j, c);
+    if (c != -1) {
+      prefetch(x_j, 0);
+    }
+    value_type c_i, c_prev = 0, i = 0, n_ok = 0;
+
+    while (true) {
+      // Compute leap for each triple that contains x_j
+      // std::cout << "Leap of " << (::uint64_t) x_j << " in iterator: " << i <<
+      // std::endl;
       if (c == -1) {
-        c_i = itrs[i]->leap(x_j);
+        c_i = itrs[i]->leap(states[i]);
       } else {
-        c_i = itrs[i]->leap(x_j, c);
+        c_i = itrs[i]->leap(states[i], c);
       }
       // std::cout << "Gets " << (::uint64_t) c_i << std::endl;
+      m_stats.add_seek();
       if (c_i == 0) {
         for (auto &itr : itrs) {
           itr->leap_done();
@@ -513,6 +2756,86 @@ public:
     }
   }
 
+  /*
+      First seek of x_j at the current node, from c instead of from its
+      first value (a split or resumed range). The iterators are sorted and
+      m_var_skewed is set for this node, as in seek(x_j).
+  */
+  value_type seek_from(const var_type x_j, const value_type c) {
+    if (m_var_iterators[x_j].size() > 1) {
+      sort_iterators(x_j);
+    }
+    return seek(x_j, c);
+  }
+
+  /*
+      Prefetches the next probes of the iterators of x_j from the i-th one,
+      so their cache misses overlap instead of being paid one per leap.
+  */
+  inline void prefetch(const var_type x_j, size_type i) {
+    const vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+    const vector<state_type> &states = m_var_states[x_j];
+    for (; i < itrs.size(); ++i) {
+      itrs[i]->prefetch(states[i]);
+    }
+  }
+
+  /*
+      Sorts the iterators of x_j by their number of children, when a new
+      node is intersected, so the leapfrog starts with the smallest list.
+      If the largest one is seek_skew_ratio times larger, the intersection
+      is driven by the smallest one.
+  */
+  void sort_iterators(const var_type x_j) {
+    vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+    vector<state_type> &states = m_var_states[x_j];
+    vector<size_type> &sizes = m_seek_sizes;
+    for (size_type i = 0; i < itrs.size(); ++i) {
+      sizes[i] = itrs[i]->children(states[i]);
+      for (size_type k = i; k > 0 && sizes[k] < sizes[k - 1]; --k) {
+        std::swap(sizes[k], sizes[k - 1]);
+        std::swap(itrs[k], itrs[k - 1]);
+        std::swap(states[k], states[k - 1]);
+      }
+    }
+    m_var_skewed[x_j] = sizes[itrs.size() - 1] / seek_skew_ratio > sizes[0];
+  }
+
+  /*
+      The smallest list (the first one) proposes the candidates and the
+      others only check them (in increasing order of size). When one of them
+      does not have the candidate, the smallest list leaps to its next value.
+  */
+  value_type seek_skewed(const var_type x_j, value_type c) {
+    vector<ltj_iter_type *> &itrs = m_var_iterators[x_j];
+    const vector<state_type> &states = m_var_states[x_j];
+    c = (c == -1) ? itrs[0]->leap(states[0]) : itrs[0]->leap(states[0], c);
+    m_stats.add_seek();
+    size_type i = 1;
+    while (c != 0) {
+      if (i == itrs.size())
+        return c;
+      if (i == 1) { // New candidate: the probes are independent
+        prefetch(x_j, 1);
+      }
+      const value_type c_i = itrs[i]->leap(states[i], c);
+      m_stats.add_seek();
+      if (c_i == c) {
+        ++i;
+      } else if (c_i == 0) {
+        c = 0;
+      } else {
+        c = itrs[0]->leap(states[0], c_i);
+        m_stats.add_seek();
+        i = 1;
+      }
+    }
+    for (auto &itr : itrs) {
+      itr->leap_done();
+    }
+    return 0;
+  }
+
   void print_veo(unordered_map<uint8_t, string> &ht) {
     cout << "veo: ";
     for (uint64_t j = 0; j < m_veo.size(); ++j) {
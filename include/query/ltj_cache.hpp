@@ -0,0 +1,351 @@
+#ifndef LTJ_CACHE_HPP
+#define LTJ_CACHE_HPP
+
+#include <cstdint>
+#include <triple_pattern.hpp>
+#include <unordered_map>
+#include <util/lru_cache.hpp>
+#include <utility>
+#include <vector>
+
+namespace ltj {
+
+/**
+ * @brief Cache of the results of the suffixes of a search (cached LTJ).
+ *
+ * Once some variables are bound, the solutions of the remaining ones only
+ * depend on the bindings of the adhesion: the bound variables that share a
+ * triple pattern with some unbound variable. When the adhesion is smaller
+ * than the set of bound variables, the same suffix is solved again for every
+ * binding of the other ones (e.g. in the path ?a p ?b . ?b p ?c . ?c p ?d,
+ * the suffix ?c, ?d only depends on ?b). The cache stores the number of
+ * solutions or the list of solutions of a suffix, keyed by the bound
+ * variables and the bindings of their adhesion, and evicts the least recently
+ * used entries. The decision is taken for each set of bound variables: it is
+ * only cached when some pattern of the suffix joins two unbound variables,
+ * and it stops being cached if the first lookups rarely hit.
+ *
+ * The sets of variables are bitmaps, so it supports up to 64 variables.
+ */
+template <class var_t = uint8_t, class value_t = uint64_t> class ltj_cache {
+
+public:
+  typedef uint64_t size_type;
+  typedef var_t var_type;
+  typedef value_t value_type;
+  typedef uint64_t mask_type;
+  typedef std::vector<std::pair<var_type, value_type>> tuple_type;
+  // Bound variables followed by the bindings of the adhesion
+  typedef std::vector<uint64_t> key_type;
+
+  static constexpr size_type max_vars = 64;
+  // Lookups of a set of bound variables before checking its hit ratio
+  static constexpr size_type min_lookups = 1024;
+  // Minimum ratio of hits (1 / min_hit_inverse) to keep caching it
+  static constexpr size_type min_hit_inverse = 4;
+
+private:
+  struct key_hash {
+    size_type operator()(const key_type &key) const {
+      size_type h = 14695981039346656037ULL;
+      for (const uint64_t x : key) {
+        h ^= x;
+        h *= 1099511628211ULL;
+      }
+      return h;
+    }
+  };
+
+  // Solutions of a suffix that are being collected
+  struct recorder_type {
+    size_type j; // First level of the suffix
+    key_type key;
+    tuple_type tuples; // Concatenated
+    bool overflow;     // Too many solutions to be cached
+  };
+
+  size_type m_max_list = 0;
+  std::vector<mask_type> m_neighbors; // Variables that share a pattern
+  std::vector<mask_type> m_patterns;  // Variables of each pattern
+  mask_type m_vars = 0;               // Variables of the query
+  struct bound_info_type {
+    mask_type adhesion;
+    bool active; // Worth caching
+    size_type lookups;
+    size_type hits;
+  };
+  std::unordered_map<mask_type, bound_info_type> m_info;
+  ::util::lru_cache<key_type, size_type, key_hash> m_counts;
+  ::util::lru_cache<key_type, tuple_type, key_hash> m_lists;
+  std::vector<recorder_type> m_recorders;
+  bool m_enabled = false;
+  // Last set of bound variables of each level, to avoid hashing it again
+  std::vector<std::pair<mask_type, bound_info_type *>> m_last;
+  bound_info_type *m_probe = nullptr; // Set of the last key
+
+  void copy(const ltj_cache &o) {
+    m_max_list = o.m_max_list;
+    m_neighbors = o.m_neighbors;
+    m_patterns = o.m_patterns;
+    m_vars = o.m_vars;
+    m_info = o.m_info;
+    m_counts = o.m_counts;
+    m_lists = o.m_lists;
+    m_recorders = o.m_recorders;
+    m_enabled = o.m_enabled;
+    m_last.assign(o.m_last.size(), {-1ULL, nullptr});
+  }
+
+  /*
+      Adhesion of the suffix after binding the variables of bound. The
+      suffix is not worth caching when the adhesion is not smaller, or when
+      no pattern has two unbound variables (the suffix is a product of
+      independent intersections, cheaper than the cache).
+  */
+  bound_info_type *info(const mask_type bound) {
+    auto it = m_info.find(bound);
+    if (it != m_info.end())
+      return &(it->second);
+    mask_type adh = 0, unbound = m_vars & ~bound;
+    for (size_type v = 0; v < m_neighbors.size(); ++v) {
+      if (unbound >> v & 1)
+        adh |= m_neighbors[v] & bound;
+    }
+    bool joins = false;
+    for (const mask_type mask : m_patterns) {
+      const mask_type x = mask & unbound;
+      joins = joins || (x & (x - 1)) != 0;
+    }
+    bound_info_type b = {adh, joins && adh != bound, 0, 0};
+    return &(m_info.insert({bound, b}).first->second);
+  }
+
+  inline void lookup(const bool hit) {
+    ++m_probe->lookups;
+    m_probe->hits += hit;
+    if (m_probe->lookups == min_lookups &&
+        m_probe->hits * min_hit_inverse < m_probe->lookups) {
+      m_probe->active = false;
+    }
+  }
+
+public:
+  ltj_cache() = default;
+
+  /**
+   * Enables the cache when some suffix can be reused, that is, when there
+   * are two variables that do not share any triple pattern (otherwise the
+   * adhesion is always the whole set of bound variables).
+   *
+   * @param patterns  Triple patterns of the query
+   * @param capacity  Maximum number of entries of each cache
+   * @param max_list  Suffixes with more solutions are not cached
+   * @return          True if it was enabled
+   */
+  bool enable(
+      const std::vector<triple_pattern> &patterns,
+      const size_type capacity,
+      const size_type max_list
+  ) {
+    m_enabled = false;
+    m_neighbors.assign(max_vars, 0);
+    m_patterns.clear();
+    m_info.clear();
+    m_vars = 0;
+    for (const auto &triple : patterns) {
+      const term_pattern *terms[3] = {
+          &triple.term_s, &triple.term_p, &triple.term_o
+      };
+      mask_type mask = 0;
+      for (const term_pattern *term : terms) {
+        if (!term->is_variable)
+          continue;
+        if (term->value >= max_vars)
+          return false;
+        mask |= 1ULL << term->value;
+      }
+      for (size_type v = 0; v < max_vars; ++v) {
+        if (mask >> v & 1)
+          m_neighbors[v] |= mask;
+      }
+      m_vars |= mask;
+      m_patterns.push_back(mask);
+    }
+    bool reusable = false;
+    for (size_type v = 0; v < max_vars && !reusable; ++v) {
+      reusable = (m_vars >> v & 1) && (m_neighbors[v] & m_vars) != m_vars;
+    }
+    if (!reusable || capacity == 0)
+      return false;
+    m_max_list = max_list;
+    m_last.assign(max_vars + 1, {-1ULL, nullptr});
+    m_counts.capacity(capacity);
+    m_lists.capacity(capacity);
+    m_enabled = true;
+    return true;
+  }
+
+  inline bool enabled() const {
+    return m_enabled;
+  }
+
+  /**
+   * Whether the suffix that starts at level j is worth caching.
+   *
+   * @param bound     Bound variables
+   * @param j         Level
+   */
+  inline bool cacheable(const mask_type bound, const size_type j) {
+    if (!m_enabled || j == 0)
+      return false;
+    // With a static VEO the set of bound variables of a level never changes
+    if (m_last[j].first != bound) {
+      m_last[j] = {bound, info(bound)};
+    }
+    m_probe = m_last[j].second;
+    return m_probe->active;
+  }
+
+  /**
+   * Key of the suffix of the last call to cacheable(): the bound variables
+   * and the bindings of the adhesion.
+   *
+   * @param bound     Bound variables
+   * @param tuple     Bindings of the levels before j
+   * @param j         Level
+   * @param key       Output key
+   */
+  void key(
+      const mask_type bound,
+      const tuple_type &tuple,
+      const size_type j,
+      key_type &key
+  ) const {
+    const mask_type adh = m_probe->adhesion;
+    // Bindings in order of variable, since the VEO may bind them in
+    // different orders
+    value_type values[max_vars];
+    for (size_type i = 0; i < j; ++i) {
+      values[tuple[i].first] = tuple[i].second;
+    }
+    key.clear();
+    key.push_back(bound);
+    for (size_type v = 0; v < max_vars; ++v) {
+      if (adh >> v & 1)
+        key.push_back(values[v]);
+    }
+  }
+
+  // Must be called after cacheable() and key()
+  inline const size_type *find_count(const key_type &key) {
+    const size_type *n = m_counts.find(key);
+    lookup(n != nullptr);
+    return n;
+  }
+
+  inline void insert_count(const key_type &key, const size_type n) {
+    m_counts.insert(key, n);
+  }
+
+  // Solutions of a suffix, concatenated
+  inline const tuple_type *find_list(const key_type &key) {
+    const tuple_type *list = m_lists.find(key);
+    lookup(list != nullptr);
+    return list;
+  }
+
+  // Starts collecting the solutions of the suffix of level j
+  inline void begin_record(const size_type j, const key_type &key) {
+    m_recorders.push_back({j, key, tuple_type(), false});
+  }
+
+  // Adds a solution to the suffixes that are being collected
+  void record(const tuple_type &tuple) {
+    for (auto &rec : m_recorders) {
+      if (rec.overflow)
+        continue;
+      if (rec.tuples.size() >= m_max_list * (tuple.size() - rec.j)) {
+        rec.overflow = true;
+        rec.tuples = tuple_type();
+        continue;
+      }
+      rec.tuples.insert(rec.tuples.end(), tuple.begin() + rec.j, tuple.end());
+    }
+  }
+
+  // The suffix of the last begin_record was solved completely
+  void end_record() {
+    recorder_type &rec = m_recorders.back();
+    if (!rec.overflow) {
+      m_lists.insert(rec.key, std::move(rec.tuples));
+    }
+    m_recorders.pop_back();
+  }
+
+  // Discards the suffixes of a search that did not finish
+  inline void reset_records() {
+    m_recorders.clear();
+  }
+
+  inline bool recording() const {
+    return !m_recorders.empty();
+  }
+
+  void clear() {
+    m_counts.clear();
+    m_lists.clear();
+    m_recorders.clear();
+  }
+
+  //! Copy constructor
+  ltj_cache(const ltj_cache &o) {
+    copy(o);
+  }
+
+  //! Move constructor
+  ltj_cache(ltj_cache &&o) {
+    *this = std::move(o);
+  }
+
+  //! Copy Operator=
+  ltj_cache &operator=(const ltj_cache &o) {
+    if (this != &o) {
+      copy(o);
+    }
+    return *this;
+  }
+
+  //! Move Operator=
+  ltj_cache &operator=(ltj_cache &&o) {
+    if (this != &o) {
+      m_max_list = o.m_max_list;
+      m_neighbors = std::move(o.m_neighbors);
+      m_patterns = std::move(o.m_patterns);
+      m_vars = o.m_vars;
+      m_info = std::move(o.m_info);
+      m_counts = std::move(o.m_counts);
+      m_lists = std::move(o.m_lists);
+      m_recorders = std::move(o.m_recorders);
+      m_enabled = o.m_enabled;
+      m_last = std::move(o.m_last);
+    }
+    return *this;
+  }
+
+  void swap(ltj_cache &o) {
+    std::swap(m_max_list, o.m_max_list);
+    std::swap(m_neighbors, o.m_neighbors);
+    std::swap(m_patterns, o.m_patterns);
+    std::swap(m_vars, o.m_vars);
+    std::swap(m_info, o.m_info);
+    m_counts.swap(o.m_counts);
+    m_lists.swap(o.m_lists);
+    std::swap(m_recorders, o.m_recorders);
+    std::swap(m_enabled, o.m_enabled);
+    std::swap(m_last, o.m_last);
+  }
+};
+
+} // namespace ltj
+
+#endif // LTJ_CACHE_HPP
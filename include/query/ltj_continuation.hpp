@@ -0,0 +1,144 @@
+#ifndef LTJ_CONTINUATION_HPP
+#define LTJ_CONTINUATION_HPP
+
+#include <cstdint>
+#include <string>
+#include <triple_pattern.hpp>
+#include <utility>
+#include <vector>
+
+namespace ltj {
+
+/**
+ * @brief Position of a paused search, so it can be resumed later.
+ *
+ * LTJ reports the solutions in lexicographic order of their bindings (in the
+ * order given by the VEO), hence the last reported tuple is enough to resume
+ * the search: every level seeks again from its binding in that tuple. The
+ * VEO is deterministic for a given query and index, so the token is only
+ * valid for the same query (checked with a fingerprint) and the same version
+ * of the index.
+ */
+template <class var_t = uint8_t, class value_t = uint64_t>
+class ltj_continuation {
+
+public:
+  typedef uint64_t size_type;
+  typedef var_t var_type;
+  typedef value_t value_type;
+  typedef std::vector<std::pair<var_type, value_type>> tuple_type;
+
+private:
+  size_type m_fingerprint = 0;
+  bool m_finished = false;
+  tuple_type m_last; // Last reported tuple (empty before the first one)
+
+  static void put_varint(std::string &out, uint64_t x) {
+    while (x >= 0x80) {
+      out.push_back((char)((x & 0x7F) | 0x80));
+      x >>= 7;
+    }
+    out.push_back((char)x);
+  }
+
+  static bool get_varint(const std::string &in, size_type &pos, uint64_t &x) {
+    x = 0;
+    for (size_type shift = 0; pos < in.size() && shift < 64; shift += 7) {
+      const uint8_t b = (uint8_t)in[pos++];
+      x |= (uint64_t)(b & 0x7F) << shift;
+      if (!(b & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+public:
+  ltj_continuation() = default;
+
+  // FNV-1a hash of the triple patterns
+  static size_type fingerprint(const std::vector<triple_pattern> &patterns) {
+    size_type h = 14695981039346656037ULL;
+    auto mix = [&h](const uint64_t x) {
+      h ^= x;
+      h *= 1099511628211ULL;
+    };
+    for (const auto &triple : patterns) {
+      const term_pattern *terms[3] = {
+          &triple.term_s, &triple.term_p, &triple.term_o
+      };
+      for (const term_pattern *term : terms) {
+        mix(term->is_variable);
+        mix(term->value);
+      }
+    }
+    return h;
+  }
+
+  inline bool started() const {
+    return !m_last.empty() || m_finished;
+  }
+
+  inline bool finished() const {
+    return m_finished;
+  }
+
+  inline const tuple_type &last() const {
+    return m_last;
+  }
+
+  inline size_type query_fingerprint() const {
+    return m_fingerprint;
+  }
+
+  // Called by the search
+  inline void set(const size_type fingerprint, const tuple_type &last) {
+    m_fingerprint = fingerprint;
+    m_last = last;
+  }
+
+  inline void finish(const size_type fingerprint) {
+    m_fingerprint = fingerprint;
+    m_finished = true;
+  }
+
+  /*
+      Compact binary representation: fingerprint, finished flag, and the
+      pairs of the last tuple, as variable-length integers
+  */
+  std::string encode() const {
+    std::string out;
+    put_varint(out, m_fingerprint);
+    put_varint(out, m_finished);
+    put_varint(out, m_last.size());
+    for (const auto &b : m_last) {
+      put_varint(out, b.first);
+      put_varint(out, b.second);
+    }
+    return out;
+  }
+
+  // Returns false if the string is not a valid token
+  bool decode(const std::string &in) {
+    size_type pos = 0;
+    uint64_t fingerprint, finished, n, var, value;
+    if (!get_varint(in, pos, fingerprint) || !get_varint(in, pos, finished) ||
+        !get_varint(in, pos, n))
+      return false;
+    tuple_type last;
+    for (uint64_t i = 0; i < n; ++i) {
+      if (!get_varint(in, pos, var) || !get_varint(in, pos, value))
+        return false;
+      last.emplace_back((var_type)var, (value_type)value);
+    }
+    if (pos != in.size())
+      return false;
+    m_fingerprint = fingerprint;
+    m_finished = finished != 0;
+    m_last = std::move(last);
+    return true;
+  }
+};
+
+} // namespace ltj
+
+#endif // LTJ_CONTINUATION_HPP
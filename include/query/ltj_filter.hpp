@@ -0,0 +1,146 @@
+#ifndef LTJ_FILTER_HPP
+#define LTJ_FILTER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+namespace ltj {
+
+/**
+ * @brief Restriction of the values of a variable (FILTER): a range [lo, hi]
+ * of ids and, optionally, a set of ids.
+ *
+ * It is pushed into the iterators, so leap only returns values that pass the
+ * filter and seek_all only returns the part of the range in [lo, hi]. The
+ * join skips the candidates that do not pass it without going down into
+ * their subtrees.
+ */
+template <class value_t = uint64_t> class ltj_filter {
+
+public:
+  typedef uint64_t size_type;
+  typedef value_t value_type;
+
+private:
+  value_type m_lo = 1; // Ids start at 1
+  value_type m_hi = std::numeric_limits<value_type>::max();
+  bool m_has_set = false;
+  std::vector<value_type> m_values; // Sorted, inside [lo, hi]
+
+  void clip_values() {
+    auto beg = std::lower_bound(m_values.begin(), m_values.end(), m_lo);
+    auto end = std::upper_bound(beg, m_values.end(), m_hi);
+    m_values = std::vector<value_type>(beg, end);
+  }
+
+  // First position of the range whose value is not smaller than c
+  template <class Range>
+  static size_type lower_bound(const Range &r, const value_type c) {
+    size_type i = 0, f = r.size();
+    while (i < f) {
+      const size_type mid = (i + f) / 2;
+      if (r[mid] < c) {
+        i = mid + 1;
+      } else {
+        f = mid;
+      }
+    }
+    return i;
+  }
+
+public:
+  //! Without restrictions
+  ltj_filter() = default;
+
+  //! Range [lo, hi] (both included)
+  ltj_filter(const value_type lo, const value_type hi)
+      : m_lo(std::max<value_type>(lo, 1)), m_hi(hi) {
+  }
+
+  //! Set of values
+  explicit ltj_filter(std::vector<value_type> values)
+      : m_has_set(true), m_values(std::move(values)) {
+    std::sort(m_values.begin(), m_values.end());
+    m_values.erase(
+        std::unique(m_values.begin(), m_values.end()), m_values.end()
+    );
+    clip_values();
+  }
+
+  // Keeps only the values that pass both filters
+  void intersect(const ltj_filter &o) {
+    m_lo = std::max(m_lo, o.m_lo);
+    m_hi = std::min(m_hi, o.m_hi);
+    if (o.m_has_set) {
+      if (m_has_set) {
+        std::vector<value_type> values;
+        std::set_intersection(
+            m_values.begin(), m_values.end(), o.m_values.begin(),
+            o.m_values.end(), std::back_inserter(values)
+        );
+        m_values = std::move(values);
+      } else {
+        m_values = o.m_values;
+        m_has_set = true;
+      }
+    }
+    clip_values();
+  }
+
+  inline value_type lo() const {
+    return m_lo;
+  }
+
+  inline value_type hi() const {
+    return m_hi;
+  }
+
+  inline bool has_set() const {
+    return m_has_set;
+  }
+
+  // Values of the set (empty if it has no set)
+  inline const std::vector<value_type> &values() const {
+    return m_values;
+  }
+
+  // No value passes the filter
+  inline bool empty() const {
+    return m_lo > m_hi || (m_has_set && m_values.empty());
+  }
+
+  inline bool contains(const value_type v) const {
+    if (v < m_lo || v > m_hi)
+      return false;
+    return !m_has_set ||
+           std::binary_search(m_values.begin(), m_values.end(), v);
+  }
+
+  // Smallest value not smaller than c that passes the filter (0 if none)
+  inline value_type next(value_type c) const {
+    if (c < m_lo)
+      c = m_lo;
+    if (c > m_hi)
+      return 0;
+    if (!m_has_set)
+      return c;
+    auto it = std::lower_bound(m_values.begin(), m_values.end(), c);
+    return (it == m_values.end()) ? 0 : *it;
+  }
+
+  // Part of a sorted range inside [lo, hi] (the set is not applied)
+  template <class Range> Range clip(const Range &r) const {
+    const size_type beg = lower_bound(r, m_lo);
+    const size_type end = (m_hi == std::numeric_limits<value_type>::max())
+                              ? r.size()
+                              : lower_bound(r, m_hi + 1);
+    return r.slice(beg, std::max(beg, end));
+  }
+};
+
+} // namespace ltj
+
+#endif // LTJ_FILTER_HPP
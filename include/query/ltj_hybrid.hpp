@@ -0,0 +1,483 @@
+#ifndef LTJ_HYBRID_HPP
+#define LTJ_HYBRID_HPP
+
+#include <array>
+#include <cltj_config.hpp>
+#include <cltj_utils.hpp>
+#include <cstdint>
+#include <memory>
+#include <query/ltj_algorithm.hpp>
+#include <query/ltj_join_tree.hpp>
+#include <triple_pattern.hpp>
+#include <unordered_map>
+#include <util/deadline.hpp>
+#include <vector>
+
+namespace ltj {
+
+/**
+ * @brief Hybrid plan: LTJ for the cyclic core of a query and binary joins for
+ * the trees that hang from it.
+ *
+ * The GYO reduction (ltj_join_tree) splits the query into its cyclic core
+ * and the patterns removed as ears. The core is solved with ltj_algorithm
+ * (pulling its solutions with the cursor), or, if the query is acyclic, the
+ * pattern with fewest triples is used as the core. The other patterns are
+ * joined one by one, each one sharing some variable with the previous ones
+ * when possible, smallest first. A pattern with few triples is scanned once
+ * into a hash table keyed by its bound variables (hash join), the others are
+ * probed for each row with leap on their iterator (index nested loop join).
+ * The sub-results flow between the stages in columnar batches.
+ */
+template <
+    class iterator_t = ltj_iterator_lite<cltj::compact_ltj, uint8_t, uint64_t>,
+    class veo_t = veo::veo_adaptive<iterator_t, util::trait_size>>
+class ltj_hybrid {
+
+public:
+  typedef uint64_t size_type;
+  typedef iterator_t ltj_iter_type;
+  typedef typename ltj_iter_type::var_type var_type;
+  typedef typename ltj_iter_type::value_type const_type;
+  typedef typename ltj_iter_type::index_scheme_type index_scheme_type;
+  typedef ltj_algorithm<iterator_t, veo_t> algorithm_type;
+  typedef typename algorithm_type::tuple_type tuple_type;
+  typedef ltj_join_tree<var_type> join_tree_type;
+
+  // Rows of a batch before it is passed to the next stage
+  static constexpr size_type default_batch_size = 1024;
+  // Patterns with at most this number of triples are hash joined
+  static constexpr size_type default_hash_size = 1 << 16;
+
+  //! Sub-results in columnar form, a column of values per variable
+  struct batch_type {
+    std::vector<var_type> vars;
+    std::vector<std::vector<const_type>> columns;
+    size_type rows = 0;
+
+    void clear() {
+      for (auto &column : columns) {
+        column.clear();
+      }
+      rows = 0;
+    }
+  };
+
+private:
+  static constexpr size_type npos = -1ULL;
+
+  // Bindings of the bound variables of a pattern (at most three)
+  typedef std::array<const_type, 3> key_type;
+
+  struct key_hash {
+    size_type operator()(const key_type &key) const {
+      size_type h = 14695981039346656037ULL;
+      for (const const_type x : key) {
+        h ^= x;
+        h *= 1099511628211ULL;
+      }
+      return h;
+    }
+  };
+
+  struct stage_type {
+    size_type pattern;
+    // Variables of the pattern, the ones bound by previous stages first
+    std::vector<var_type> vars;
+    std::vector<state_type> states;
+    std::vector<size_type> prev;   // Previous position of the same variable
+    std::vector<size_type> fresh;  // First position of each new variable
+    size_type n_bound;             // Positions bound by previous stages
+    bool hash;                     // Hash join, otherwise index nested loop
+    bool built;                    // The hash table was built
+    // Bindings of the new variables of each key, concatenated
+    std::unordered_map<key_type, std::vector<const_type>, key_hash> table;
+  };
+
+  const std::vector<triple_pattern> *m_ptr_triple_patterns;
+  index_scheme_type *m_ptr_index;
+  std::vector<triple_pattern> m_core_patterns;
+  std::unique_ptr<algorithm_type> m_core;
+  std::vector<ltj_iter_type> m_iterators; // One per stage
+  std::vector<stage_type> m_stages;
+  std::vector<batch_type> m_batches; // Output of the core and of each stage
+  std::vector<size_type> m_columns;  // Column of each variable
+  std::array<const_type, 3> m_values; // Bindings of the current pattern
+  size_type m_batch_size = default_batch_size;
+  bool m_is_empty = false;
+
+  // Number of triples of a pattern (an upper bound if it has no constants)
+  static size_type cardinality(ltj_iter_type &it, const triple_pattern &t) {
+    if (t.s_is_variable())
+      return util::trait_size::subject(it);
+    if (t.p_is_variable())
+      return util::trait_size::predicate(it);
+    if (t.o_is_variable())
+      return util::trait_size::object(it);
+    return 1;
+  }
+
+  void add_column(const var_type var) {
+    if (m_columns.size() <= var) {
+      m_columns.resize(var + 1, size_type(npos));
+    }
+    if (m_columns[var] == npos) {
+      m_columns[var] = m_batches.back().vars.size();
+      m_batches.back().vars.push_back(var);
+    }
+  }
+
+  inline bool is_bound(const var_type var) const {
+    return var < m_columns.size() && m_columns[var] != npos;
+  }
+
+  // Appends the pattern e as a new stage
+  void add_stage(const size_type e, const size_type hash_size) {
+    const triple_pattern &triple = m_ptr_triple_patterns->at(e);
+    const term_pattern *terms[3] = {
+        &triple.term_s, &triple.term_p, &triple.term_o
+    };
+    const state_type positions[3] = {s, p, o};
+    stage_type st;
+    st.pattern = e;
+    // Variables bound by previous stages first
+    for (size_type pass = 0; pass < 2; ++pass) {
+      for (size_type i = 0; i < 3; ++i) {
+        if (terms[i]->is_variable &&
+            is_bound((var_type)terms[i]->value) == (pass == 0)) {
+          st.vars.push_back((var_type)terms[i]->value);
+          st.states.push_back(positions[i]);
+        }
+      }
+      if (pass == 0)
+        st.n_bound = st.vars.size();
+    }
+    for (size_type i = 0; i < st.vars.size(); ++i) {
+      st.prev.push_back(size_type(npos));
+      for (size_type j = 0; j < i; ++j) {
+        if (st.vars[j] == st.vars[i])
+          st.prev[i] = j;
+      }
+      if (i >= st.n_bound && st.prev[i] == npos)
+        st.fresh.push_back(i);
+    }
+    m_iterators.emplace_back(&triple, m_ptr_index);
+    st.hash = cardinality(m_iterators.back(), triple) <= hash_size;
+    st.built = false;
+    m_batches.push_back(m_batches.back());
+    for (const size_type i : st.fresh) {
+      add_column(st.vars[i]);
+    }
+    m_batches.back().columns.resize(m_batches.back().vars.size());
+    m_stages.push_back(std::move(st));
+  }
+
+  /*
+      Binds the positions of the pattern of stage k from i on, below the
+      current node of its iterator, and calls leaf for each match. The
+      positions before n_known are already in m_values.
+  */
+  template <class Leaf>
+  void extend(
+      const size_type k,
+      const size_type i,
+      const size_type n_known,
+      Leaf &leaf
+  ) {
+    const stage_type &st = m_stages[k];
+    if (i == st.vars.size()) {
+      leaf();
+      return;
+    }
+    ltj_iter_type &it = m_iterators[k];
+    const state_type state = st.states[i];
+    if (i < n_known || st.prev[i] != npos) {
+      const const_type v =
+          (i < n_known) ? m_values[i] : m_values[st.prev[i]];
+      if (it.leap(state, v) == v) {
+        m_values[i] = v;
+        it.down(state, v);
+        extend(k, i + 1, n_known, leaf);
+        it.up(st.vars[i]);
+      }
+    } else {
+      const_type c = it.leap(state);
+      while (c != 0) {
+        m_values[i] = c;
+        it.down(state, c);
+        extend(k, i + 1, n_known, leaf);
+        it.up(st.vars[i]);
+        c = it.leap(state, c + 1);
+      }
+    }
+    it.leap_done();
+  }
+
+  // Scans the pattern of stage k into its hash table
+  void build(const size_type k) {
+    stage_type &st = m_stages[k];
+    auto leaf = [this, &st]() {
+      key_type key = {{0, 0, 0}};
+      for (size_type i = 0; i < st.n_bound; ++i) {
+        key[i] = m_values[i];
+      }
+      std::vector<const_type> &values = st.table[key];
+      for (const size_type i : st.fresh) {
+        values.push_back(m_values[i]);
+      }
+    };
+    extend(k, 0, 0, leaf);
+    st.built = true;
+  }
+
+  // Appends row r of in, followed by the new variables, to out
+  inline void append(
+      const batch_type &in,
+      const size_type r,
+      const stage_type &st,
+      const const_type *fresh,
+      batch_type &out
+  ) {
+    const size_type n = in.columns.size();
+    for (size_type c = 0; c < n; ++c) {
+      out.columns[c].push_back(in.columns[c][r]);
+    }
+    for (size_type j = 0; j < st.fresh.size(); ++j) {
+      out.columns[n + j].push_back(fresh[j]);
+    }
+    ++out.rows;
+  }
+
+  template <class results_type>
+  bool emit(
+      const batch_type &in,
+      results_type &res,
+      const size_type limit_results
+  ) {
+    tuple_type tuple(in.vars.size());
+    for (size_type r = 0; r < in.rows; ++r) {
+      for (size_type c = 0; c < in.vars.size(); ++c) {
+        tuple[c] = {in.vars[c], in.columns[c][r]};
+      }
+      res.add(tuple);
+      if (limit_results > 0 && res.size() >= limit_results)
+        return false;
+    }
+    return true;
+  }
+
+  /*
+      Joins a batch with the pattern of stage k and passes the result to the
+      next stage. Returns false when the search has to stop.
+  */
+  template <class results_type>
+  bool run(
+      const size_type k,
+      const batch_type &in,
+      results_type &res,
+      const size_type limit_results,
+      ::util::deadline &deadline
+  ) {
+    if (k == m_stages.size())
+      return emit(in, res, limit_results);
+    stage_type &st = m_stages[k];
+    batch_type &out = m_batches[k + 1];
+    out.clear();
+    if (st.hash && !st.built) {
+      build(k);
+    }
+    std::array<const_type, 3> fresh;
+    size_type r = 0;
+    auto leaf = [this, &in, &r, &st, &fresh, &out]() {
+      for (size_type j = 0; j < st.fresh.size(); ++j) {
+        fresh[j] = m_values[st.fresh[j]];
+      }
+      append(in, r, st, fresh.data(), out);
+    };
+    for (r = 0; r < in.rows; ++r) {
+      if (deadline.expired())
+        return false;
+      if (st.hash) {
+        key_type key = {{0, 0, 0}};
+        for (size_type i = 0; i < st.n_bound; ++i) {
+          key[i] = in.columns[m_columns[st.vars[i]]][r];
+        }
+        auto match = st.table.find(key);
+        if (match != st.table.end()) {
+          const std::vector<const_type> &values = match->second;
+          const size_type n_fresh = st.fresh.size();
+          const size_type n = (n_fresh == 0) ? 1 : values.size() / n_fresh;
+          for (size_type i = 0; i < n; ++i) {
+            append(in, r, st, values.data() + i * n_fresh, out);
+          }
+        }
+      } else {
+        for (size_type i = 0; i < st.n_bound; ++i) {
+          m_values[i] = in.columns[m_columns[st.vars[i]]][r];
+        }
+        extend(k, 0, st.n_bound, leaf);
+      }
+      if (out.rows >= m_batch_size) {
+        if (!run(k + 1, out, res, limit_results, deadline))
+          return false;
+        out.clear();
+      }
+    }
+    if (out.rows > 0)
+      return run(k + 1, out, res, limit_results, deadline);
+    return true;
+  }
+
+public:
+  ltj_hybrid() = default;
+
+  /**
+   *
+   * @param triple_patterns   Query
+   * @param index             Index
+   * @param hash_size         Patterns with at most this number of triples
+   * are hash joined, the others use index nested loop joins
+   * @param batch_size        Rows of the batches between stages
+   */
+  ltj_hybrid(
+      const std::vector<triple_pattern> *triple_patterns,
+      index_scheme_type *index,
+      const size_type hash_size = default_hash_size,
+      const size_type batch_size = default_batch_size
+  )
+      : m_ptr_triple_patterns(triple_patterns), m_ptr_index(index),
+        m_batch_size(batch_size) {
+    const std::vector<triple_pattern> &patterns = *m_ptr_triple_patterns;
+    std::vector<size_type> sizes;
+    for (const auto &triple : patterns) {
+      ltj_iter_type it(&triple, m_ptr_index);
+      if (it.is_empty()) {
+        m_is_empty = true;
+        return;
+      }
+      sizes.push_back(cardinality(it, triple));
+    }
+    const join_tree_type tree(patterns);
+    std::vector<size_type> core = tree.core();
+    if (core.empty() && !patterns.empty()) {
+      size_type root = 0;
+      for (size_type e = 1; e < patterns.size(); ++e) {
+        if (sizes[e] < sizes[root])
+          root = e;
+      }
+      core.push_back(root);
+    }
+    std::vector<bool> pending(patterns.size(), true);
+    m_batches.emplace_back();
+    for (const size_type e : core) {
+      m_core_patterns.push_back(patterns[e]);
+      pending[e] = false;
+      const term_pattern *terms[3] = {
+          &patterns[e].term_s, &patterns[e].term_p, &patterns[e].term_o
+      };
+      for (const term_pattern *term : terms) {
+        if (term->is_variable)
+          add_column((var_type)term->value);
+      }
+    }
+    m_batches.back().columns.resize(m_batches.back().vars.size());
+    m_core.reset(new algorithm_type(&m_core_patterns, m_ptr_index));
+
+    // Next pattern: connected to the bound variables, fewest triples first
+    m_iterators.reserve(patterns.size());
+    for (size_type n = core.size(); n < patterns.size(); ++n) {
+      size_type best = npos;
+      bool best_connected = false;
+      for (size_type e = 0; e < patterns.size(); ++e) {
+        if (!pending[e])
+          continue;
+        const term_pattern *terms[3] = {
+            &patterns[e].term_s, &patterns[e].term_p, &patterns[e].term_o
+        };
+        bool connected = false;
+        for (const term_pattern *term : terms) {
+          connected = connected ||
+                      (term->is_variable && is_bound((var_type)term->value));
+        }
+        if (best == npos || (connected && !best_connected) ||
+            (connected == best_connected && sizes[e] < sizes[best])) {
+          best = e;
+          best_connected = connected;
+        }
+      }
+      pending[best] = false;
+      add_stage(best, hash_size);
+    }
+  }
+
+  // It keeps pointers to its own patterns
+  ltj_hybrid(const ltj_hybrid &) = delete;
+  ltj_hybrid &operator=(const ltj_hybrid &) = delete;
+
+  // Patterns solved with LTJ
+  inline const std::vector<triple_pattern> &core() const {
+    return m_core_patterns;
+  }
+
+  // Patterns joined after the core
+  inline size_type stages() const {
+    return m_stages.size();
+  }
+
+  inline bool is_hash_join(const size_type k) const {
+    return m_stages[k].hash;
+  }
+
+  /**
+   *
+   * @param res               Results
+   * @param limit_results     Limit of results
+   * @param timeout_seconds   Timeout in seconds
+   */
+  template <class results_type>
+  void join(
+      results_type &res,
+      const size_type limit_results = 0,
+      const size_type timeout_seconds = 0
+  ) {
+    ::util::deadline deadline(timeout_seconds * 1000);
+    join(res, limit_results, deadline);
+  }
+
+  /**
+   *
+   * @param res               Results
+   * @param limit_results     Limit of results
+   * @param deadline          Deadline (or cancellation token) of the search
+   */
+  template <class results_type>
+  void join(
+      results_type &res,
+      const size_type limit_results,
+      ::util::deadline &deadline
+  ) {
+    if (m_is_empty)
+      return;
+    batch_type &batch = m_batches[0];
+    batch.clear();
+    tuple_type tuple;
+    while (m_core->next(tuple, deadline)) {
+      for (const auto &b : tuple) {
+        batch.columns[m_columns[b.first]].push_back(b.second);
+      }
+      ++batch.rows;
+      if (batch.rows == m_batch_size) {
+        if (!run(0, batch, res, limit_results, deadline))
+          return;
+        batch.clear();
+      }
+    }
+    if (batch.rows > 0) {
+      run(0, batch, res, limit_results, deadline);
+    }
+  }
+};
+
+} // namespace ltj
+
+#endif // LTJ_HYBRID_HPP
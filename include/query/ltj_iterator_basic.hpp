@@ -22,8 +22,10 @@
 
 #include <cltj_config.hpp>
 #include <cltj_utils.hpp>
+#include <query/ltj_filter.hpp>
 #include <string>
 #include <triple_pattern.hpp>
+#include <util/seq_range.hpp>
 #include <vector>
 
 #define VERBOSE 0
@@ -37,7 +39,10 @@ public:
   typedef cons_t value_type;
   typedef var_t var_type;
   typedef index_scheme_t index_scheme_type;
+  typedef ::util::seq_range<typename index_scheme_type::trie_type::seq_type>
+      range_type;
   typedef uint64_t size_type;
+  typedef ltj_filter<value_type> filter_type;
 
   typedef struct {
     std::array<size_type, 2> it;
@@ -66,6 +71,8 @@ private:
   size_type m_status_i = 0;
   status_type m_status;
   redo_array_type m_redo;
+  // Filter of the variable at each position (s, p, o), if any
+  std::array<const filter_type *, 3> m_filters{{nullptr, nullptr, nullptr}};
 
   // std::array<std::vector<size_type>, 2> m_it_v = {std::vector<size_type>(4,
   // 0),
@@ -93,6 +100,7 @@ private:
     m_status_i = o.m_status_i;
     m_status = o.m_status;
     m_redo = o.m_redo;
+    m_filters = o.m_filters;
   }
 
   void print_status() {
@@ -187,6 +195,14 @@ public:
     return m_ptr_triple_pattern->term_o.is_variable &&
            var == m_ptr_triple_pattern->term_o.value;
   }
+
+  inline state_type state_of(var_type var) {
+    if (is_variable_subject(var))
+      return s;
+    if (is_variable_predicate(var))
+      return p;
+    return o;
+  }
   inline const bool is_empty() {
     return m_is_empty;
   }
@@ -252,6 +268,7 @@ public:
       m_status_i = std::move(o.m_status_i);
       m_status = std::move(o.m_status);
       m_redo = std::move(o.m_redo);
+      m_filters = o.m_filters;
     }
     return *this;
   }
@@ -268,6 +285,7 @@ public:
     std::swap(m_status_i, o.m_status_i);
     std::swap(m_status, o.m_status);
     std::swap(m_redo, o.m_redo);
+    std::swap(m_filters, o.m_filters);
   }
 
   void down(state_type state) {
@@ -306,6 +324,11 @@ public:
     down(state);
   };
 
+  // Go down on the position (s, p or o) of the variable, when it is known
+  void down(state_type state, value_type c) {
+    down(state);
+  }
+
   // Reverses the intervals and variable weights. Also resets the current value.
   void up(var_type var) { // Go up in the trie
     --m_nfixed;
@@ -343,6 +366,33 @@ public:
     } else if (is_variable_predicate(var)) {
       state = p;
     }
+    return leap(state, c);
+  }
+
+  // Filters the values of the variable at a position (nullptr removes it)
+  inline void filter(state_type state, const filter_type *f) {
+    m_filters[state] = f;
+  }
+
+  /*
+      Leap on the position (s, p or o) of the variable, when it is known.
+      Values that do not pass its filter are skipped.
+  */
+  value_type leap(state_type state, size_type c = -1ULL) {
+    const filter_type *f = m_filters[state];
+    if (f == nullptr)
+      return leap_trie(state, c);
+    value_type v = f->next(c == -1ULL ? 0 : c);
+    while (v != 0) {
+      const value_type value = leap_trie(state, v);
+      if (value == 0 || value == v)
+        return value;
+      v = f->next(value);
+    }
+    return 0;
+  }
+
+  value_type leap_trie(state_type state, size_type c = -1ULL) {
     choose_trie(state);
     const auto *trie = m_ptr_index->get_trie(m_trie_i);
     size_type beg, end, it;
@@ -367,7 +417,7 @@ public:
       value = trie->seq[beg];
       m_status[m_nfixed + 1].beg = beg; // First position in the sequence
     } else {
-      const auto p = trie->binary_search_seek(c, beg, end);
+      const auto p = trie->gallop_seek(c, beg, end);
       if (p.second > end)
         return 0;
       value = p.first;
@@ -378,6 +428,20 @@ public:
     return value;
   }
 
+  /*
+      Prefetches the first positions that the next leap on the position of
+      the variable will probe, so the leaps of several iterators can be
+      issued together and their cache misses overlap. Nothing is done before
+      the first leap of the level, since its range is not known yet.
+  */
+  inline void prefetch(state_type state) {
+    if (m_redo[m_nfixed])
+      return;
+    choose_trie(state);
+    const auto &st = m_status[m_nfixed + 1];
+    m_ptr_index->get_trie(m_trie_i)->prefetch_gallop(st.beg, st.end);
+  }
+
   bool in_last_level() {
     return m_nfixed == 2;
   }
@@ -442,15 +506,15 @@ public:
     return trie->children(it);
   }
 
-  std::vector<uint64_t> seek_all(var_type x_j) {
-    std::vector<uint64_t> results;
+  // Children of the current node (in the range of its filter), decoded
+  // lazily from the trie
+  range_type seek_all(var_type x_j) {
     const auto *trie = m_ptr_index->get_trie(m_trie_i);
-    uint32_t cnt = trie->children(parent());
-    size_type beg = trie->first_child(parent());
-    for (auto i = beg; i < beg + cnt; ++i) {
-      results.emplace_back(trie->seq[i]);
-    }
-    return results;
+    const size_type cnt = trie->children(parent());
+    const size_type beg = trie->first_child(parent());
+    const range_type range(&trie->seq, beg, beg + cnt);
+    const filter_type *f = m_filters[state_of(x_j)];
+    return (f == nullptr) ? range : f->clip(range);
   }
 };
 
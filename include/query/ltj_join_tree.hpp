@@ -0,0 +1,141 @@
+#ifndef LTJ_JOIN_TREE_HPP
+#define LTJ_JOIN_TREE_HPP
+
+#include <cstdint>
+#include <triple_pattern.hpp>
+#include <vector>
+
+namespace ltj {
+
+/**
+ * @brief Join tree of a query obtained with the GYO reduction.
+ *
+ * The triple patterns are the hyperedges of the query and their variables
+ * the vertices. An ear is a pattern whose variables shared with the other
+ * remaining patterns are all in a single one of them (its parent). Ears are
+ * removed until none is left: when every pattern is removed the query is
+ * alpha-acyclic and the parents form its join tree; otherwise the remaining
+ * patterns are its cyclic core, and the removed ones are trees hanging from
+ * it.
+ *
+ * The sets of variables are bitmaps, so it supports up to 64 variables.
+ */
+template <class var_t = uint8_t> class ltj_join_tree {
+
+public:
+  typedef uint64_t size_type;
+  typedef var_t var_type;
+  typedef uint64_t mask_type;
+
+  static constexpr size_type max_vars = 64;
+  // Parent of the roots and of the patterns of the core
+  static constexpr size_type no_parent = -1ULL;
+
+private:
+  std::vector<mask_type> m_masks;   // Variables of each pattern
+  std::vector<size_type> m_parents; // Parent of each pattern
+  std::vector<size_type> m_order;   // Patterns in the order they are removed
+  std::vector<size_type> m_core;    // Patterns that are not removed
+  bool m_supported = true;
+
+  void reduce() {
+    const size_type n = m_masks.size();
+    std::vector<bool> active(n, true);
+    size_type n_active = n;
+    bool removed = true;
+    while (removed && n_active > 0) {
+      removed = false;
+      for (size_type e = 0; e < n; ++e) {
+        if (!active[e])
+          continue;
+        mask_type others = 0;
+        for (size_type f = 0; f < n; ++f) {
+          if (active[f] && f != e)
+            others |= m_masks[f];
+        }
+        const mask_type shared = m_masks[e] & others;
+        size_type parent = no_parent;
+        bool ear = (shared == 0);
+        for (size_type f = 0; f < n && !ear; ++f) {
+          if (active[f] && f != e && (shared & ~m_masks[f]) == 0) {
+            parent = f;
+            ear = true;
+          }
+        }
+        if (ear) {
+          active[e] = false;
+          --n_active;
+          m_parents[e] = parent;
+          m_order.push_back(e);
+          removed = true;
+        }
+      }
+    }
+    for (size_type e = 0; e < n; ++e) {
+      if (active[e])
+        m_core.push_back(e);
+    }
+  }
+
+public:
+  ltj_join_tree() = default;
+
+  ltj_join_tree(const std::vector<triple_pattern> &patterns) {
+    m_masks.reserve(patterns.size());
+    for (const auto &triple : patterns) {
+      const term_pattern *terms[3] = {
+          &triple.term_s, &triple.term_p, &triple.term_o
+      };
+      mask_type mask = 0;
+      for (const term_pattern *term : terms) {
+        if (!term->is_variable)
+          continue;
+        if (term->value >= max_vars) {
+          m_supported = false;
+          continue;
+        }
+        mask |= 1ULL << term->value;
+      }
+      m_masks.push_back(mask);
+    }
+    m_parents.assign(m_masks.size(), size_type(no_parent));
+    if (m_supported) {
+      reduce();
+    } else {
+      for (size_type e = 0; e < m_masks.size(); ++e) {
+        m_core.push_back(e);
+      }
+    }
+  }
+
+  // The query is alpha-acyclic (false if it has more than 64 variables)
+  inline bool acyclic() const {
+    return m_supported && m_core.empty();
+  }
+
+  inline size_type size() const {
+    return m_masks.size();
+  }
+
+  inline mask_type vars(const size_type e) const {
+    return m_masks[e];
+  }
+
+  inline size_type parent(const size_type e) const {
+    return m_parents[e];
+  }
+
+  // Removed patterns, children before parents
+  inline const std::vector<size_type> &order() const {
+    return m_order;
+  }
+
+  // Patterns of the cyclic core (empty if the query is acyclic)
+  inline const std::vector<size_type> &core() const {
+    return m_core;
+  }
+};
+
+} // namespace ltj
+
+#endif // LTJ_JOIN_TREE_HPP
@@ -0,0 +1,108 @@
+#ifndef LTJ_PLAN_HPP
+#define LTJ_PLAN_HPP
+
+#include <cltj_config.hpp>
+#include <cstdint>
+#include <triple_pattern.hpp>
+#include <vector>
+
+namespace ltj {
+
+/**
+ * @brief Shape of a query compiled into dense arrays indexed by variable.
+ *
+ * For each variable it stores the triple patterns where it occurs and its
+ * position (s, p or o) in each of them, so the join neither hashes variables
+ * nor compares them against the terms of the triple patterns. It only depends
+ * on the positions of the variables, therefore it can be reused by any query
+ * that differs just in its constants (see same_shape).
+ */
+template <class var_t = uint8_t> class ltj_plan {
+
+public:
+  typedef uint64_t size_type;
+  typedef var_t var_type;
+  typedef struct {
+    size_type pattern; // Index of the triple pattern (and of its iterator)
+    state_type state;  // Position of the variable in the triple pattern
+  } occurrence_type;
+  typedef std::vector<occurrence_type> occurrences_type;
+
+private:
+  std::vector<occurrences_type> m_occurrences;
+  std::vector<triple_pattern> m_shape; // Triple patterns without constants
+
+  void add(const var_type var, const size_type pattern, const state_type st) {
+    if (var >= m_occurrences.size()) {
+      m_occurrences.resize(var + 1);
+    }
+    m_occurrences[var].push_back({pattern, st});
+  }
+
+  static void copy_term(const term_pattern &term, term_pattern &shape) {
+    shape.is_variable = term.is_variable;
+    shape.value = term.is_variable ? term.value : 0;
+  }
+
+public:
+  ltj_plan() = default;
+
+  explicit ltj_plan(const std::vector<triple_pattern> &triple_patterns) {
+    m_shape.resize(triple_patterns.size());
+    for (size_type i = 0; i < triple_patterns.size(); ++i) {
+      const triple_pattern &triple = triple_patterns[i];
+      // Same order as the iterators were added to each variable
+      if (triple.o_is_variable()) {
+        add((var_type)triple.term_o.value, i, o);
+      }
+      if (triple.p_is_variable()) {
+        add((var_type)triple.term_p.value, i, p);
+      }
+      if (triple.s_is_variable()) {
+        add((var_type)triple.term_s.value, i, s);
+      }
+      copy_term(triple.term_s, m_shape[i].term_s);
+      copy_term(triple.term_p, m_shape[i].term_p);
+      copy_term(triple.term_o, m_shape[i].term_o);
+    }
+  }
+
+  // Largest variable id plus one
+  inline size_type size() const {
+    return m_occurrences.size();
+  }
+
+  inline const occurrences_type &occurrences(const var_type var) const {
+    return m_occurrences[var];
+  }
+
+  /*
+      Checks if the triple patterns have the variables in the same positions
+      as the query used to build the plan (constants may differ)
+  */
+  bool same_shape(const std::vector<triple_pattern> &triple_patterns) const {
+    if (triple_patterns.size() != m_shape.size())
+      return false;
+    term_pattern term;
+    for (size_type i = 0; i < m_shape.size(); ++i) {
+      const triple_pattern &triple = triple_patterns[i];
+      const term_pattern *terms[3] = {
+          &triple.term_s, &triple.term_p, &triple.term_o
+      };
+      const term_pattern *shape[3] = {
+          &m_shape[i].term_s, &m_shape[i].term_p, &m_shape[i].term_o
+      };
+      for (size_type k = 0; k < 3; ++k) {
+        copy_term(*terms[k], term);
+        if (term.is_variable != shape[k]->is_variable ||
+            term.value != shape[k]->value)
+          return false;
+      }
+    }
+    return true;
+  }
+};
+
+} // namespace ltj
+
+#endif // LTJ_PLAN_HPP
@@ -0,0 +1,171 @@
+#ifndef LTJ_PREPARED_QUERY_HPP
+#define LTJ_PREPARED_QUERY_HPP
+
+#include <cltj_config.hpp>
+#include <cstdint>
+#include <query/ltj_plan.hpp>
+#include <string>
+#include <triple_pattern.hpp>
+#include <unordered_map>
+#include <util/rdf_util.hpp>
+#include <vector>
+
+namespace ltj {
+
+/**
+ * @brief Query template parsed and compiled once, executed many times with
+ * different constants.
+ *
+ * Terms starting with '$' are parameters: every occurrence of the same name
+ * takes the same value, and parameters are numbered by their first
+ * appearance. Variables ('?') and parameters are parsed once and the plan is
+ * compiled once; bind() only writes the constants into a copy of the triple
+ * patterns. The constants written in the template are kept unresolved as
+ * well, so a prepared query does not depend on the dictionaries being stable.
+ *
+ * @tparam const_t Type of a constant before being resolved to an id (the id
+ * itself or its string)
+ */
+template <class const_t, class var_t = uint8_t> class ltj_prepared_query {
+
+public:
+  typedef uint64_t size_type;
+  typedef const_t const_type;
+  typedef var_t var_type;
+  typedef ltj_plan<var_type> plan_type;
+  typedef struct {
+    size_type pattern; // Index of the triple pattern
+    state_type state;  // Position of the constant in the triple pattern
+    bool is_parameter;
+    size_type value; // Index of the parameter or of the template constant
+  } slot_type;
+
+private:
+  std::vector<triple_pattern> m_patterns; // Constants are set by bind()
+  std::vector<slot_type> m_slots;
+  std::vector<const_type> m_constants; // Constants written in the template
+  std::vector<bool> m_var_in_p;
+  size_type m_n_params = 0;
+  plan_type m_plan;
+
+  template <class Convert>
+  void add_constant(
+      std::string &term,
+      const size_type pattern,
+      const state_type st,
+      ::util::rdf::ht_var_id_type &ht_params,
+      Convert &convert
+  ) {
+    if (term.at(0) == '$') {
+      auto name = term.substr(1);
+      auto it = ht_params.find(name);
+      if (it == ht_params.end()) {
+        it = ht_params.insert({name, (uint8_t)ht_params.size()}).first;
+      }
+      m_slots.push_back({pattern, st, true, (size_type)it->second});
+    } else {
+      m_slots.push_back({pattern, st, false, m_constants.size()});
+      m_constants.push_back(convert(term));
+    }
+  }
+
+public:
+  ltj_prepared_query() = default;
+
+  /**
+   *
+   * @param terms    Triples of terms of the template
+   * @param convert  Functor that converts the string of a constant into
+   * const_type
+   */
+  template <class Convert>
+  ltj_prepared_query(std::vector<cltj::user_triple> terms, Convert convert) {
+    ::util::rdf::ht_var_id_type ht_var_id, ht_params;
+    m_patterns.resize(terms.size());
+    for (size_type i = 0; i < terms.size(); ++i) {
+      cltj::user_triple &t = terms[i];
+      triple_pattern &triple = m_patterns[i];
+      if (::util::rdf::is_variable(t[0])) {
+        triple.var_s(
+            ::util::rdf::str::get_variable(t[0], ht_var_id, m_var_in_p)
+        );
+      } else {
+        triple.const_s(0);
+        add_constant(t[0], i, s, ht_params, convert);
+      }
+      if (::util::rdf::is_variable(t[1])) {
+        triple.var_p(
+            ::util::rdf::str::get_variable(t[1], ht_var_id, m_var_in_p, true)
+        );
+      } else {
+        triple.const_p(0);
+        add_constant(t[1], i, p, ht_params, convert);
+      }
+      if (::util::rdf::is_variable(t[2])) {
+        triple.var_o(
+            ::util::rdf::str::get_variable(t[2], ht_var_id, m_var_in_p)
+        );
+      } else {
+        triple.const_o(0);
+        add_constant(t[2], i, o, ht_params, convert);
+      }
+    }
+    m_n_params = ht_params.size();
+    m_plan = plan_type(m_patterns);
+  }
+
+  /**
+   * Writes the constants into a copy of the triple patterns.
+   *
+   * @param params   Values of the parameters
+   * @param resolve  Functor called as resolve(constant, state, id) that
+   * stores in id the identifier of constant and returns false if it does not
+   * exist
+   * @param patterns Output triple patterns
+   * @return         False if the number of parameters is wrong or a constant
+   * does not exist (the query has no solutions)
+   */
+  template <class Resolve>
+  bool bind(
+      const std::vector<const_type> &params,
+      Resolve resolve,
+      std::vector<triple_pattern> &patterns
+  ) const {
+    if (params.size() != m_n_params)
+      return false;
+    patterns = m_patterns;
+    uint64_t id;
+    for (const auto &slot : m_slots) {
+      const const_type &c =
+          slot.is_parameter ? params[slot.value] : m_constants[slot.value];
+      if (!resolve(c, slot.state, id))
+        return false;
+      triple_pattern &triple = patterns[slot.pattern];
+      if (slot.state == s) {
+        triple.const_s(id);
+      } else if (slot.state == p) {
+        triple.const_p(id);
+      } else {
+        triple.const_o(id);
+      }
+    }
+    return true;
+  }
+
+  inline size_type parameters() const {
+    return m_n_params;
+  }
+
+  inline const plan_type &plan() const {
+    return m_plan;
+  }
+
+  // For each variable, whether it appears as a predicate
+  inline const std::vector<bool> &var_in_p() const {
+    return m_var_in_p;
+  }
+};
+
+} // namespace ltj
+
+#endif // LTJ_PREPARED_QUERY_HPP
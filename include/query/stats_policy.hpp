@@ -0,0 +1,104 @@
+#ifndef STATS_POLICY_HPP
+#define STATS_POLICY_HPP
+
+#include <cltj_config.hpp>
+#include <query/alternation_complexity.hpp>
+#include <query/intersection_stats.hpp>
+#include <vector>
+
+namespace ltj {
+
+namespace stats {
+
+/**
+ * @brief Statistics policy of ltj_algorithm that collects nothing.
+ *
+ * Every hook is an empty inline function, so the compiler removes the calls
+ * and the join pays nothing for instrumentation.
+ */
+struct stats_none {
+
+  template <class ltj_iter_type, class var_type>
+  inline void
+  begin(const std::vector<ltj_iter_type *> &, const var_type, const int) {
+  }
+
+  inline void add_result() {
+  }
+
+  inline void add_seek() {
+  }
+
+  template <class ltj_iter_type, class var_type>
+  inline void end(const std::vector<ltj_iter_type *> &, const var_type) {
+  }
+
+  const std::vector<IntersectionStats> &get() const {
+    static const std::vector<IntersectionStats> empty;
+    return empty;
+  }
+};
+
+/**
+ * @brief Statistics policy of ltj_algorithm for experimentation.
+ *
+ * Stores one IntersectionStats per intersection: the size of the intersected
+ * lists, the size of the result, the number of leaps done by seek() and the
+ * alternation complexity of the intersection.
+ */
+class stats_full {
+
+private:
+  std::vector<IntersectionStats> m_stats;
+  std::vector<IntersectionStats> m_open; // Intersections in progress
+
+public:
+  template <class ltj_iter_type, class var_type>
+  void begin(
+      const std::vector<ltj_iter_type *> &itrs,
+      const var_type x_j,
+      const int depth
+  ) {
+    IntersectionStats stats;
+    stats.variable_id = x_j;
+    stats.depth = depth;
+    // Collect list sizes from each iterator
+    for (ltj_iter_type *iter : itrs) {
+      state_type state = o;
+      if (iter->is_variable_subject(x_j)) {
+        state = s;
+      } else if (iter->is_variable_predicate(x_j)) {
+        state = p;
+      }
+      stats.list_sizes.push_back(iter->children(state));
+    }
+    m_open.push_back(stats);
+  }
+
+  inline void add_result() {
+    ++m_open.back().result_size;
+  }
+
+  inline void add_seek() {
+    if (!m_open.empty())
+      ++m_open.back().leapfrog_seeks;
+  }
+
+  template <class ltj_iter_type, class var_type>
+  void end(const std::vector<ltj_iter_type *> &itrs, const var_type x_j) {
+    IntersectionStats &stats = m_open.back();
+    stats.alternation_complexity = calculate_alternation_complexity(itrs, x_j);
+    m_stats.push_back(stats);
+    m_open.pop_back();
+  }
+
+  const std::vector<IntersectionStats> &get() const {
+    return m_stats;
+  }
+};
+
+} // namespace stats
+
+} // namespace ltj
+
+#endif // STATS_POLICY_HPP
@@ -6,6 +6,7 @@
 #define RESULTS_HPP
 
 #include <results/results_collector.hpp>
+#include <results/results_factorized.hpp>
 #include <results/results_printer.hpp>
 #include <results/results_writer.hpp>
 
@@ -0,0 +1,167 @@
+#ifndef CLTJ_RESULTS_FACTORIZED_HPP
+#define CLTJ_RESULTS_FACTORIZED_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/**
+ * @brief Results in factorized form (f-representation).
+ *
+ * Each entry is a prefix of bindings and, for each remaining variable, a
+ * reference to the range of the trie with its candidates. The entry stands
+ * for the cartesian product of the prefix with those ranges, which is only
+ * unfolded on demand.
+ *
+ * @tparam Var   Type of the variables
+ * @tparam Cons  Type of the constants
+ * @tparam Range Random access range of constants (size() and operator[])
+ */
+template <class Var, class Cons, class Range> class results_factorized {
+
+public:
+  typedef uint64_t size_type;
+  typedef Var var_type;
+  typedef Cons value_type;
+  typedef Range range_type;
+  typedef std::vector<std::pair<var_type, value_type>> tuple_type;
+  typedef std::pair<var_type, range_type> factor_type;
+  typedef std::vector<factor_type> factors_type;
+
+private:
+  std::vector<tuple_type> m_prefixes;
+  std::vector<factors_type> m_factors;
+  size_type m_cardinality = 0;
+
+  void copy(const results_factorized &o) {
+    m_prefixes = o.m_prefixes;
+    m_factors = o.m_factors;
+    m_cardinality = o.m_cardinality;
+  }
+
+public:
+  results_factorized() = default;
+
+  inline void add(const tuple_type &prefix, const factors_type &factors) {
+    size_type n = 1;
+    for (const auto &f : factors) {
+      n *= f.second.size();
+    }
+    m_prefixes.push_back(prefix);
+    m_factors.push_back(factors);
+    m_cardinality += n;
+  }
+
+  inline void add(const tuple_type &tuple) {
+    add(tuple, factors_type());
+  }
+
+  // Number of entries
+  inline size_type size() const {
+    return m_prefixes.size();
+  }
+
+  // Number of tuples represented by all the entries
+  inline size_type cardinality() const {
+    return m_cardinality;
+  }
+
+  inline const tuple_type &prefix(const size_type i) const {
+    return m_prefixes[i];
+  }
+
+  inline const factors_type &factors(const size_type i) const {
+    return m_factors[i];
+  }
+
+  /**
+   * Enumerates the tuples of an entry.
+   *
+   * @param i   Entry
+   * @param f   Functor called as f(tuple) for each tuple of the product
+   */
+  template <class Function>
+  void unfold(const size_type i, Function f) const {
+    const factors_type &factors = m_factors[i];
+    for (const auto &factor : factors) {
+      if (factor.second.size() == 0)
+        return;
+    }
+    tuple_type tuple = m_prefixes[i];
+    const size_type k = tuple.size();
+    std::vector<size_type> pos(factors.size(), 0);
+    for (size_type j = 0; j < factors.size(); ++j) {
+      tuple.emplace_back(factors[j].first, factors[j].second[0]);
+    }
+    while (true) {
+      f(tuple);
+      // Next combination (the last factor changes first)
+      size_type j = factors.size();
+      while (j > 0) {
+        --j;
+        if (++pos[j] < factors[j].second.size()) {
+          tuple[k + j].second = factors[j].second[pos[j]];
+          break;
+        }
+        pos[j] = 0;
+        tuple[k + j].second = factors[j].second[0];
+        if (j == 0)
+          return;
+      }
+      if (factors.empty())
+        return;
+    }
+  }
+
+  // Enumerates the tuples of all the entries
+  template <class Function> void unfold(Function f) const {
+    for (size_type i = 0; i < m_prefixes.size(); ++i) {
+      unfold(i, f);
+    }
+  }
+
+  inline void clear() {
+    m_prefixes.clear();
+    m_factors.clear();
+    m_cardinality = 0;
+  }
+
+  //! Copy constructor
+  results_factorized(const results_factorized &o) {
+    copy(o);
+  }
+
+  //! Move constructor
+  results_factorized(results_factorized &&o) {
+    *this = std::move(o);
+  }
+
+  //! Copy Operator=
+  results_factorized &operator=(const results_factorized &o) {
+    if (this != &o) {
+      copy(o);
+    }
+    return *this;
+  }
+
+  //! Move Operator=
+  results_factorized &operator=(results_factorized &&o) {
+    if (this != &o) {
+      m_prefixes = std::move(o.m_prefixes);
+      m_factors = std::move(o.m_factors);
+      m_cardinality = o.m_cardinality;
+    }
+    return *this;
+  }
+
+  void swap(results_factorized &o) {
+    std::swap(m_prefixes, o.m_prefixes);
+    std::swap(m_factors, o.m_factors);
+    std::swap(m_cardinality, o.m_cardinality);
+  }
+};
+
+} // namespace util
+#endif // CLTJ_RESULTS_FACTORIZED_HPP
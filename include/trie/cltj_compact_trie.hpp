@@ -1,39 +1,52 @@
 #ifndef CLTJ_COMPACT_TRIE_V3_H
 #define CLTJ_COMPACT_TRIE_V3_H
 
-#include <cds/succ_support_v.hpp>
+#include <algorithm>
+#include <cds/rank_select_support.hpp>
+#include <cds/select_succ_support.hpp>
 #include <fstream>
 #include <iostream>
 #include <queue>
-#include <sdsl/select_support_mcl.hpp>
 #include <sdsl/vectors.hpp>
 #include <string>
+#include <util/prefetch.hpp>
 #include <vector>
 
 namespace cltj {
 
-class compact_trie {
+/**
+ * Compact trie: a 0 in bv at the start of each run of siblings, and the
+ * symbols of the runs in seq, bit-compressed.
+ *
+ * select0 and succ0 of bv come from t_support: select_support_mcl and
+ * succ_support_v (cds::select_succ_support) by default, or the single
+ * directory of cds::rank_select_support.
+ *
+ * @tparam t_value    Type of the symbols (the IDs of the triples)
+ * @tparam t_support  select and succ of the zeros of bv
+ */
+template <class t_value, class t_support = cds::select_succ_support<0>>
+class compact_trie_t {
 
 public:
   typedef uint64_t size_type;
-  typedef uint32_t value_type;
+  typedef t_value value_type;
+  typedef sdsl::int_vector<> seq_type;
+  typedef t_support support_type;
 
 private:
   sdsl::bit_vector m_bv;
   sdsl::int_vector<> m_seq;
   // sdsl::rank_support_v<1> m_rank1;
-  cds::succ_support_v<0> m_succ0;
-  sdsl::select_support_mcl<0> m_select0;
+  t_support m_rs0;
 
-  void copy(const compact_trie &o) {
+  void copy(const compact_trie_t &o) {
     m_bv = o.m_bv;
     m_seq = o.m_seq;
     // m_rank1 = o.m_rank1;
     // m_rank1.set_vector(&m_bv);
-    m_succ0 = o.m_succ0;
-    m_succ0.set_vector(&m_bv);
-    m_select0 = o.m_select0;
-    m_select0.set_vector(&m_bv);
+    m_rs0 = o.m_rs0;
+    m_rs0.set_vector(&m_bv);
   }
 
   /*inline size_type rank0(const size_type i) const {
@@ -44,14 +57,23 @@ public:
   const sdsl::int_vector<> &seq = m_seq;
   const sdsl::bit_vector &bv = m_bv;
 
-  compact_trie() = default;
+  compact_trie_t() = default;
 
-  compact_trie(
-      const std::vector<uint32_t> &syms,
+  template <class t_sym>
+  compact_trie_t(
+      const std::vector<t_sym> &syms,
       const std::vector<size_type> &lengths
   ) {
+    // m_seq takes the width of the largest symbol from the start, instead
+    // of 64 bits per node until a bit_compress at the end
+    uint64_t max_sym = 0;
+    for (const auto &sym : syms) {
+      max_sym = std::max<uint64_t>(max_sym, sym);
+    }
     m_bv = sdsl::bit_vector(syms.size() + 1, 1);
-    m_seq = sdsl::int_vector<>(syms.size());
+    m_seq = sdsl::int_vector<>(
+        syms.size(), 0, max_sym ? sdsl::bits::hi(max_sym) + 1 : 1
+    );
     m_bv[0] = 0;
     uint64_t pos_bv = 0, pos_seq = 0;
     for (const auto &sym : syms) {
@@ -68,25 +90,42 @@ public:
     // std::cout << "n_nodes=" << syms.size() << " pos_seq=" << pos_seq << "
     // pos_bv=" << pos_bv << std::endl;
 
-    sdsl::util::bit_compress(m_seq);
     // std::cout << "width of trie seq = " << (uint64_t) m_seq.width() <<
     // std::endl;
-    sdsl::util::init_support(m_succ0, &m_bv);
-    sdsl::util::init_support(m_select0, &m_bv);
+    m_rs0 = t_support(&m_bv);
+  }
+
+  /*
+      Receives bv (a 0 at the start of each run and at the end) and the
+      symbols, which are moved into the trie instead of copied
+  */
+  compact_trie_t(sdsl::bit_vector &&_bv, sdsl::int_vector<> &&_seq) {
+    m_bv = std::move(_bv);
+    m_seq = std::move(_seq);
+    sdsl::util::bit_compress(m_seq);
+    m_rs0 = t_support(&m_bv);
+  }
+
+  //! From a trie with another support (same bv and seq)
+  template <class t_other>
+  explicit compact_trie_t(const compact_trie_t<t_value, t_other> &trie) {
+    m_bv = trie.bv;
+    m_seq = trie.seq;
+    m_rs0 = t_support(&m_bv);
   }
 
   //! Copy constructor
-  compact_trie(const compact_trie &o) {
+  compact_trie_t(const compact_trie_t &o) {
     copy(o);
   }
 
   //! Move constructor
-  compact_trie(compact_trie &&o) {
+  compact_trie_t(compact_trie_t &&o) {
     *this = std::move(o);
   }
 
   //! Copy Operator=
-  compact_trie &operator=(const compact_trie &o) {
+  compact_trie_t &operator=(const compact_trie_t &o) {
     if (this != &o) {
       copy(o);
     }
@@ -94,27 +133,24 @@ public:
   }
 
   //! Move Operator=
-  compact_trie &operator=(compact_trie &&o) {
+  compact_trie_t &operator=(compact_trie_t &&o) {
     if (this != &o) {
       m_bv = std::move(o.m_bv);
       m_seq = std::move(o.m_seq);
       // m_rank1 = std::move(o.m_rank1);
-      m_succ0 = std::move(o.m_succ0);
       // m_rank1.set_vector(&m_bv);
-      m_succ0.set_vector(&m_bv);
-      m_select0 = std::move(o.m_select0);
-      m_select0.set_vector(&m_bv);
+      m_rs0 = std::move(o.m_rs0);
+      m_rs0.set_vector(&m_bv);
     }
     return *this;
   }
 
-  void swap(compact_trie &o) {
+  void swap(compact_trie_t &o) {
     // m_bp.swap(bp_support.m_bp); use set_vector to set the supported
     // bit_vector
     std::swap(m_bv, o.m_bv);
     std::swap(m_seq, o.m_seq);
-    sdsl::util::swap_support(m_succ0, o.m_succ0, &m_bv, &o.m_bv);
-    sdsl::util::swap_support(m_select0, o.m_select0, &m_bv, &o.m_bv);
+    sdsl::util::swap_support(m_rs0, o.m_rs0, &m_bv, &o.m_bv);
   }
 
   /*
@@ -129,11 +165,11 @@ public:
       Receives index of current node and the child that is required
       Returns index of the nth child of current node
   */
-  inline size_type child(uint32_t it, uint32_t n, uint32_t gap = 1) const {
-    return m_select0(it + gap + n);
+  inline size_type child(size_type it, size_type n, size_type gap = 1) const {
+    return m_rs0.select(it + gap + n);
   }
 
-  inline size_type nodeselect(uint32_t it, uint32_t gap = 1) const {
+  inline size_type nodeselect(size_type it, size_type gap = 1) const {
     return child(it, 1, gap);
   }
 
@@ -142,18 +178,18 @@ public:
       Returns how many children said node has
   */
   size_type children(size_type i) const {
-    return m_succ0(i + 1) - i;
+    return m_rs0.succ(i + 1) - i;
   }
 
   size_type first_child(size_type i) const {
     return i;
   }
 
-  std::pair<uint32_t, uint64_t>
-  binary_search_seek(uint32_t val, uint32_t i, uint32_t f) const {
+  std::pair<value_type, size_type>
+  binary_search_seek(value_type val, size_type i, size_type f) const {
     if (m_seq[f] < val)
       return std::make_pair(0, f + 1);
-    uint32_t mid;
+    size_type mid;
     while (i < f) {
       mid = (i + f) / 2;
       if (m_seq[mid] < val) {
@@ -165,8 +201,41 @@ public:
     return std::make_pair(m_seq[i], i);
   }
 
+  /*
+      Same result as binary_search_seek, but the search gallops from i
+      (1, 2, 4... positions ahead) before bisecting. Successive seeks in
+      leapfrog are usually close to the previous position, so this costs
+      O(log d) accesses, where d is the distance from i to the result.
+  */
+  std::pair<value_type, size_type>
+  gallop_seek(value_type val, size_type i, size_type f) const {
+    size_type hi = i, step = 1;
+    while (m_seq[hi] < val) {
+      if (hi == f)
+        return std::make_pair(0, f + 1);
+      i = hi + 1;
+      hi = (f - hi > step) ? hi + step : f;
+      step <<= 1;
+    }
+    size_type mid;
+    while (i < hi) {
+      mid = (i + hi) / 2;
+      if (m_seq[mid] < val) {
+        i = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return std::make_pair(m_seq[i], i);
+  }
+
+  // Prefetches the first positions that gallop_seek(val, i, f) probes
+  inline void prefetch_gallop(size_type i, size_type f) const {
+    ::util::prefetch_gallop(m_seq, i, f);
+  }
+
   void print() const {
-    for (auto i = 0; i < m_bv.size(); ++i) {
+    for (size_type i = 0; i < m_bv.size(); ++i) {
       std::cout << (uint)m_bv[i];
     }
     std::cout << std::endl;
@@ -183,8 +252,7 @@ public:
     size_type written_bytes = 0;
     written_bytes += m_bv.serialize(out, child, "bv");
     written_bytes += m_seq.serialize(out, child, "seq");
-    written_bytes += m_succ0.serialize(out, child, "succ0");
-    written_bytes += m_select0.serialize(out, child, "select0");
+    written_bytes += m_rs0.serialize(out, child, "rs0");
     sdsl::structure_tree::add_size(child, written_bytes);
     return written_bytes;
   }
@@ -192,9 +260,13 @@ public:
   void load(std::istream &in) {
     m_bv.load(in);
     m_seq.load(in);
-    m_succ0.load(in, &m_bv);
-    m_select0.load(in, &m_bv);
+    m_rs0.load(in, &m_bv);
   }
 };
+
+// Trie of the triples with IDs of 32 bits
+typedef compact_trie_t<uint32_t> compact_trie;
+// Same trie with select0 and succ0 in one cds::rank_select_support
+typedef compact_trie_t<uint32_t, cds::rank_select_support<0>> compact_trie_rs;
 } // namespace cltj
 #endif
\ No newline at end of file
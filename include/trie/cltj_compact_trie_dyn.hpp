@@ -17,6 +17,7 @@ template <uint default_width = 32> class compact_trie_dyn {
 public:
   typedef uint64_t size_type;
   typedef uint32_t value_type;
+  typedef dyn_cds::dyn_louds seq_type;
 
 private:
   dyn_cds::dyn_louds m_seq;
@@ -129,11 +130,11 @@ public:
       Receives index of current node and the child that is required
       Returns index of the nth child of current node
   */
-  inline size_type child(uint32_t it, uint32_t n, uint32_t gap = 1) const {
+  inline size_type child(size_type it, size_type n, size_type gap = 1) const {
     return m_seq.select(it + gap + n);
   }
 
-  inline size_type nodeselect(uint32_t it, uint32_t gap = 1) const {
+  inline size_type nodeselect(size_type it, size_type gap = 1) const {
     return child(it, 1, gap);
   }
 
@@ -172,17 +173,29 @@ public:
     return m_seq.next(i, j, val);
   }
 
-  std::pair<uint32_t, uint64_t>
-  binary_search_seek(uint32_t val, uint32_t i, uint32_t f) const {
+  std::pair<value_type, size_type>
+  binary_search_seek(value_type val, size_type i, size_type f) const {
+    return m_seq.next(i, f, val);
+  }
+
+  /*
+      The dynamic sequence already searches forward from the block of i, and
+      a random access costs a tree descent, so galloping is left to next().
+  */
+  std::pair<value_type, size_type>
+  gallop_seek(value_type val, size_type i, size_type f) const {
     return m_seq.next(i, f, val);
   }
 
+  // A random access costs a tree descent, so there is nothing to prefetch
+  inline void prefetch_gallop(size_type, size_type) const {}
+
   // return position, equal; where equal means that position contains val
   std::pair<uint64_t, bool>
-  binary_search(uint32_t val, uint32_t i, uint32_t f) {
+  binary_search(value_type val, size_type i, size_type f) {
     if (m_seq[f] < val)
       return {f + 1, false};
-    uint32_t mid;
+    size_type mid;
     while (i < f) {
       mid = (i + f) / 2;
       if (m_seq[mid] == val)
@@ -0,0 +1,287 @@
+#ifndef CLTJ_COMPACT_TRIE_EF_H
+#define CLTJ_COMPACT_TRIE_EF_H
+
+#include <cds/partitioned_ef.hpp>
+#include <cds/rank_select_support.hpp>
+#include <iostream>
+#include <sdsl/vectors.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cltj {
+
+/**
+ * Compact trie whose sequence is encoded with partitioned Elias-Fano.
+ *
+ * The topology is the one of compact_trie (a 0 in bv at the start of each
+ * run of siblings). Each run is sorted, so adding to its symbols the last
+ * value of the previous run gives a non-decreasing sequence,
+ * P[i] = P[s - 1] + seq[i], where s is the start of the run of i. P is
+ * encoded with cds::partitioned_ef, and the seeks are a next_geq on it,
+ * which skips to the bucket of the value instead of bisecting. Every block
+ * has its own width, so the levels with small symbols or dense runs do not
+ * pay for the largest ID. P must fit in 64 bits, otherwise the
+ * constructors throw std::overflow_error.
+ *
+ * select0 and succ0 of bv share one directory (cds::rank_select_support).
+ *
+ * It can be built from (syms, lengths), like compact_trie, or from
+ * (bv, seq), like compact_metatrie, so it is a Trie of both
+ * cltj_index_spo_lite and cltj_index_metatrie.
+ *
+ * @tparam t_value  Type of the symbols (the IDs of the triples)
+ */
+template <class t_value> class compact_trie_ef_t {
+
+public:
+  typedef uint64_t size_type;
+  typedef t_value value_type;
+  typedef cds::partitioned_ef<> ef_type;
+  enum { ef_block = 128 }; // Elements per block of ef_type
+
+  //! Random access to the symbols of the trie, like the int_vector of
+  //! compact_trie
+  class seq_view {
+  private:
+    const compact_trie_ef_t *m_trie;
+
+  public:
+    typedef uint64_t size_type;
+    typedef t_value value_type;
+
+    explicit seq_view(const compact_trie_ef_t *trie) : m_trie(trie) {}
+
+    inline value_type operator[](const size_type i) const {
+      return m_trie->value(i);
+    }
+
+    inline size_type size() const {
+      return m_trie->m_ef.size();
+    }
+  };
+  typedef seq_view seq_type;
+
+private:
+  sdsl::bit_vector m_bv;
+  ef_type m_ef;
+  // P[s - 1] of the run of the first position of each block of m_ef
+  sdsl::int_vector<> m_run_bases;
+  cds::rank_select_support<0> m_rs0;
+  seq_view m_seq_view{this};
+
+  void copy(const compact_trie_ef_t &o) {
+    m_bv = o.m_bv;
+    m_ef = o.m_ef;
+    m_run_bases = o.m_run_bases;
+    m_rs0 = o.m_rs0;
+    m_rs0.set_vector(&m_bv);
+  }
+
+  template <class Seq> void build(const Seq &syms, const size_type n) {
+    std::vector<uint64_t> prefix(n);
+    m_run_bases = sdsl::int_vector<>((n + ef_block - 1) / ef_block, 0, 64);
+    uint64_t base = 0;
+    for (size_type i = 0; i < n; ++i) {
+      if (!m_bv[i] && i > 0) {
+        base = prefix[i - 1];
+      }
+      if (i % ef_block == 0) {
+        m_run_bases[i / ef_block] = base;
+      }
+      prefix[i] = base + syms[i];
+      if (prefix[i] < base)
+        throw std::overflow_error(
+            "compact_trie_ef: the prefix sums of the runs exceed 64 bits"
+        );
+    }
+    m_ef = ef_type(prefix);
+    sdsl::util::bit_compress(m_run_bases);
+    m_rs0 = cds::rank_select_support<0>(&m_bv);
+  }
+
+  /*
+      Receives a position of the sequence
+      Returns P[s - 1], where s is the start of its run (0 if s = 0)
+  */
+  inline uint64_t run_base(size_type i) const {
+    const size_type b = i / ef_block, first = b * ef_block;
+    // Last 0 of bv in [first, i], at most two words away
+    while (true) {
+      const size_type from = (i - first >= 63) ? i - 63 : first;
+      const uint64_t len = i - from + 1;
+      uint64_t w = ~m_bv.get_int(from, len);
+      if (len < 64)
+        w &= (1ULL << len) - 1;
+      if (w) {
+        const size_type s = from + sdsl::bits::hi(w);
+        return (s == first) ? m_run_bases[b] : m_ef[s - 1];
+      }
+      if (from == first)
+        return m_run_bases[b];
+      i = from - 1;
+    }
+  }
+
+  inline value_type value(const size_type i) const {
+    return m_ef[i] - run_base(i);
+  }
+
+public:
+  const seq_type &seq = m_seq_view;
+  const sdsl::bit_vector &bv = m_bv;
+
+  compact_trie_ef_t() = default;
+
+  template <class t_sym>
+  compact_trie_ef_t(
+      const std::vector<t_sym> &syms,
+      const std::vector<size_type> &lengths
+  ) {
+    m_bv = sdsl::bit_vector(syms.size() + 1, 1);
+    m_bv[0] = 0;
+    uint64_t pos_bv = 0;
+    for (const auto &len : lengths) {
+      pos_bv = pos_bv + len;
+      m_bv[pos_bv] = 0;
+    }
+    build(syms, syms.size());
+  }
+
+  compact_trie_ef_t(sdsl::bit_vector &_bv, sdsl::int_vector<> &_seq) {
+    m_bv = _bv;
+    build(_seq, _seq.size());
+  }
+
+  //! Copy constructor
+  compact_trie_ef_t(const compact_trie_ef_t &o) {
+    copy(o);
+  }
+
+  //! Move constructor
+  compact_trie_ef_t(compact_trie_ef_t &&o) {
+    *this = std::move(o);
+  }
+
+  //! Copy Operator=
+  compact_trie_ef_t &operator=(const compact_trie_ef_t &o) {
+    if (this != &o) {
+      copy(o);
+    }
+    return *this;
+  }
+
+  //! Move Operator=
+  compact_trie_ef_t &operator=(compact_trie_ef_t &&o) {
+    if (this != &o) {
+      m_bv = std::move(o.m_bv);
+      m_ef = std::move(o.m_ef);
+      m_run_bases = std::move(o.m_run_bases);
+      m_rs0 = std::move(o.m_rs0);
+      m_rs0.set_vector(&m_bv);
+    }
+    return *this;
+  }
+
+  void swap(compact_trie_ef_t &o) {
+    std::swap(m_bv, o.m_bv);
+    m_ef.swap(o.m_ef);
+    std::swap(m_run_bases, o.m_run_bases);
+    m_rs0.swap(o.m_rs0);
+    m_rs0.set_vector(&m_bv);
+    o.m_rs0.set_vector(&o.m_bv);
+  }
+
+  /*
+      Degree of the trie root (metatrie layout)
+  */
+  size_type root_degree() const {
+    return m_rs0.succ(1);
+  }
+
+  /*
+      Receives index of current node and the child that is required
+      Returns index of the nth child of current node
+  */
+  inline size_type child(size_type it, size_type n, size_type gap = 1) const {
+    return m_rs0.select(it + gap + n);
+  }
+
+  inline size_type nodeselect(size_type it, size_type gap = 1) const {
+    return child(it, 1, gap);
+  }
+
+  /*
+      Receives index of node whos children we want to count
+      Returns how many children said node has
+  */
+  size_type children(size_type i) const {
+    return m_rs0.succ(i + 1) - i;
+  }
+
+  size_type first_child(size_type i) const {
+    return i;
+  }
+
+  /*
+      [i, f] is a range of siblings, so the seek is a next_geq of
+      P[s - 1] + val on P.
+  */
+  std::pair<value_type, size_type>
+  binary_search_seek(value_type val, size_type i, size_type f) const {
+    const uint64_t base = run_base(i);
+    if (val > -1ULL - base) // Larger than every symbol
+      return std::make_pair(0, f + 1);
+    const auto r = m_ef.next_geq(base + val, i, f);
+    if (r.second > f)
+      return std::make_pair(0, f + 1);
+    return std::make_pair(r.first - base, r.second);
+  }
+
+  // The next_geq of Elias-Fano already skips ahead, there is no gallop
+  std::pair<value_type, size_type>
+  gallop_seek(value_type val, size_type i, size_type f) const {
+    return binary_search_seek(val, i, f);
+  }
+
+  // Prefetches the block of m_ef where the seek from i starts
+  inline void prefetch_gallop(size_type i, size_type) const {
+    m_ef.prefetch(i);
+  }
+
+  void print() const {
+    for (size_type i = 0; i < m_bv.size(); ++i) {
+      std::cout << (uint)m_bv[i];
+    }
+    std::cout << std::endl;
+  }
+
+  //! Serializes the data structure into the given ostream
+  size_type serialize(
+      std::ostream &out,
+      sdsl::structure_tree_node *v = nullptr,
+      std::string name = ""
+  ) const {
+    sdsl::structure_tree_node *child =
+        sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+    size_type written_bytes = 0;
+    written_bytes += m_bv.serialize(out, child, "bv");
+    written_bytes += m_ef.serialize(out, child, "ef");
+    written_bytes += m_run_bases.serialize(out, child, "run_bases");
+    written_bytes += m_rs0.serialize(out, child, "rs0");
+    sdsl::structure_tree::add_size(child, written_bytes);
+    return written_bytes;
+  }
+
+  void load(std::istream &in) {
+    m_bv.load(in);
+    m_ef.load(in);
+    m_run_bases.load(in);
+    m_rs0.load(in, &m_bv);
+  }
+};
+
+// Trie of the triples with IDs of 32 bits
+typedef compact_trie_ef_t<uint32_t> compact_trie_ef;
+} // namespace cltj
+#endif
@@ -0,0 +1,160 @@
+#ifndef CLTJ_COMPACT_TRIE_HASHED_H
+#define CLTJ_COMPACT_TRIE_HASHED_H
+
+#include <hashing/child_index.hpp>
+#include <memory>
+#include <trie/cltj_compact_trie.hpp>
+#include <util/logger.hpp>
+
+namespace cltj {
+
+/**
+ * @brief Compact trie with a side index for its high-degree nodes.
+ *
+ * The nodes with at least min_degree children are indexed with a MPHF
+ * (cltj::hashing::ChildIndex), so a seek for a symbol in one of them is a
+ * hash lookup instead of a search. When the symbol is not a child, the
+ * search is done as usual. It needs C++17, since the MPHF does.
+ *
+ * @tparam t_value  Type of the symbols (the IDs of the triples)
+ */
+template <class t_value>
+class compact_trie_hashed_t : public compact_trie_t<t_value> {
+
+public:
+  typedef uint64_t size_type;
+  typedef t_value value_type;
+  typedef compact_trie_t<t_value> base_type;
+  typedef cltj::hashing::ChildIndex<> child_index_type;
+
+private:
+  // The MPHF is neither copyable nor movable, and it is not modified after
+  // it is built, so the copies of the trie share it
+  std::shared_ptr<const child_index_type> m_children;
+
+  // Position of val in [i, f], a range of children that ends in the last one
+  inline uint64_t find_child(value_type val, size_type i, size_type f) const {
+    if (!m_children->covers(f - i + 1))
+      return child_index_type::NOT_FOUND;
+    return m_children->find(this->seq, val, i, f);
+  }
+
+  /*
+      The index tries several seeds. If none of them works no node is
+      indexed, so the seeks are correct but always search.
+  */
+  void build_children(const uint32_t min_degree) {
+    auto children = std::make_shared<child_index_type>();
+    if (!children->build(this->bv, this->seq, min_degree)) {
+      LOG_WARN(
+          "[compact_trie_hashed] The index of the nodes with at least "
+          << min_degree << " children could not be built"
+      );
+    }
+    m_children = children;
+  }
+
+public:
+  compact_trie_hashed_t() : m_children(std::make_shared<child_index_type>()) {}
+
+  template <class t_sym>
+  compact_trie_hashed_t(
+      const std::vector<t_sym> &syms,
+      const std::vector<size_type> &lengths,
+      const uint32_t min_degree = child_index_type::DEFAULT_MIN_DEGREE
+  )
+      : base_type(syms, lengths) {
+    build_children(min_degree);
+  }
+
+  //! From a compact trie that is already built
+  compact_trie_hashed_t(
+      base_type &&trie,
+      const uint32_t min_degree = child_index_type::DEFAULT_MIN_DEGREE
+  )
+      : base_type(std::move(trie)) {
+    build_children(min_degree);
+  }
+
+  //! Copy constructor
+  compact_trie_hashed_t(const compact_trie_hashed_t &o)
+      : base_type(o), m_children(o.m_children) {}
+
+  //! Move constructor
+  compact_trie_hashed_t(compact_trie_hashed_t &&o)
+      : base_type(std::move(o)), m_children(std::move(o.m_children)) {}
+
+  //! Copy Operator=
+  compact_trie_hashed_t &operator=(const compact_trie_hashed_t &o) {
+    if (this != &o) {
+      base_type::operator=(o);
+      m_children = o.m_children;
+    }
+    return *this;
+  }
+
+  //! Move Operator=
+  compact_trie_hashed_t &operator=(compact_trie_hashed_t &&o) {
+    if (this != &o) {
+      base_type::operator=(std::move(o));
+      m_children = std::move(o.m_children);
+    }
+    return *this;
+  }
+
+  void swap(compact_trie_hashed_t &o) {
+    base_type::swap(o);
+    std::swap(m_children, o.m_children);
+  }
+
+  inline const child_index_type &children_index() const {
+    return *m_children;
+  }
+
+  std::pair<value_type, size_type>
+  binary_search_seek(value_type val, size_type i, size_type f) const {
+    const uint64_t pos = find_child(val, i, f);
+    if (pos != child_index_type::NOT_FOUND)
+      return std::make_pair(val, pos);
+    return base_type::binary_search_seek(val, i, f);
+  }
+
+  /*
+      The hash lookup is only tried when the rest of the range is large,
+      since the gallop is cheap when the result is close to i.
+  */
+  std::pair<value_type, size_type>
+  gallop_seek(value_type val, size_type i, size_type f) const {
+    const uint64_t pos = find_child(val, i, f);
+    if (pos != child_index_type::NOT_FOUND)
+      return std::make_pair(val, pos);
+    return base_type::gallop_seek(val, i, f);
+  }
+
+  //! Serializes the data structure into the given ostream
+  size_type serialize(
+      std::ostream &out,
+      sdsl::structure_tree_node *v = nullptr,
+      std::string name = ""
+  ) const {
+    sdsl::structure_tree_node *child =
+        sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+    size_type written_bytes = 0;
+    written_bytes += base_type::serialize(out, child, "trie");
+    written_bytes += m_children->serialize(out, child, "children");
+    sdsl::structure_tree::add_size(child, written_bytes);
+    return written_bytes;
+  }
+
+  void load(std::istream &in) {
+    base_type::load(in);
+    auto children = std::make_shared<child_index_type>();
+    children->load(in);
+    m_children = children;
+  }
+};
+
+// Trie of the triples with IDs of 32 bits
+typedef compact_trie_hashed_t<uint32_t> compact_trie_hashed;
+} // namespace cltj
+#endif
@@ -0,0 +1,541 @@
+#ifndef CLTJ_COMPACT_TRIE_INTERLEAVED_H
+#define CLTJ_COMPACT_TRIE_INTERLEAVED_H
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sdsl/bits.hpp>
+#include <sdsl/vectors.hpp>
+#include <string>
+#include <trie/cltj_compact_trie.hpp>
+#include <vector>
+
+namespace cltj {
+
+/**
+ * Compact trie with the bitvector, the rank/succ samples and the symbols of
+ * each block of positions interleaved in the same cache line.
+ *
+ * The topology and the positions are the ones of compact_trie (a 0 in bv at
+ * the start of each run of siblings), but instead of four arrays (bv, seq,
+ * succ0 and select0 samples), the trie is a sequence of 64-byte lines
+ * aligned to the cache lines. The line of block b covers the positions
+ * [b * K, (b + 1) * K) and stores:
+ *
+ *  - word 0: number of zeros of bv before the block (40 bits) and distance
+ *    from the end of the block to the next zero (24 bits, saturated).
+ *  - K bits of bv, from bit 64.
+ *  - the K symbols, bit-compressed, after the bits of bv.
+ *
+ * K depends on the width of the symbols (K = min(64, 448 / (width + 1))).
+ * children() and the seeks in a run that fits in a line touch only that
+ * line. select0 needs a directory by number of zeros, which is the only
+ * separate array: it keeps the line of one zero out of every 2^s, with s
+ * chosen so that there is about one sample per line.
+ *
+ * @tparam t_value  Type of the symbols (the IDs of the triples)
+ */
+template <class t_value> class compact_trie_interleaved_t {
+
+public:
+  typedef uint64_t size_type;
+  typedef t_value value_type;
+
+  enum {
+    line_words = 8,      // 64-byte lines
+    line_bits = 512,
+    header_bits = 64,
+    rank_bits = 40,      // Zeros before the block
+    dist_cap = 0xFFFFFF, // Saturated distance to the next zero (24 bits)
+    max_sample_log = 6
+  };
+
+  //! Random access to the symbols of the trie
+  class seq_view {
+  private:
+    const compact_trie_interleaved_t *m_trie;
+
+  public:
+    typedef uint64_t size_type;
+    typedef t_value value_type;
+
+    explicit seq_view(const compact_trie_interleaved_t *trie) : m_trie(trie) {}
+
+    inline value_type operator[](const size_type i) const {
+      return m_trie->symbol(i / m_trie->m_block, i % m_trie->m_block);
+    }
+
+    inline size_type size() const {
+      return m_trie->m_seq_size;
+    }
+  };
+
+  //! Random access to the bits of the topology
+  class bv_view {
+  private:
+    const compact_trie_interleaved_t *m_trie;
+
+  public:
+    typedef uint64_t size_type;
+
+    explicit bv_view(const compact_trie_interleaved_t *trie) : m_trie(trie) {}
+
+    inline bool operator[](const size_type i) const {
+      return (m_trie->bits(i / m_trie->m_block) >> (i % m_trie->m_block)) & 1;
+    }
+
+    inline size_type size() const {
+      return m_trie->m_size;
+    }
+  };
+
+  typedef seq_view seq_type;
+
+private:
+  size_type m_size = 0;     // Bits of bv
+  size_type m_seq_size = 0; // Symbols
+  size_type m_zeros = 0;    // Zeros of bv
+  size_type m_lines_n = 0;
+  uint8_t m_width = 1;      // Width of the symbols
+  uint8_t m_block = 64;     // K, positions per line
+  uint8_t m_sample_log = 0; // One sample every 2^m_sample_log zeros
+  sdsl::int_vector<64> m_words; // Lines, plus padding to align them
+  const uint64_t *m_lines = nullptr;
+  sdsl::int_vector<> m_samples; // Line of the zeros 1, 2^s + 1, 2 * 2^s + 1...
+  seq_view m_seq_view{this};
+  bv_view m_bv_view{this};
+
+  void copy(const compact_trie_interleaved_t &o) {
+    m_size = o.m_size;
+    m_seq_size = o.m_seq_size;
+    m_zeros = o.m_zeros;
+    m_width = o.m_width;
+    m_block = o.m_block;
+    m_sample_log = o.m_sample_log;
+    m_samples = o.m_samples;
+    assign_lines(o.m_lines, o.m_lines_n);
+  }
+
+  // Allocates n lines aligned to 64 bytes (copied from src if not null)
+  uint64_t *assign_lines(const uint64_t *src, const size_type n) {
+    m_lines_n = n;
+    m_words = sdsl::int_vector<64>(n * line_words + line_words, 0);
+    uint64_t *data = m_words.data();
+    const uint64_t misalign = reinterpret_cast<uintptr_t>(data) & 63;
+    uint64_t *lines = data + (misalign ? (64 - misalign) / 8 : 0);
+    if (src != nullptr && n > 0) {
+      std::memcpy(lines, src, n * line_words * sizeof(uint64_t));
+    }
+    m_lines = lines;
+    return lines;
+  }
+
+  static inline uint64_t low_mask(const uint64_t len) {
+    return (len >= 64) ? -1ULL : ((1ULL << len) - 1);
+  }
+
+  static inline uint64_t
+  get_bits(const uint64_t *line, const size_type off, const uint8_t len) {
+    const size_type word = off >> 6, shift = off & 63;
+    uint64_t x = line[word] >> shift;
+    if (shift + len > 64)
+      x |= line[word + 1] << (64 - shift);
+    return x & low_mask(len);
+  }
+
+  static inline void
+  set_bits(uint64_t *line, const size_type off, uint64_t x, const uint8_t len) {
+    for (uint8_t k = 0; k < len; ++k, x >>= 1) {
+      const size_type p = off + k;
+      line[p >> 6] |= (x & 1ULL) << (p & 63);
+    }
+  }
+
+  inline const uint64_t *line(const size_type b) const {
+    return m_lines + b * line_words;
+  }
+
+  inline uint64_t bits(const size_type b) const {
+    return line(b)[1] & low_mask(m_block);
+  }
+
+  inline size_type rank_before(const size_type b) const {
+    return line(b)[0] & low_mask(rank_bits);
+  }
+
+  inline value_type symbol(const size_type b, const size_type j) const {
+    return get_bits(line(b), header_bits + m_block + j * m_width, m_width);
+  }
+
+  // First j in [j0, j1] of block b with a symbol >= val (j1 + 1 if none)
+  inline size_type seek_line(
+      const value_type val,
+      const size_type b,
+      size_type j0,
+      size_type j1
+  ) const {
+    if (symbol(b, j1) < val)
+      return j1 + 1;
+    size_type mid;
+    while (j0 < j1) {
+      mid = (j0 + j1) / 2;
+      if (symbol(b, mid) < val) {
+        j0 = mid + 1;
+      } else {
+        j1 = mid;
+      }
+    }
+    return j0;
+  }
+
+  template <class BitVector, class Seq>
+  void build(const BitVector &bv, const Seq &syms, const size_type n_syms) {
+    m_size = bv.size();
+    m_seq_size = n_syms;
+    uint64_t max_sym = 0;
+    for (size_type i = 0; i < n_syms; ++i) {
+      max_sym = std::max<uint64_t>(max_sym, syms[i]);
+    }
+    m_width = max_sym ? sdsl::bits::hi(max_sym) + 1 : 1;
+    m_block = std::min(64, (line_bits - header_bits) / (m_width + 1));
+    const size_type K = m_block;
+    uint64_t *lines = assign_lines(nullptr, (m_size + K - 1) / K);
+
+    m_zeros = 0;
+    for (size_type b = 0; b < m_lines_n; ++b) {
+      uint64_t *l = lines + b * line_words;
+      l[0] = m_zeros;
+      uint64_t word = low_mask(K); // Positions after the end of bv are ones
+      for (size_type j = 0; j < K && b * K + j < m_size; ++j) {
+        const size_type p = b * K + j;
+        if (!bv[p]) {
+          word &= ~(1ULL << j);
+          ++m_zeros;
+        }
+        if (p < n_syms) {
+          set_bits(l, header_bits + K + j * m_width, syms[p], m_width);
+        }
+      }
+      l[1] |= word;
+    }
+    // Distance from the end of each block to the next zero
+    size_type next = m_size;
+    for (size_type b = m_lines_n; b-- > 0;) {
+      uint64_t *l = lines + b * line_words;
+      const size_type end = (b + 1) * K;
+      const uint64_t cap = static_cast<uint64_t>(dist_cap);
+      const uint64_t dist =
+          (next == m_size || next - end >= cap) ? cap : next - end;
+      l[0] |= dist << rank_bits;
+      const uint64_t zeros = ~l[1] & low_mask(K);
+      if (zeros) {
+        next = b * K + sdsl::bits::lo(zeros);
+      }
+    }
+    // About one sample per line
+    const size_type density = m_size ? (m_zeros * K) / m_size : 0;
+    m_sample_log = 0;
+    while (m_sample_log < max_sample_log &&
+           (size_type(2) << m_sample_log) <= density) {
+      ++m_sample_log;
+    }
+    m_samples = sdsl::int_vector<>(
+        (m_zeros + (1ULL << m_sample_log) - 1) >> m_sample_log, 0, 64
+    );
+    size_type z = 0;
+    for (size_type b = 0; b < m_lines_n; ++b) {
+      uint64_t zeros = ~lines[b * line_words + 1] & low_mask(K);
+      for (; zeros; zeros &= zeros - 1, ++z) {
+        if ((z & low_mask(m_sample_log)) == 0) {
+          m_samples[z >> m_sample_log] = b;
+        }
+      }
+    }
+    sdsl::util::bit_compress(m_samples);
+  }
+
+  /*
+      Receives k >= 1
+      Returns the position of the kth zero of bv
+  */
+  size_type select0(const size_type k) const {
+    const size_type s = (k - 1) >> m_sample_log;
+    size_type b = m_samples[s];
+    while (true) {
+      const uint64_t *l = line(b);
+      const size_type rank = l[0] & low_mask(rank_bits);
+      const uint64_t zeros = ~l[1] & low_mask(m_block);
+      const size_type cnt = sdsl::bits::cnt(zeros);
+      if (rank + cnt >= k)
+        return b * m_block + sdsl::bits::sel(zeros, k - rank);
+      const uint64_t dist = l[0] >> rank_bits;
+      if (dist != dist_cap) {
+        b = ((b + 1) * m_block + dist) / m_block;
+        continue;
+      }
+      // Too far for the hint: last line before the next sample with less
+      // than k zeros before it
+      size_type lo = b + 1;
+      size_type hi = (s + 1 < m_samples.size()) ? size_type(m_samples[s + 1])
+                                                 : m_lines_n - 1;
+      size_type mid;
+      while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        if (rank_before(mid) < k) {
+          lo = mid;
+        } else {
+          hi = mid - 1;
+        }
+      }
+      b = lo;
+    }
+  }
+
+  /*
+      Receives a position of bv
+      Returns the position of the first zero at or after it (or the size)
+  */
+  size_type succ0(const size_type p) const {
+    if (p >= m_size)
+      return m_size;
+    const size_type b = p / m_block;
+    const uint64_t *l = line(b);
+    const uint64_t zeros = ~l[1] & low_mask(m_block);
+    const uint64_t after = zeros & (-1ULL << (p % m_block));
+    if (after)
+      return b * m_block + sdsl::bits::lo(after);
+    const uint64_t dist = l[0] >> rank_bits;
+    if (dist != dist_cap)
+      return (b + 1) * m_block + dist;
+    const size_type rank =
+        (l[0] & low_mask(rank_bits)) + sdsl::bits::cnt(zeros);
+    return (rank < m_zeros) ? select0(rank + 1) : m_size;
+  }
+
+public:
+  const seq_type &seq = m_seq_view;
+  const bv_view &bv = m_bv_view;
+
+  compact_trie_interleaved_t() = default;
+
+  template <class t_sym>
+  compact_trie_interleaved_t(
+      const std::vector<t_sym> &syms,
+      const std::vector<size_type> &lengths
+  ) {
+    sdsl::bit_vector bv(syms.size() + 1, 1);
+    bv[0] = 0;
+    uint64_t pos_bv = 0;
+    for (const auto &len : lengths) {
+      pos_bv = pos_bv + len;
+      bv[pos_bv] = 0;
+    }
+    build(bv, syms, syms.size());
+  }
+
+  compact_trie_interleaved_t(sdsl::bit_vector &_bv, sdsl::int_vector<> &_seq) {
+    build(_bv, _seq, _seq.size());
+  }
+
+  //! From a compact trie that is already built (same positions)
+  explicit compact_trie_interleaved_t(const compact_trie_t<t_value> &trie) {
+    build(trie.bv, trie.seq, trie.seq.size());
+  }
+
+  //! Copy constructor
+  compact_trie_interleaved_t(const compact_trie_interleaved_t &o) {
+    copy(o);
+  }
+
+  //! Move constructor
+  compact_trie_interleaved_t(compact_trie_interleaved_t &&o) {
+    *this = std::move(o);
+  }
+
+  //! Copy Operator=
+  compact_trie_interleaved_t &operator=(const compact_trie_interleaved_t &o) {
+    if (this != &o) {
+      copy(o);
+    }
+    return *this;
+  }
+
+  //! Move Operator=
+  compact_trie_interleaved_t &operator=(compact_trie_interleaved_t &&o) {
+    if (this != &o) {
+      m_size = o.m_size;
+      m_seq_size = o.m_seq_size;
+      m_zeros = o.m_zeros;
+      m_lines_n = o.m_lines_n;
+      m_width = o.m_width;
+      m_block = o.m_block;
+      m_sample_log = o.m_sample_log;
+      m_words = std::move(o.m_words); // The buffer, and its alignment, moves
+      m_lines = o.m_lines;
+      o.m_lines = nullptr;
+      m_samples = std::move(o.m_samples);
+    }
+    return *this;
+  }
+
+  void swap(compact_trie_interleaved_t &o) {
+    std::swap(m_size, o.m_size);
+    std::swap(m_seq_size, o.m_seq_size);
+    std::swap(m_zeros, o.m_zeros);
+    std::swap(m_lines_n, o.m_lines_n);
+    std::swap(m_width, o.m_width);
+    std::swap(m_block, o.m_block);
+    std::swap(m_sample_log, o.m_sample_log);
+    m_words.swap(o.m_words);
+    std::swap(m_lines, o.m_lines);
+    m_samples.swap(o.m_samples);
+  }
+
+  /*
+      Degree of the trie root (metatrie layout)
+  */
+  size_type root_degree() const {
+    return succ0(1);
+  }
+
+  /*
+      Receives index of current node and the child that is required
+      Returns index of the nth child of current node
+  */
+  inline size_type child(size_type it, size_type n, size_type gap = 1) const {
+    return select0(it + gap + n);
+  }
+
+  inline size_type nodeselect(size_type it, size_type gap = 1) const {
+    return child(it, 1, gap);
+  }
+
+  /*
+      Receives index of node whos children we want to count
+      Returns how many children said node has
+  */
+  size_type children(size_type i) const {
+    return succ0(i + 1) - i;
+  }
+
+  size_type first_child(size_type i) const {
+    return i;
+  }
+
+  /*
+      Bisects the lines of [i, f] by their last symbol, and then the
+      symbols of the line.
+  */
+  std::pair<value_type, size_type>
+  binary_search_seek(value_type val, size_type i, size_type f) const {
+    const size_type K = m_block, bi = i / K, bf = f / K;
+    if (symbol(bf, f % K) < val)
+      return std::make_pair(0, f + 1);
+    size_type lo = bi, hi = bf, mid;
+    while (lo < hi) {
+      mid = (lo + hi) / 2;
+      if (symbol(mid, K - 1) < val) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    const size_type j = seek_line(
+        val, lo, (lo == bi) ? i % K : 0, (lo == bf) ? f % K : K - 1
+    );
+    return std::make_pair(symbol(lo, j), lo * K + j);
+  }
+
+  /*
+      Same result as binary_search_seek. It searches the line of i first,
+      and then gallops over the next lines (1, 2, 4... lines ahead).
+  */
+  std::pair<value_type, size_type>
+  gallop_seek(value_type val, size_type i, size_type f) const {
+    const size_type K = m_block, bi = i / K, bf = f / K;
+    const size_type last = (bi == bf) ? f % K : K - 1;
+    size_type j = seek_line(val, bi, i % K, last);
+    if (j <= last)
+      return std::make_pair(symbol(bi, j), bi * K + j);
+    if (bi == bf)
+      return std::make_pair(0, f + 1);
+    size_type lo = bi + 1, hi = lo, step = 1, mid;
+    while (symbol(hi, (hi == bf) ? f % K : K - 1) < val) {
+      if (hi == bf)
+        return std::make_pair(0, f + 1);
+      lo = hi + 1;
+      hi = std::min(bf, hi + step);
+      step <<= 1;
+    }
+    while (lo < hi) {
+      mid = (lo + hi) / 2;
+      if (symbol(mid, K - 1) < val) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    j = seek_line(val, lo, 0, (lo == bf) ? f % K : K - 1);
+    return std::make_pair(symbol(lo, j), lo * K + j);
+  }
+
+  // Prefetches the line of i, where gallop_seek(val, i, f) starts
+  inline void prefetch_gallop(size_type i, size_type) const {
+#if defined(__GNUC__)
+    __builtin_prefetch(line(i / m_block));
+#endif
+  }
+
+  void print() const {
+    for (size_type i = 0; i < m_size; ++i) {
+      std::cout << (uint)bv[i];
+    }
+    std::cout << std::endl;
+  }
+
+  //! Serializes the data structure into the given ostream
+  size_type serialize(
+      std::ostream &out,
+      sdsl::structure_tree_node *v = nullptr,
+      std::string name = ""
+  ) const {
+    sdsl::structure_tree_node *child =
+        sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+    size_type written_bytes = 0;
+    written_bytes += sdsl::write_member(m_size, out, child, "size");
+    written_bytes += sdsl::write_member(m_seq_size, out, child, "seq_size");
+    written_bytes += sdsl::write_member(m_zeros, out, child, "zeros");
+    written_bytes += sdsl::write_member(m_width, out, child, "width");
+    written_bytes += sdsl::write_member(m_block, out, child, "block");
+    written_bytes += sdsl::write_member(m_sample_log, out, child, "sample_log");
+    // Only the lines, the alignment depends on the allocation
+    sdsl::int_vector<64> lines(m_lines_n * line_words, 0);
+    if (m_lines_n > 0) {
+      std::memcpy(
+          lines.data(), m_lines, m_lines_n * line_words * sizeof(uint64_t)
+      );
+    }
+    written_bytes += lines.serialize(out, child, "lines");
+    written_bytes += m_samples.serialize(out, child, "samples");
+    sdsl::structure_tree::add_size(child, written_bytes);
+    return written_bytes;
+  }
+
+  void load(std::istream &in) {
+    sdsl::read_member(m_size, in);
+    sdsl::read_member(m_seq_size, in);
+    sdsl::read_member(m_zeros, in);
+    sdsl::read_member(m_width, in);
+    sdsl::read_member(m_block, in);
+    sdsl::read_member(m_sample_log, in);
+    sdsl::int_vector<64> lines;
+    lines.load(in);
+    assign_lines(lines.data(), lines.size() / line_words);
+    m_samples.load(in);
+  }
+};
+
+// Trie of the triples with IDs of 32 bits
+typedef compact_trie_interleaved_t<uint32_t> compact_trie_interleaved;
+} // namespace cltj
+#endif
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <queue>
 #include <string>
+#include <util/prefetch.hpp>
 #include <vector>
 
 namespace cltj {
@@ -14,6 +15,7 @@ class uncompact_trie {
 public:
   typedef uint64_t size_type;
   typedef uint32_t value_type;
+  typedef sdsl::int_vector<> seq_type;
 
 private:
   sdsl::int_vector<> m_ptr;
@@ -96,7 +98,7 @@ public:
       Receives index of node in ptr vector
       Returns index of child in ptr vector
   */
-  inline size_type child(uint32_t it, uint32_t n, uint32_t gap = 1) const {
+  inline size_type child(size_type it, size_type n, size_type gap = 1) const {
     // if(gap == 1) return m_ptr[it] + n - 1; //there is a root
     if (gap == 0)
       return n - 1; // there is no root but we are in the first level
@@ -125,11 +127,11 @@ public:
     // return i;
   }
 
-  std::pair<uint32_t, uint64_t>
-  binary_search_seek(uint32_t val, uint32_t i, uint32_t f) const {
+  std::pair<value_type, size_type>
+  binary_search_seek(value_type val, size_type i, size_type f) const {
     if (m_seq[f] < val)
       return std::make_pair(0, f + 1);
-    uint32_t mid;
+    size_type mid;
     while (i < f) {
       mid = (i + f) / 2;
       if (m_seq[mid] < val) {
@@ -141,6 +143,39 @@ public:
     return std::make_pair(m_seq[i], i);
   }
 
+  /*
+      Same result as binary_search_seek, but the search gallops from i
+      (1, 2, 4... positions ahead) before bisecting. Successive seeks in
+      leapfrog are usually close to the previous position, so this costs
+      O(log d) accesses, where d is the distance from i to the result.
+  */
+  std::pair<value_type, size_type>
+  gallop_seek(value_type val, size_type i, size_type f) const {
+    size_type hi = i, step = 1;
+    while (m_seq[hi] < val) {
+      if (hi == f)
+        return std::make_pair(0, f + 1);
+      i = hi + 1;
+      hi = (f - hi > step) ? hi + step : f;
+      step <<= 1;
+    }
+    size_type mid;
+    while (i < hi) {
+      mid = (i + hi) / 2;
+      if (m_seq[mid] < val) {
+        i = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return std::make_pair(m_seq[i], i);
+  }
+
+  // Prefetches the first positions that gallop_seek(val, i, f) probes
+  inline void prefetch_gallop(size_type i, size_type f) const {
+    ::util::prefetch_gallop(m_seq, i, f);
+  }
+
   //! Serializes the data structure into the given ostream
   size_type serialize(
       std::ostream &out,
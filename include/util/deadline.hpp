@@ -0,0 +1,96 @@
+#ifndef UTIL_DEADLINE_HPP
+#define UTIL_DEADLINE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace util {
+
+/**
+ * @brief Deadline and cancellation token of a search.
+ *
+ * The search calls expired() at every step. It only reads the clock once
+ * every check_period calls, so the cost on the hot path is an increment and
+ * a relaxed load. The calls are counted per thread, so the workers of a
+ * parallel search only share the flag. cancel() may be called from any
+ * thread to abort the search at its next step.
+ */
+class deadline {
+
+public:
+  typedef uint64_t size_type;
+  typedef std::chrono::steady_clock clock_type;
+  typedef clock_type::time_point time_point_type;
+
+  // Calls to expired() between two reads of the clock (power of two)
+  static constexpr uint32_t check_period = 256;
+
+private:
+  std::atomic<bool> m_cancelled{false};
+  bool m_has_limit = false;
+  time_point_type m_start = clock_type::now();
+  time_point_type m_end;
+
+public:
+  //! Without time limit: it only expires when it is cancelled
+  deadline() = default;
+
+  /**
+   *
+   * @param milliseconds  Time limit from now (0 means no limit)
+   */
+  explicit deadline(const size_type milliseconds) {
+    if (milliseconds > 0) {
+      m_has_limit = true;
+      m_end = m_start + std::chrono::milliseconds(milliseconds);
+    }
+  }
+
+  deadline(const deadline &) = delete;
+  deadline &operator=(const deadline &) = delete;
+
+  // Thread-safe
+  inline void cancel() {
+    m_cancelled.store(true, std::memory_order_relaxed);
+  }
+
+  inline bool cancelled() const {
+    return m_cancelled.load(std::memory_order_relaxed);
+  }
+
+  /*
+      Amortized check: true if it was cancelled or if the time limit was
+      exceeded at the last read of the clock
+  */
+  inline bool expired() {
+    if (m_cancelled.load(std::memory_order_relaxed))
+      return true;
+    if (!m_has_limit)
+      return false;
+    // Calls of this thread, to any deadline: it only sets when to read
+    static thread_local uint32_t steps = 0;
+    if (++steps & (check_period - 1))
+      return false;
+    return check();
+  }
+
+  // Reads the clock
+  inline bool check() {
+    if (m_has_limit && clock_type::now() >= m_end) {
+      cancel();
+    }
+    return cancelled();
+  }
+
+  inline size_type elapsed_milliseconds() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               clock_type::now() - m_start
+    )
+        .count();
+  }
+};
+
+} // namespace util
+
+#endif // UTIL_DEADLINE_HPP
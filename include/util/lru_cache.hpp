@@ -0,0 +1,157 @@
+#ifndef UTIL_LRU_CACHE_HPP
+#define UTIL_LRU_CACHE_HPP
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace util {
+
+/**
+ * @brief Map with a bounded number of entries that evicts the least recently
+ * used one when it is full.
+ *
+ * Entries are kept in a list ordered from the most to the least recently used
+ * one, and a hash table maps each key to its node of the list.
+ *
+ * @tparam Key   Hashable key
+ * @tparam Value Copyable value
+ */
+template <class Key, class Value, class Hash = std::hash<Key>>
+class lru_cache {
+
+public:
+  typedef uint64_t size_type;
+  typedef Key key_type;
+  typedef Value value_type;
+
+private:
+  typedef std::pair<key_type, value_type> entry_type;
+  typedef std::list<entry_type> list_type;
+  typedef std::unordered_map<key_type, typename list_type::iterator, Hash>
+      map_type;
+
+  size_type m_capacity = 0;
+  list_type m_entries;
+  map_type m_map;
+
+  void copy(const lru_cache &o) {
+    m_capacity = o.m_capacity;
+    m_entries = o.m_entries;
+    m_map.clear();
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+      m_map.insert({it->first, it});
+    }
+  }
+
+public:
+  lru_cache() = default;
+
+  explicit lru_cache(const size_type capacity) : m_capacity(capacity) {
+  }
+
+  //! Copy constructor
+  lru_cache(const lru_cache &o) {
+    copy(o);
+  }
+
+  //! Move constructor
+  lru_cache(lru_cache &&o) {
+    *this = std::move(o);
+  }
+
+  //! Copy Operator=
+  lru_cache &operator=(const lru_cache &o) {
+    if (this != &o) {
+      copy(o);
+    }
+    return *this;
+  }
+
+  //! Move Operator=
+  lru_cache &operator=(lru_cache &&o) {
+    if (this != &o) {
+      m_capacity = o.m_capacity;
+      m_entries = std::move(o.m_entries);
+      m_map = std::move(o.m_map);
+    }
+    return *this;
+  }
+
+  void swap(lru_cache &o) {
+    std::swap(m_capacity, o.m_capacity);
+    m_entries.swap(o.m_entries);
+    m_map.swap(o.m_map);
+  }
+
+  /*
+      Returns a pointer to the value of key (and marks it as the most
+      recently used one) or nullptr if it is not in the cache
+  */
+  value_type *find(const key_type &key) {
+    auto it = m_map.find(key);
+    if (it == m_map.end())
+      return nullptr;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return &(it->second->second);
+  }
+
+  /*
+      Inserts (or replaces) the value of key, evicting the least recently
+      used entry if the cache is full
+  */
+  value_type &insert(const key_type &key, value_type value) {
+    auto it = m_map.find(key);
+    if (it != m_map.end()) {
+      it->second->second = std::move(value);
+      m_entries.splice(m_entries.begin(), m_entries, it->second);
+      return it->second->second;
+    }
+    if (m_capacity > 0 && m_entries.size() >= m_capacity) {
+      m_map.erase(m_entries.back().first);
+      m_entries.pop_back();
+    }
+    m_entries.emplace_front(key, std::move(value));
+    m_map.insert({key, m_entries.begin()});
+    return m_entries.front().second;
+  }
+
+  void erase(const key_type &key) {
+    auto it = m_map.find(key);
+    if (it == m_map.end())
+      return;
+    m_entries.erase(it->second);
+    m_map.erase(it);
+  }
+
+  void clear() {
+    m_entries.clear();
+    m_map.clear();
+  }
+
+  // Zero means unbounded
+  void capacity(const size_type c) {
+    m_capacity = c;
+    while (m_capacity > 0 && m_entries.size() > m_capacity) {
+      m_map.erase(m_entries.back().first);
+      m_entries.pop_back();
+    }
+  }
+
+  inline size_type capacity() const {
+    return m_capacity;
+  }
+
+  inline size_type size() const {
+    return m_entries.size();
+  }
+
+  inline bool empty() const {
+    return m_entries.empty();
+  }
+};
+
+} // namespace util
+
+#endif // UTIL_LRU_CACHE_HPP
@@ -0,0 +1,130 @@
+#ifndef UTIL_PERF_COUNTERS_HPP
+#define UTIL_PERF_COUNTERS_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace util {
+
+namespace perf {
+
+/**
+ * Hardware counters of the calling thread (cache misses, L1d load misses,
+ * dTLB load misses) read with perf_event_open. A counter that cannot be
+ * opened (no permission, no PMU, not Linux) reads as 0 and
+ * available(i) is false, so the benchmarks run anyway.
+ */
+class counters {
+
+public:
+  enum { cache_misses = 0, l1d_load_misses = 1, dtlb_load_misses = 2 };
+
+private:
+  std::vector<int> m_fds;
+  std::vector<uint64_t> m_values;
+
+#if defined(__linux__)
+  static int open_event(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+
+  static uint64_t cache_event(uint64_t cache, uint64_t result) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+  }
+#endif
+
+public:
+  counters() : m_fds(3, -1), m_values(3, 0) {
+#if defined(__linux__)
+    m_fds[cache_misses] =
+        open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    m_fds[l1d_load_misses] = open_event(
+        PERF_TYPE_HW_CACHE,
+        cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS)
+    );
+    m_fds[dtlb_load_misses] = open_event(
+        PERF_TYPE_HW_CACHE,
+        cache_event(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_RESULT_MISS)
+    );
+#endif
+  }
+
+  counters(const counters &) = delete;
+  counters &operator=(const counters &) = delete;
+
+  ~counters() {
+#if defined(__linux__)
+    for (int fd : m_fds) {
+      if (fd >= 0)
+        close(fd);
+    }
+#endif
+  }
+
+  inline bool available(const size_t i) const {
+    return m_fds[i] >= 0;
+  }
+
+  static std::string name(const size_t i) {
+    static const char *names[] = {
+        "cache_misses", "l1d_load_misses", "dtlb_load_misses"
+    };
+    return names[i];
+  }
+
+  inline size_t size() const {
+    return m_fds.size();
+  }
+
+  //! Resets and enables the counters
+  void start() {
+#if defined(__linux__)
+    for (int fd : m_fds) {
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+  }
+
+  //! Disables and reads the counters
+  void stop() {
+    for (size_t i = 0; i < m_fds.size(); ++i) {
+      m_values[i] = 0;
+#if defined(__linux__)
+      if (m_fds[i] >= 0) {
+        ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t value = 0;
+        if (read(m_fds[i], &value, sizeof(value)) == sizeof(value))
+          m_values[i] = value;
+      }
+#endif
+    }
+  }
+
+  inline uint64_t value(const size_t i) const {
+    return m_values[i];
+  }
+};
+
+} // namespace perf
+
+} // namespace util
+
+#endif // UTIL_PERF_COUNTERS_HPP
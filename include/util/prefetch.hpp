@@ -0,0 +1,39 @@
+#ifndef UTIL_PREFETCH_HPP
+#define UTIL_PREFETCH_HPP
+
+#include <cstdint>
+
+namespace util {
+
+// Positions ahead of the start of a gallop that are prefetched
+static constexpr uint64_t prefetch_gallop_limit = 256;
+
+/**
+ * Prefetches the cache lines of a bit-compressed sequence that a gallop from
+ * i will probe first (i, i + 1, i + 3, i + 7...), up to f. The leapfrog
+ * calls it for every iterator before seeking any of them, so the misses of
+ * the k seeks overlap instead of being paid one after the other.
+ *
+ * @param seq       Sequence with width() and data() (sdsl::int_vector)
+ * @param i         First position of the gallop
+ * @param f         Last position of the range
+ */
+template <class IntVector>
+inline void prefetch_gallop(const IntVector &seq, uint64_t i, uint64_t f) {
+#if defined(__GNUC__)
+  const uint64_t width = seq.width();
+  const uint64_t *data = seq.data();
+  uint64_t last_line = -1ULL;
+  for (uint64_t d = 0; d < prefetch_gallop_limit && i + d <= f; d = 2 * d + 1) {
+    const uint64_t word = ((i + d) * width) >> 6;
+    if ((word >> 3) != last_line) { // 8 words per line
+      __builtin_prefetch(data + word);
+      last_line = word >> 3;
+    }
+  }
+#endif
+}
+
+} // namespace util
+
+#endif // UTIL_PREFETCH_HPP
@@ -5,6 +5,7 @@
 #ifndef RDF_UTIL_HPP
 #define RDF_UTIL_HPP
 
+#include <cctype>
 #include <cltj_config.hpp>
 #include <cstdint>
 #include <regex>
@@ -45,6 +46,30 @@ tokenizer(const std::string &input, const char &delimiter) {
   return res;
 }
 
+/*
+    Collapses runs of whitespace into one space (except inside quoted
+    literals) and removes leading and trailing whitespace
+*/
+std::string normalize(const std::string &s) {
+  std::string res;
+  res.reserve(s.size());
+  bool in_literal = false, pending_space = false;
+  for (char c : s) {
+    if (!in_literal && std::isspace((unsigned char)c)) {
+      pending_space = !res.empty();
+      continue;
+    }
+    if (pending_space) {
+      res.push_back(' ');
+      pending_space = false;
+    }
+    if (c == '"')
+      in_literal = !in_literal;
+    res.push_back(c);
+  }
+  return res;
+}
+
 bool is_variable(std::string &s) {
   return (s.at(0) == '?');
 }
@@ -104,8 +129,10 @@ inline cltj::spo_triple get_triple(const std::string &s) {
   return triple;
 }
 
-inline std::vector<ltj::triple_pattern> get_query(const std::string &s) {
-  std::unordered_map<std::string, uint8_t> hash_table_vars;
+inline std::vector<ltj::triple_pattern> get_query(
+    const std::string &s,
+    std::unordered_map<std::string, uint8_t> &hash_table_vars
+) {
   std::vector<ltj::triple_pattern> query;
   std::vector<std::string> tokens_query = tokenizer(s, '.');
   for (std::string &token : tokens_query) {
@@ -115,6 +142,26 @@ inline std::vector<ltj::triple_pattern> get_query(const std::string &s) {
   return query;
 }
 
+inline std::vector<ltj::triple_pattern> get_query(const std::string &s) {
+  std::unordered_map<std::string, uint8_t> hash_table_vars;
+  return get_query(s, hash_table_vars);
+}
+
+// Terms of each triple pattern, without converting them
+inline std::vector<cltj::user_triple> get_query_terms(const std::string &s) {
+  std::vector<cltj::user_triple> query;
+  std::vector<std::string> tokens_query = tokenizer(s, '.');
+  cltj::user_triple t;
+  for (std::string &token : tokens_query) {
+    std::vector<std::string> terms = tokenizer(token, ' ');
+    t[0] = terms[0];
+    t[1] = terms[1];
+    t[2] = terms[2];
+    query.push_back(t);
+  }
+  return query;
+}
+
 } // namespace ids
 
 namespace str {
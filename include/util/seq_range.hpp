@@ -0,0 +1,105 @@
+#ifndef UTIL_SEQ_RANGE_HPP
+#define UTIL_SEQ_RANGE_HPP
+
+#include <cstdint>
+#include <iterator>
+
+namespace util {
+
+/**
+ * @brief Read-only view of the positions [beg, end) of a sequence.
+ *
+ * Nothing is copied: values are decoded from the sequence when the view is
+ * iterated, so returning a view costs as much as returning two integers.
+ *
+ * @tparam Seq Sequence with a const operator[] (sdsl::int_vector<>,
+ * dyn_cds::dyn_louds...).
+ */
+template <class Seq> class seq_range {
+
+public:
+  typedef uint64_t size_type;
+  typedef uint64_t value_type;
+  typedef Seq seq_type;
+
+  class const_iterator {
+  private:
+    const seq_type *m_seq;
+    size_type m_i;
+
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef uint64_t value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type *pointer;
+    typedef value_type reference;
+
+    const_iterator(const seq_type *seq, const size_type i)
+        : m_seq(seq), m_i(i) {
+    }
+
+    inline value_type operator*() const {
+      return (*m_seq)[m_i];
+    }
+
+    inline const_iterator &operator++() {
+      ++m_i;
+      return *this;
+    }
+
+    inline const_iterator operator++(int) {
+      const_iterator it = *this;
+      ++m_i;
+      return it;
+    }
+
+    inline bool operator==(const const_iterator &o) const {
+      return m_i == o.m_i;
+    }
+
+    inline bool operator!=(const const_iterator &o) const {
+      return m_i != o.m_i;
+    }
+  };
+
+private:
+  const seq_type *m_seq = nullptr;
+  size_type m_beg = 0;
+  size_type m_end = 0;
+
+public:
+  seq_range() = default;
+
+  seq_range(const seq_type *seq, const size_type beg, const size_type end)
+      : m_seq(seq), m_beg(beg), m_end(end) {
+  }
+
+  inline const_iterator begin() const {
+    return const_iterator(m_seq, m_beg);
+  }
+
+  inline const_iterator end() const {
+    return const_iterator(m_seq, m_end);
+  }
+
+  inline size_type size() const {
+    return m_end - m_beg;
+  }
+
+  inline bool empty() const {
+    return m_beg == m_end;
+  }
+
+  inline value_type operator[](const size_type i) const {
+    return (*m_seq)[m_beg + i];
+  }
+
+  // Subrange [i, j) of this range
+  inline seq_range slice(const size_type i, const size_type j) const {
+    return seq_range(m_seq, m_beg + i, m_beg + j);
+  }
+};
+
+} // namespace util
+
+#endif // UTIL_SEQ_RANGE_HPP
@@ -0,0 +1,184 @@
+#ifndef UTIL_WORK_STEALING_POOL_HPP
+#define UTIL_WORK_STEALING_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/**
+ * @brief Fixed-size pool of workers where each worker owns a deque of tasks.
+ *
+ * A worker pops from the back of its own deque (LIFO, keeps the working set
+ * hot) and, when it runs dry, steals from the front of the other deques
+ * (FIFO, takes the oldest and usually largest pieces of work). Tasks may push
+ * new tasks while running. A worker that finds no task sleeps until a task is
+ * pushed. The pool finishes when every pushed task has been executed or when
+ * stop() is called.
+ *
+ * @tparam Task Movable task description. Its execution is delegated to the
+ * functor given to run().
+ */
+template <class Task> class work_stealing_pool {
+
+public:
+  typedef uint64_t size_type;
+  typedef Task task_type;
+
+private:
+  struct queue_type {
+    std::mutex mutex;
+    std::deque<task_type> tasks;
+  };
+
+  std::vector<std::unique_ptr<queue_type>> m_queues;
+  std::atomic<size_type> m_pending{0};
+  std::atomic<size_type> m_idle{0};
+  std::atomic<bool> m_stop{false};
+  std::atomic<size_type> m_pushed{0}; // Tasks pushed so far
+  std::mutex m_wait_mutex;
+  std::condition_variable m_wake;
+
+  // Wakes the idle workers after a change of the state they wait for
+  void wake(const bool all) {
+    {
+      // Not in the middle of a check of the predicate of wait
+      std::lock_guard<std::mutex> lock(m_wait_mutex);
+    }
+    if (all) {
+      m_wake.notify_all();
+    } else {
+      m_wake.notify_one();
+    }
+  }
+
+  bool pop_local(const size_type w, task_type &task) {
+    queue_type &q = *m_queues[w];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty())
+      return false;
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+  }
+
+  bool steal(const size_type w, task_type &task) {
+    const size_type n = m_queues.size();
+    for (size_type k = 1; k < n; ++k) {
+      queue_type &q = *m_queues[(w + k) % n];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (!q.tasks.empty()) {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  template <class Function> void worker_loop(const size_type w, Function &f) {
+    bool is_idle = false;
+    task_type task;
+    while (!m_stop.load(std::memory_order_relaxed)) {
+      // Read before looking for tasks, so a push after the search wakes it
+      const size_type pushed = m_pushed.load();
+      if (pop_local(w, task) || steal(w, task)) {
+        if (is_idle) {
+          --m_idle;
+          is_idle = false;
+        }
+        f(w, task);
+        // After f: the tasks pushed by f are already pending
+        if (--m_pending == 0)
+          wake(true);
+      } else {
+        if (!is_idle) {
+          ++m_idle;
+          is_idle = true;
+        }
+        if (m_pending.load() == 0)
+          break;
+        // Sleeps until a task is pushed, the work runs out or it stops
+        std::unique_lock<std::mutex> lock(m_wait_mutex);
+        m_wake.wait(lock, [this, pushed]() {
+          return m_pushed.load() != pushed || m_pending.load() == 0 ||
+                 m_stop.load();
+        });
+      }
+    }
+    if (is_idle)
+      --m_idle;
+  }
+
+public:
+  explicit work_stealing_pool(const size_type n_workers) {
+    m_queues.reserve(n_workers);
+    for (size_type i = 0; i < n_workers; ++i) {
+      m_queues.emplace_back(new queue_type());
+    }
+  }
+
+  size_type workers() const {
+    return m_queues.size();
+  }
+
+  /*
+      Number of workers that are currently looking for work.
+      Running tasks use it to decide whether splitting pays off.
+  */
+  size_type idle() const {
+    return m_idle.load(std::memory_order_relaxed);
+  }
+
+  bool is_empty(const size_type w) {
+    queue_type &q = *m_queues[w];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    return q.tasks.empty();
+  }
+
+  void push(const size_type w, task_type task) {
+    ++m_pending;
+    queue_type &q = *m_queues[w];
+    {
+      std::lock_guard<std::mutex> lock(q.mutex);
+      q.tasks.push_back(std::move(task));
+    }
+    ++m_pushed;
+    wake(false);
+  }
+
+  void stop() {
+    m_stop.store(true);
+    wake(true);
+  }
+
+  bool stopped() const {
+    return m_stop.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Runs the pool until there is no pending work or stop() is called.
+   *
+   * @param f   Functor called as f(worker_id, task)
+   */
+  template <class Function> void run(Function f) {
+    std::vector<std::thread> threads;
+    threads.reserve(m_queues.size());
+    for (size_type w = 0; w < m_queues.size(); ++w) {
+      threads.emplace_back([this, &f, w]() { worker_loop(w, f); });
+    }
+    for (auto &t : threads) {
+      t.join();
+    }
+  }
+};
+
+} // namespace util
+
+#endif // UTIL_WORK_STEALING_POOL_HPP
@@ -52,12 +52,20 @@ public:
       size_type iter_pos;
   } spo_iter_type;*/
 
+  // A related variable with its iterators and its position in each of them
+  typedef struct {
+    size_type pos;
+    vector<ltj_iter_type *> iters;
+    vector<state_type> states;
+  } related_type;
+
   typedef struct {
     var_type name;
     size_type weight;
     size_type pos;
     // vector<spo_iter_type> iterators;
     unordered_set<var_type> related;
+    vector<related_type> related_iters; // Filled from related (see down())
     bool is_bound;
   } info_var_type;
 
@@ -77,6 +85,7 @@ public:
       var_to_iterators_type;
   typedef stack<version_type> versions_type;
   typedef stack<size_type> bound_type;
+  typedef pair<vector<bool>, size_type> priority_type;
 
 private:
   const vector<triple_pattern> *m_ptr_triple_patterns;
@@ -90,6 +99,8 @@ private:
   list_type m_not_bound;
   bound_type m_bound;
   versions_type m_versions;
+  vector<bool> m_priority; // By position in m_var_info
+  size_type m_priority_unbound = 0;
 
   void copy(const veo_adaptive &o) {
     m_ptr_triple_patterns = o.m_ptr_triple_patterns;
@@ -103,6 +114,36 @@ private:
     m_bound = o.m_bound;
     m_versions = o.m_versions;
     m_var_info = o.m_var_info;
+    m_priority = o.m_priority;
+    m_priority_unbound = o.m_priority_unbound;
+  }
+
+  static inline size_type weight(ltj_iter_type &iter, const state_type state) {
+    if (state == s) {
+      return veo_trait_type::subject(iter);
+    } else if (state == p) {
+      return veo_trait_type::predicate(iter);
+    }
+    return veo_trait_type::object(iter);
+  }
+
+  /*
+      Stores with each variable the positions of its related variables and
+      their iterators, so down() does not look them up on each binding
+  */
+  void fill_related_iters() {
+    for (info_var_type &info : m_var_info) {
+      info.related_iters.clear();
+      for (const auto &rel : info.related) {
+        related_type r;
+        r.pos = m_hash_table_position.at(rel);
+        for (ltj_iter_type *iter : m_ptr_var_iterators->at(rel)) {
+          r.iters.push_back(iter);
+          r.states.push_back(iter->state_of(rel));
+        }
+        info.related_iters.emplace_back(std::move(r));
+      }
+    }
   }
 
   bool var_to_vector(const var_type var, const size_type size) {
@@ -187,6 +228,7 @@ public:
       }
       ++i;
     }
+    fill_related_iters();
     m_index = 0;
     /*for(const auto & v : m_var_info){
         cout << "var=" << (uint64_t) v.name << " weight=" << v.weight << endl;
@@ -226,6 +268,8 @@ public:
       m_versions = move(o.m_versions);
       m_var_info = move(o.m_var_info);
       m_not_bound = move(o.m_not_bound);
+      m_priority = move(o.m_priority);
+      m_priority_unbound = o.m_priority_unbound;
     }
     return *this;
   }
@@ -242,24 +286,84 @@ public:
     std::swap(m_versions, o.m_versions);
     std::swap(m_var_info, o.m_var_info);
     std::swap(m_not_bound, o.m_not_bound);
+    std::swap(m_priority, o.m_priority);
+    std::swap(m_priority_unbound, o.m_priority_unbound);
+  }
+
+  /*
+      Points the VEO to a copy of its iterators, which are at the same
+      positions as in the vector that started at old_base
+  */
+  void rebind(
+      const ltj_iter_type *old_base,
+      const vector<ltj_iter_type> *iterators,
+      const var_to_iterators_type *var_iterators
+  ) {
+    ltj_iter_type *base = const_cast<ltj_iter_type *>(iterators->data());
+    for (info_var_type &info : m_var_info) {
+      for (related_type &rel : info.related_iters) {
+        for (auto &iter : rel.iters) {
+          iter = base + (iter - old_base);
+        }
+      }
+    }
+    m_ptr_iterators = iterators;
+    m_ptr_var_iterators = var_iterators;
+  }
+
+  /*
+      The given variables are chosen before the rest while any of them is
+      unbound. Lonely variables are always chosen last (their weights are not
+      maintained), so they are not affected. It must be called before the
+      search starts.
+  */
+  void prioritize(const vector<var_type> &vars) {
+    m_priority.assign(m_var_info.size(), false);
+    m_priority_unbound = 0;
+    for (const var_type var : vars) {
+      auto it = m_hash_table_position.find(var);
+      if (it != m_hash_table_position.end() && !m_priority[it->second]) {
+        m_priority[it->second] = true;
+        ++m_priority_unbound;
+      }
+    }
+  }
+
+  // Current priority, to be restored with set_priority after a search
+  priority_type get_priority() const {
+    return priority_type(m_priority, m_priority_unbound);
+  }
+
+  void set_priority(const priority_type &priority) {
+    m_priority = priority.first;
+    m_priority_unbound = priority.second;
   }
 
   inline var_type next() {
 
     if (m_index < m_var_info.size()) { // No lonely
       size_type min = -1ULL;
-      list_iterator_type min_iter;
+      list_iterator_type min_iter = m_not_bound.end();
       // Lineal search on variables that are not is_bound
       for (auto iter = m_not_bound.begin(); iter != m_not_bound.end(); ++iter) {
-        // Take the one with the smallest weight
+        // Take the one with the smallest weight. Ties are broken by position,
+        // so the choice does not depend on the order of m_not_bound, which
+        // changes with the history of the search. A resumed page descends
+        // again along the bindings of its token and expects the same
+        // variables (join_page throws if they differ)
         const auto &v = m_var_info[*iter];
-        if (min > v.weight) {
+        if (m_priority_unbound > 0 && !m_priority[*iter])
+          continue;
+        if (min_iter == m_not_bound.end() || min > v.weight ||
+            (min == v.weight && *iter < *min_iter)) {
           min = v.weight;
           min_iter = iter;
         }
       }
       // Remove from list
       size_type min_pos = *min_iter;
+      if (m_priority_unbound > 0)
+        --m_priority_unbound;
       m_var_info[min_pos].is_bound = true;
       m_bound.emplace(min_pos);
       m_not_bound.erase(min_iter
@@ -278,32 +382,22 @@ public:
     if (m_index - 1 < m_var_info.size()) { // No lonely
 
       auto pos_last = m_bound.top();
-      const auto &related = m_var_info[pos_last].related;
       version_type version;
-      for (const auto &rel : related) { // Iterates on the related variables
-        const auto pos = m_hash_table_position[rel];
-        if (!m_var_info[pos].is_bound) {
-          bool u = false;
-          size_type min_w = m_var_info[pos].weight, w;
-          auto &iters = m_ptr_var_iterators->at(rel);
-          for (ltj_iter_type *iter : iters) { // Check each iterator
-            if (iter->is_variable_subject(rel)) {
-              w = veo_trait_type::subject(*iter); // New weight
-            } else if (iter->is_variable_predicate(rel)) {
-              w = veo_trait_type::predicate(*iter);
-            } else {
-              w = veo_trait_type::object(*iter);
-            }
-            if (min_w > w) {
+      // Iterates on the related variables
+      for (const related_type &rel : m_var_info[pos_last].related_iters) {
+        info_var_type &info = m_var_info[rel.pos];
+        if (!info.is_bound) {
+          size_type min_w = info.weight;
+          for (size_type i = 0; i < rel.iters.size(); ++i) {
+            const size_type w = weight(*rel.iters[i], rel.states[i]);
+            if (min_w > w)
               min_w = w;
-              u = true;
-            }
           }
 
-          if (u) {
-            update_type update{pos, m_var_info[pos].weight};
+          if (min_w < info.weight) {
+            update_type update{rel.pos, info.weight};
             version.emplace_back(update); // Store an update
-            m_var_info[pos].weight = min_w;
+            info.weight = min_w;
           }
         }
       }
@@ -327,6 +421,8 @@ public:
       auto pos = m_bound.top();
       m_not_bound.push_back(pos); // Restart the list of unbound variables
       m_var_info[pos].is_bound = false;
+      if (!m_priority.empty() && m_priority[pos])
+        ++m_priority_unbound;
       m_bound.pop();
     }
   }
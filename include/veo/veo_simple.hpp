@@ -20,6 +20,7 @@
 #ifndef RING_VEO_SIMPLE_HPP
 #define RING_VEO_SIMPLE_HPP
 
+#include <algorithm>
 #include <cltj_utils.hpp>
 #include <index/cltj_index_spo_lite.hpp>
 #include <queue>
@@ -56,6 +57,7 @@ public:
       min_heap_type;
   typedef unordered_map<var_type, vector<ltj_iter_type *>>
       var_to_iterators_type;
+  typedef vector<var_type> priority_type;
 
 private:
   const vector<triple_pattern> *m_ptr_triple_patterns;
@@ -278,6 +280,41 @@ public:
     std::swap(m_nolonely_size, o.m_nolonely_size);
   }
 
+  /*
+      Points the VEO to a copy of its iterators. The order does not keep
+      pointers to them.
+  */
+  void rebind(
+      const ltj_iter_type *, const vector<ltj_iter_type> *iterators,
+      const var_to_iterators_type *
+  ) {
+    m_ptr_iterators = iterators;
+  }
+
+  /*
+      Moves the given variables to the front of the order, keeping their
+      relative order. Any order is valid for LTJ, so lonely variables are
+      moved too. It must be called before the search starts.
+  */
+  void prioritize(const vector<var_type> &vars) {
+    unordered_set<var_type> prioritized(vars.begin(), vars.end());
+    std::stable_partition(
+        m_order.begin(), m_order.end(),
+        [&prioritized](const var_type var) {
+          return prioritized.count(var) > 0;
+        }
+    );
+  }
+
+  // Current order, to be restored with set_priority after a search
+  priority_type get_priority() const {
+    return m_order;
+  }
+
+  void set_priority(const priority_type &priority) {
+    m_order = priority;
+  }
+
   inline var_type next() {
     ++m_index;
     return m_order[m_index - 1];
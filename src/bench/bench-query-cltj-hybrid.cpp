@@ -0,0 +1,133 @@
+/*
+ * bench-query-cltj-hybrid.cpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares pure LTJ with the hybrid plans (LTJ for the cyclic core, hash and
+ * index nested loop joins for the rest), e.g. with the queries of
+ * Queries/Queries-wikidata-benchmark.txt. For each query it prints:
+ * query;results LTJ;time LTJ (ns);results hybrid;time hybrid (ns);
+ * patterns of the core;hash joins;index nested loop joins
+ */
+
+#include <chrono>
+#include <index/cltj_index_spo_lite.hpp>
+#include <iostream>
+#include <query/ltj_algorithm.hpp>
+#include <query/ltj_hybrid.hpp>
+#include <triple_pattern.hpp>
+#include <util/file_util.hpp>
+#include <utility>
+
+using namespace std;
+
+template <class index_scheme_type, class trait_type>
+void query(
+    const std::string &file,
+    const std::string &queries,
+    const uint64_t limit,
+    const uint64_t timeout
+) {
+  vector<string> dummy_queries;
+  bool result = ::util::file::get_file_content(queries, dummy_queries);
+
+  index_scheme_type graph;
+  sdsl::load_from_file(graph, file);
+
+  std::cout << "Index loaded: " << sdsl::size_in_bytes(graph) << " bytes."
+            << std::endl;
+
+  uint64_t nQ = 0;
+  if (result) {
+    for (string &query_string : dummy_queries) {
+      std::vector<ltj::triple_pattern> query =
+          ::util::rdf::ids::get_query(query_string);
+
+      typedef ltj::ltj_iterator_lite<index_scheme_type, uint8_t, uint64_t>
+          iterator_type;
+#if ADAPTIVE
+      typedef ltj::veo::veo_adaptive<iterator_type, trait_type> veo_type;
+#else
+      typedef ltj::veo::veo_simple<iterator_type, trait_type> veo_type;
+#endif
+      typedef ltj::ltj_algorithm<iterator_type, veo_type> algorithm_type;
+      typedef ltj::ltj_hybrid<iterator_type, veo_type> hybrid_type;
+      typedef ::util::results_collector<typename algorithm_type::tuple_type>
+          results_type;
+
+      results_type res_ltj;
+      auto start = std::chrono::high_resolution_clock::now();
+      algorithm_type ltj(&query, &graph);
+      ltj.join(res_ltj, limit, timeout);
+      auto stop = std::chrono::high_resolution_clock::now();
+      auto time_ltj =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start)
+              .count();
+
+      results_type res_hybrid;
+      start = std::chrono::high_resolution_clock::now();
+      hybrid_type hybrid(&query, &graph);
+      hybrid.join(res_hybrid, limit, timeout);
+      stop = std::chrono::high_resolution_clock::now();
+      auto time_hybrid =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start)
+              .count();
+
+      uint64_t n_hash = 0;
+      for (uint64_t k = 0; k < hybrid.stages(); ++k) {
+        n_hash += hybrid.is_hash_join(k);
+      }
+      cout << nQ << ";" << res_ltj.size() << ";" << time_ltj << ";"
+           << res_hybrid.size() << ";" << time_hybrid << ";"
+           << hybrid.core().size() << ";" << n_hash << ";"
+           << hybrid.stages() - n_hash << endl;
+      nQ++;
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 5) {
+    std::cout << "Usage: " << argv[0]
+              << " <index> <queries> <limit> <type> [timeout]" << std::endl;
+    return 0;
+  }
+
+  std::string index = argv[1];
+  std::string queries = argv[2];
+  uint64_t limit = std::atoll(argv[3]);
+  std::string type = argv[4];
+  uint64_t timeout = 600; // in seconds
+  if (argc > 5) {
+    timeout = std::atoll(argv[5]);
+  }
+
+  if (type == "normal") {
+    query<cltj::compact_ltj, ltj::util::trait_distinct>(
+        index, queries, limit, timeout
+    );
+  } else if (type == "star") {
+    query<cltj::compact_ltj, ltj::util::trait_size>(
+        index, queries, limit, timeout
+    );
+  } else {
+    std::cout << "Type of index: " << type << " is not supported." << std::endl;
+  }
+
+  return 0;
+}
@@ -24,6 +24,7 @@
 #include <query/ltj_algorithm.hpp>
 #include <triple_pattern.hpp>
 #include <util/file_util.hpp>
+#include <util/perf_counters.hpp>
 #include <util/time_util.hpp>
 #include <utility>
 
@@ -64,6 +65,18 @@ void print_intersection_stats(
   cout << "=============================================" << endl;
 }
 
+// The indexes are built as compact_ltj, other layouts are converted on load
+inline void load_index(cltj::compact_ltj &graph, const std::string &file) {
+  sdsl::load_from_file(graph, file);
+}
+
+template <class index_scheme_type>
+void load_index(index_scheme_type &graph, const std::string &file) {
+  cltj::compact_ltj compact;
+  sdsl::load_from_file(compact, file);
+  graph = index_scheme_type(compact);
+}
+
 template <class index_scheme_type, class trait_type>
 void query(
     const std::string &file,
@@ -75,7 +88,7 @@ void query(
   bool result = ::util::file::get_file_content(queries, dummy_queries);
 
   index_scheme_type graph;
-  sdsl::load_from_file(graph, file);
+  load_index(graph, file);
 
   std::cout << "Index loaded: " << sdsl::size_in_bytes(graph) << " bytes."
             << std::endl;
@@ -87,6 +100,15 @@ void query(
   uint64_t total_elapsed_time;
   uint64_t total_user_time;
 
+#if PERF_COUNTERS
+  ::util::perf::counters perf;
+  std::cout << "Columns: query;results;ns";
+  for (size_t i = 0; i < perf.size(); ++i) {
+    std::cout << ";" << perf.name(i) << (perf.available(i) ? "" : "(n/a)");
+  }
+  std::cout << std::endl;
+#endif
+
   if (result) {
     int count = 1;
     for (string &query_string : dummy_queries) {
@@ -95,35 +117,58 @@ void query(
 
       typedef ltj::ltj_iterator_lite<index_scheme_type, uint8_t, uint64_t>
           iterator_type;
+#if STATS
+      typedef ltj::stats::stats_full stats_type;
+#else
+      typedef ltj::stats::stats_none stats_type;
+#endif
 #if ADAPTIVE
       typedef ltj::ltj_algorithm<
-          iterator_type, ltj::veo::veo_adaptive<iterator_type, trait_type>>
+          iterator_type, ltj::veo::veo_adaptive<iterator_type, trait_type>,
+          stats_type>
           algorithm_type;
 
 #else
       typedef ltj::ltj_algorithm<
-          iterator_type, ltj::veo::veo_simple<iterator_type, trait_type>>
+          iterator_type, ltj::veo::veo_simple<iterator_type, trait_type>,
+          stats_type>
           algorithm_type;
 #endif
       typedef ::util::results_collector<typename algorithm_type::tuple_type>
           results_type;
       results_type res;
 
+#if PERF_COUNTERS
+      perf.start();
+#endif
       auto start = std::chrono::high_resolution_clock::now();
       algorithm_type ltj(&query, &graph);
       ltj.join(res, limit, timeout);
       auto stop = std::chrono::high_resolution_clock::now();
+#if PERF_COUNTERS
+      perf.stop();
+#endif
 
       auto time =
           std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start)
               .count();
+#if PERF_COUNTERS
+      cout << nQ << ";" << res.size() << ";" << time;
+      for (size_t i = 0; i < perf.size(); ++i) {
+        cout << ";" << perf.value(i);
+      }
+      cout << endl;
+#else
       cout << nQ << ";" << res.size() << ";" << time << endl;
+#endif
 
+#if STATS
       std::vector<std::string> header = {"query_text",
                                          "var_appearance_order",
                                          "veo_step",
                                          "intersection_size",
                                          "alternation_complexity",
+                                         "leapfrog_seeks",
                                          "intersected_list_sizes"};
       util::CSVWriter csv_writer("intersection_statistics.csv", header, 10000);
 
@@ -149,6 +194,7 @@ void query(
             std::to_string(stat.depth),
             std::to_string(stat.result_size),
             std::to_string(stat.alternation_complexity),
+            std::to_string(stat.leapfrog_seeks),
             list_sizes_str
         };
 
@@ -161,6 +207,7 @@ void query(
         csv_writer.flush();
         std::cout << "Total rows written: " << total_rows_written << std::endl;
       }
+#endif
 
       nQ++;
 
@@ -186,14 +233,20 @@ int main(int argc, char *argv[]) {
     timeout = std::atoll(argv[5]);
   }
 
+#if INTERLEAVED
+  typedef cltj::compact_ltj_interleaved index_type;
+#elif RANK_SELECT
+  typedef cltj::compact_ltj_rs index_type;
+#else
+  typedef cltj::compact_ltj index_type;
+#endif
+
   if (type == "normal") {
-    query<cltj::compact_ltj, ltj::util::trait_distinct>(
+    query<index_type, ltj::util::trait_distinct>(
         index, queries, limit, timeout
     );
   } else if (type == "star") {
-    query<cltj::compact_ltj, ltj::util::trait_size>(
-        index, queries, limit, timeout
-    );
+    query<index_type, ltj::util::trait_size>(index, queries, limit, timeout);
   } else {
     std::cout << "Type of index: " << type << " is not supported." << std::endl;
   }
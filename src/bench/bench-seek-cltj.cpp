@@ -0,0 +1,152 @@
+/*
+ * bench-seek-cltj.cpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <index/cltj_index_spo_lite.hpp>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// Seeks as done by leap: increasing targets inside the children of a node,
+// each one starting from the position returned by the previous seek.
+typedef struct {
+  uint64_t beg;
+  uint64_t end;
+  std::vector<uint32_t> targets;
+} walk_type;
+
+template <class trie_type>
+std::vector<walk_type> build_walks(
+    const trie_type *trie,
+    const uint64_t min_children,
+    const uint64_t max_gap,
+    std::mt19937_64 &gen
+) {
+  std::vector<walk_type> walks;
+  const uint64_t n = trie->seq.size();
+  for (uint64_t k = 0; k < n; ++k) {
+    if (trie->bv[k] != 0)
+      continue; // Not the first child of a node
+    const uint64_t cnt = trie->children(k);
+    if (cnt < min_children)
+      continue;
+    walk_type walk;
+    walk.beg = trie->first_child(k);
+    walk.end = walk.beg + cnt - 1;
+    uint64_t pos = walk.beg;
+    while (true) {
+      pos += 1 + gen() % max_gap;
+      if (pos > walk.end)
+        break;
+      walk.targets.push_back(trie->seq[pos]);
+    }
+    walks.push_back(std::move(walk));
+  }
+  return walks;
+}
+
+template <class trie_type, class seek_type>
+uint64_t run_walks(
+    const trie_type *trie,
+    const std::vector<walk_type> &walks,
+    seek_type seek,
+    uint64_t &checksum
+) {
+  auto start = std::chrono::high_resolution_clock::now();
+  for (const auto &walk : walks) {
+    uint64_t beg = walk.beg;
+    for (const auto &c : walk.targets) {
+      const auto p = seek(trie, c, beg, walk.end);
+      checksum += p.first;
+      beg = p.second;
+    }
+  }
+  auto stop = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start)
+      .count();
+}
+
+template <class index_scheme_type>
+void bench(
+    const std::string &file,
+    const uint64_t min_children,
+    const uint64_t max_gap
+) {
+  typedef typename index_scheme_type::trie_type trie_type;
+  index_scheme_type graph;
+  sdsl::load_from_file(graph, file);
+
+  std::cout << "Index loaded: " << sdsl::size_in_bytes(graph) << " bytes."
+            << std::endl;
+
+  std::mt19937_64 gen(42);
+  cout << "trie;nodes;seeks;binary_ns;gallop_ns" << endl;
+  for (uint64_t t = 0; t < 6; ++t) {
+    const trie_type *trie = graph.get_trie(t);
+    auto walks = build_walks(trie, min_children, max_gap, gen);
+    uint64_t seeks = 0;
+    for (const auto &walk : walks) {
+      seeks += walk.targets.size();
+    }
+    uint64_t sum_binary = 0, sum_gallop = 0;
+    auto time_binary = run_walks(
+        trie, walks,
+        [](const trie_type *tr, uint32_t c, uint64_t b, uint64_t e) {
+          return tr->binary_search_seek(c, b, e);
+        },
+        sum_binary
+    );
+    auto time_gallop = run_walks(
+        trie, walks,
+        [](const trie_type *tr, uint32_t c, uint64_t b, uint64_t e) {
+          return tr->gallop_seek(c, b, e);
+        },
+        sum_gallop
+    );
+    if (sum_binary != sum_gallop) {
+      cout << "Error: different results in trie " << t << endl;
+    }
+    cout << t << ";" << walks.size() << ";" << seeks << ";" << time_binary
+         << ";" << time_gallop << endl;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cout << "Usage: " << argv[0] << " <index> [min_children] [max_gap]"
+              << std::endl;
+    return 0;
+  }
+
+  std::string index = argv[1];
+  uint64_t min_children = 64;
+  uint64_t max_gap = 8;
+  if (argc > 2) {
+    min_children = std::atoll(argv[2]);
+  }
+  if (argc > 3) {
+    max_gap = std::atoll(argv[3]);
+  }
+
+  bench<cltj::compact_ltj>(index, min_children, max_gap);
+
+  return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * bench-select-cltj.cpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cds/rank_select_support.hpp>
+#include <cds/succ_support_v.hpp>
+#include <chrono>
+#include <index/cltj_index_spo_lite.hpp>
+#include <iostream>
+#include <random>
+#include <sdsl/select_support_mcl.hpp>
+#include <trie/cltj_compact_trie.hpp>
+#include <vector>
+
+using namespace std;
+
+// Runs op on every query and returns the elapsed time in nanoseconds
+template <class op_type>
+uint64_t run_queries(
+    const std::vector<uint64_t> &queries,
+    op_type op,
+    uint64_t &checksum
+) {
+  auto start = std::chrono::high_resolution_clock::now();
+  for (const auto &q : queries) {
+    checksum += op(q);
+  }
+  auto stop = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start)
+      .count();
+}
+
+/*
+    Compares select0 and succ0 of the bitvector of each trie:
+    select_support_mcl<0> and succ_support_v<0> (what compact_trie uses)
+    against rank_select_support<0>. The select queries are random ranks, as
+    in child(), and the succ queries start after a random zero, as in
+    children(). Then child() and children() together on the compact_trie
+    and on a compact_trie_rs (the trie with rank_select_support) built from
+    it.
+*/
+void bench(const std::string &file, const uint64_t n_queries) {
+  cltj::compact_ltj graph;
+  sdsl::load_from_file(graph, file);
+
+  std::cout << "Index loaded: " << sdsl::size_in_bytes(graph) << " bytes."
+            << std::endl;
+
+  std::mt19937_64 gen(42);
+  cout << "trie;bits;zeros;mcl_select_ns;rs_select_ns;succ_v_succ_ns;"
+          "rs_succ_ns;mcl_bytes;succ_v_bytes;rs_bytes;trie_ns;trie_rs_ns"
+       << endl;
+  for (uint64_t t = 0; t < 6; ++t) {
+    const cltj::compact_trie &trie = *graph.get_trie(t);
+    const sdsl::bit_vector &bv = trie.bv;
+    sdsl::select_support_mcl<0> mcl;
+    cds::succ_support_v<0> succ_v;
+    sdsl::util::init_support(mcl, &bv);
+    sdsl::util::init_support(succ_v, &bv);
+    cds::rank_select_support<0> rs(&bv);
+
+    const uint64_t zeros = rs.count();
+    std::vector<uint64_t> ranks(n_queries), positions(n_queries);
+    for (uint64_t i = 0; i < n_queries; ++i) {
+      ranks[i] = 1 + gen() % zeros;
+      positions[i] = mcl(1 + gen() % zeros) + 1;
+    }
+
+    uint64_t sum_mcl = 0, sum_rs = 0, sum_succ_v = 0, sum_rs_succ = 0;
+    auto time_mcl = run_queries(
+        ranks, [&mcl](uint64_t k) { return mcl(k); }, sum_mcl
+    );
+    auto time_rs = run_queries(
+        ranks, [&rs](uint64_t k) { return rs.select(k); }, sum_rs
+    );
+    auto time_succ_v = run_queries(
+        positions, [&succ_v](uint64_t i) { return succ_v(i); }, sum_succ_v
+    );
+    auto time_rs_succ = run_queries(
+        positions, [&rs](uint64_t i) { return rs.succ(i); }, sum_rs_succ
+    );
+
+    // child() of a random run and children() of the node reached, as in
+    // the down() of the iterators
+    cltj::compact_trie_rs trie_rs(trie);
+    uint64_t sum_trie = 0, sum_trie_rs = 0;
+    auto time_trie = run_queries(
+        ranks,
+        [&trie](uint64_t k) {
+          return trie.children(trie.child(0, 1, k - 1));
+        },
+        sum_trie
+    );
+    auto time_trie_rs = run_queries(
+        ranks,
+        [&trie_rs](uint64_t k) {
+          return trie_rs.children(trie_rs.child(0, 1, k - 1));
+        },
+        sum_trie_rs
+    );
+    if (sum_mcl != sum_rs || sum_succ_v != sum_rs_succ ||
+        sum_trie != sum_trie_rs) {
+      cout << "Error: different results in trie " << t << endl;
+    }
+    cout << t << ";" << bv.size() << ";" << zeros << ";"
+         << time_mcl / n_queries << ";" << time_rs / n_queries << ";"
+         << time_succ_v / n_queries << ";" << time_rs_succ / n_queries << ";"
+         << sdsl::size_in_bytes(mcl) << ";" << sdsl::size_in_bytes(succ_v)
+         << ";" << sdsl::size_in_bytes(rs) << ";" << time_trie / n_queries
+         << ";" << time_trie_rs / n_queries << endl;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cout << "Usage: " << argv[0] << " <index> [queries]" << std::endl;
+    return 0;
+  }
+
+  std::string index = argv[1];
+  uint64_t n_queries = 1000000;
+  if (argc > 2) {
+    n_queries = std::atoll(argv[2]);
+  }
+
+  bench(index, n_queries);
+
+  return 0;
+}
@@ -23,6 +23,8 @@ if [ $RUN_STATIC -eq 1 ]; then
    $BIN_FOLDER/bench-query-cltj $DATASET.cltj $QUERIES 1000 normal > $OUTPUT_FOLDER/cltj-normal-1000.txt
    $BIN_FOLDER/bench-query-cltj-global $DATASET.cltj $QUERIES 1000 star > $OUTPUT_FOLDER/cltj-global-star-1000.txt
    $BIN_FOLDER/bench-query-cltj-global $DATASET.cltj $QUERIES 1000 normal > $OUTPUT_FOLDER/cltj-global-normal-1000.txt
+   $BIN_FOLDER/bench-query-cltj-perf $DATASET.cltj $QUERIES 1000 star > $OUTPUT_FOLDER/cltj-perf-star-1000.txt
+   $BIN_FOLDER/bench-query-cltj-interleaved $DATASET.cltj $QUERIES 1000 star > $OUTPUT_FOLDER/cltj-interleaved-star-1000.txt
    echo "1.2 Running xCLTJ..."
    $BIN_FOLDER/bench-query-xcltj $DATASET.xcltj $QUERIES 1000 star > $OUTPUT_FOLDER/xcltj-star-1000.txt
    $BIN_FOLDER/bench-query-xcltj $DATASET.xcltj $QUERIES 1000 normal > $OUTPUT_FOLDER/xcltj-normal-1000.txt
@@ -1,16 +1,23 @@
 // Benchmark MPHF hashing strategies: build time, query time (h(k)), space.
 // Results are written to a CSV file via util::CSVWriter.
+// With --index, it reports the space and lookup time of the child index
+// (hashing::ChildIndex) of each trie of a compact index instead.
 
+#include <hashing/child_index.hpp>
 #include <hashing/mphf_bdz.hpp>
 #include <hashing/storage/baseline.hpp>
 #include <hashing/storage/packed_trit.hpp>
 #include <hashing/storage/glgh.hpp>
 #include <hashing/storage/b_strategy.hpp>
 
+#include <index/cltj_index_spo_lite.hpp>
+
 #include <CLI11.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <fstream>
 #include <iostream>
 #include <random>
 #include <string>
@@ -20,6 +27,7 @@
 #include <pthash.hpp>
 
 using cltj::hashing::BaselineStorage;
+using cltj::hashing::ChildIndex;
 using cltj::hashing::CompressedBitvector;
 using cltj::hashing::ExplicitBitvector;
 using cltj::hashing::GlGhStorage;
@@ -64,6 +72,12 @@ struct BenchConfig {
     };
 };
 
+struct TrieBenchConfig {
+    std::string index_path;  // Compact index (.cltj); empty to skip
+    std::vector<uint32_t> min_degrees = {16, 64, 256, 1024};
+    size_t max_lookups = 1000000;
+};
+
 struct BenchResult {
     std::string strategy;
     size_t n = 0;
@@ -266,10 +280,93 @@ int run_bench(const BenchConfig& cfg) {
     return 0;
 }
 
+// Exact child lookups (symbol, first child, last child) in the indexed nodes
+struct ChildLookup {
+    uint64_t symbol;
+    uint64_t beg;
+    uint64_t end;
+};
+
+// Space and time of the child index of each trie of a compact index, for
+// several degree thresholds, against the binary search of the trie.
+int run_trie_bench(const TrieBenchConfig& cfg, const std::string& csv_path) {
+    cltj::compact_ltj index;
+    sdsl::load_from_file(index, cfg.index_path);
+
+    std::ofstream out(csv_path);
+    out << "trie,min_degree,nodes,keys,build_time_us,hash_ns_per_lookup,"
+           "search_ns_per_lookup,hash_bytes,trie_bytes,bits_per_key,overhead\n";
+
+    std::mt19937_64 rng(42);
+    for (size_t k = 0; k < 6; ++k) {
+        const cltj::compact_trie* trie = index.get_trie(k);
+        const size_t trie_bytes = sdsl::size_in_bytes(*trie);
+        for (uint32_t min_degree : cfg.min_degrees) {
+            std::cout << "=== Trie " << k << ", min degree " << min_degree << " ===" << std::endl;
+            ChildIndex<> children;
+            auto start_build = std::chrono::high_resolution_clock::now();
+            const bool ok = children.build(trie->bv, trie->seq, min_degree);
+            auto end_build = std::chrono::high_resolution_clock::now();
+            if (!ok) {
+                std::cout << "Build failed" << std::endl;
+                continue;
+            }
+            const long long build_time_us =
+                std::chrono::duration_cast<std::chrono::microseconds>(end_build - start_build).count();
+
+            std::vector<ChildLookup> lookups;
+            uint64_t beg = 0;
+            for (uint64_t z = 1; z < trie->bv.size(); ++z) {
+                if (trie->bv[z])
+                    continue;
+                if (children.covers(z - beg)) {
+                    for (uint64_t p = beg; p < z; ++p) {
+                        lookups.push_back({trie->seq[p], beg, z - 1});
+                    }
+                }
+                beg = z;
+            }
+            std::shuffle(lookups.begin(), lookups.end(), rng);
+            if (lookups.size() > cfg.max_lookups) {
+                lookups.resize(cfg.max_lookups);
+            }
+
+            volatile uint64_t sink = 0;
+            auto start_hash = std::chrono::high_resolution_clock::now();
+            for (const auto& l : lookups) {
+                sink ^= children.find(trie->seq, l.symbol, l.beg, l.end);
+            }
+            auto end_hash = std::chrono::high_resolution_clock::now();
+            auto start_search = std::chrono::high_resolution_clock::now();
+            for (const auto& l : lookups) {
+                sink ^= trie->binary_search_seek(l.symbol, l.beg, l.end).second;
+            }
+            auto end_search = std::chrono::high_resolution_clock::now();
+            (void)sink;
+
+            const double n_lookups = static_cast<double>(std::max<size_t>(1, lookups.size()));
+            const double hash_ns =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end_hash - start_hash).count() / n_lookups;
+            const double search_ns =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end_search - start_search).count() /
+                n_lookups;
+            const size_t hash_bytes = children.size_in_bytes();
+            const double bits_per_key =
+                children.keys() ? (hash_bytes * 8.0) / static_cast<double>(children.keys()) : 0.0;
+            out << k << "," << min_degree << "," << children.nodes() << "," << children.keys() << ","
+                << build_time_us << "," << hash_ns << "," << search_ns << "," << hash_bytes << ","
+                << trie_bytes << "," << bits_per_key << ","
+                << static_cast<double>(hash_bytes) / static_cast<double>(trie_bytes) << "\n";
+        }
+    }
+    return 0;
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
     BenchConfig cfg;
+    TrieBenchConfig trie_cfg;
 
     CLI::App app{"Benchmark MPHF hashing strategies (build, query, space) with CSV output"};
     app.add_option("--output", cfg.csv_path, "Output CSV path")->capture_default_str();
@@ -287,7 +384,16 @@ int main(int argc, char** argv) {
     )
         ->capture_default_str();
 
+    app.add_option("--index", trie_cfg.index_path, "Compact index (.cltj) to benchmark the child index of its tries");
+    app.add_option("--min-degrees", trie_cfg.min_degrees, "Degree thresholds of the child index (with --index)")
+        ->capture_default_str();
+    app.add_option("--max-lookups", trie_cfg.max_lookups, "Maximum number of child lookups per trie (with --index)")
+        ->capture_default_str();
+
     CLI11_PARSE(app, argc, argv);
 
+    if (!trie_cfg.index_path.empty()) {
+        return run_trie_bench(trie_cfg, cfg.csv_path);
+    }
     return run_bench(cfg);
 }
@@ -0,0 +1,185 @@
+// Test suite for ChildIndex and compact_trie_hashed
+#include <hashing/child_index.hpp>
+#include <index/cltj_index_spo_lite.hpp>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <vector>
+
+using cltj::hashing::ChildIndex;
+
+/**
+ * Random triples, plus a subject with many objects so that some nodes of
+ * every trie have a high degree
+ */
+static std::vector<cltj::spo_triple> generate_triples(uint64_t seed) {
+    std::mt19937 rng(seed);
+    std::set<cltj::spo_triple> triples;
+    while (triples.size() < 5000) {
+        triples.insert({(uint32_t)(rng() % 100 + 1), (uint32_t)(rng() % 4 + 1), (uint32_t)(rng() % 300 + 1)});
+    }
+    for (uint32_t o = 1; o <= 1000; o += 2) {
+        triples.insert({7, 2, o});
+    }
+    return std::vector<cltj::spo_triple>(triples.begin(), triples.end());
+}
+
+/**
+ * Test: every child of an indexed node is found at its position, and
+ * symbols that are not children are not found
+ */
+void test_find(const cltj::compact_trie& trie, uint32_t min_degree) {
+    ChildIndex<> children;
+    const bool ok = children.build(trie.bv, trie.seq, min_degree);
+    assert(ok && "Build should succeed");
+    uint64_t beg = 0, nodes = 0;
+    for (uint64_t z = 1; z < trie.bv.size(); ++z) {
+        if (trie.bv[z])
+            continue;
+        const uint64_t end = z - 1;
+        if (z - beg >= min_degree) {
+            ++nodes;
+            assert(children.covers(z - beg) && "Node should be covered");
+            for (uint64_t p = beg; p <= end; ++p) {
+                assert(children.find(trie.seq, trie.seq[p], beg, end) == p && "Child should be found");
+                // Before the start of the range
+                if (p > beg) {
+                    assert(children.find(trie.seq, trie.seq[beg], p, end) == ChildIndex<>::NOT_FOUND);
+                }
+            }
+            assert(children.find(trie.seq, trie.seq[end] + 1, beg, end) == ChildIndex<>::NOT_FOUND);
+        }
+        beg = z;
+    }
+    assert(children.nodes() == nodes && "Number of indexed nodes");
+}
+
+void test_find_all_tries() {
+    std::cout << "Testing find on every trie... ";
+    auto triples = generate_triples(42);
+    cltj::compact_ltj index(triples);
+    for (uint32_t min_degree : {1u, 8u, 64u, 256u}) {
+        for (size_t k = 0; k < 6; ++k) {
+            test_find(*index.get_trie(k), min_degree);
+        }
+    }
+    std::cout << "PASSED\n";
+}
+
+/**
+ * Test: symbols above 2^32. The node ending at 2 has the symbol 2^32 + 9
+ * and the one ending at 3 has 9, which were the same key when the position
+ * was shifted 32 bits and OR-ed with the symbol. Then nodes with random
+ * 64-bit symbols.
+ */
+void test_wide_symbols() {
+    std::cout << "Testing find with 64-bit symbols... ";
+    std::mt19937_64 rng(11);
+    std::vector<uint64_t> seq = {5, 7, (1ULL << 32) + 9, 9};
+    std::vector<uint64_t> lengths = {3, 1};
+    for (int k = 0; k < 200; ++k) {
+        std::set<uint64_t> syms;
+        const uint64_t len = 1 + rng() % 20;
+        while (syms.size() < len) {
+            syms.insert(rng());
+        }
+        seq.insert(seq.end(), syms.begin(), syms.end());
+        lengths.push_back(len);
+    }
+    sdsl::bit_vector bv(seq.size() + 1, 1);
+    bv[0] = 0;
+    uint64_t beg = 0;
+    for (uint64_t len : lengths) {
+        beg += len;
+        bv[beg] = 0;
+    }
+
+    ChildIndex<> children;
+    const bool ok = children.build(bv, seq, 1);
+    assert(ok && "Build should succeed");
+    assert(children.nodes() == lengths.size() && "Number of indexed nodes");
+    beg = 0;
+    for (uint64_t len : lengths) {
+        const uint64_t end = beg + len - 1;
+        for (uint64_t p = beg; p <= end; ++p) {
+            assert(children.find(seq, seq[p], beg, end) == p && "Child should be found");
+            assert(children.find(seq, seq[p] ^ (1ULL << 32), beg, end) == ChildIndex<>::NOT_FOUND);
+        }
+        beg = end + 1;
+    }
+    std::cout << "PASSED\n";
+}
+
+/**
+ * Test: the seeks of compact_trie_hashed return the same as the ones of
+ * compact_trie, for children and for symbols in between
+ */
+void test_hashed_trie_seeks() {
+    std::cout << "Testing seeks of compact_trie_hashed... ";
+    auto triples = generate_triples(7);
+    cltj::compact_ltj index(triples);
+    for (size_t k = 0; k < 6; ++k) {
+        const cltj::compact_trie& trie = *index.get_trie(k);
+        cltj::compact_trie_hashed hashed(cltj::compact_trie(trie), 8);
+        uint64_t beg = 0;
+        for (uint64_t z = 1; z < trie.bv.size(); ++z) {
+            if (trie.bv[z])
+                continue;
+            for (uint64_t p = beg; p < z; ++p) {
+                for (uint32_t val : {(uint32_t)trie.seq[p], (uint32_t)trie.seq[p] + 1}) {
+                    assert(hashed.binary_search_seek(val, beg, z - 1) == trie.binary_search_seek(val, beg, z - 1));
+                    assert(hashed.gallop_seek(val, p, z - 1) == trie.gallop_seek(val, p, z - 1));
+                }
+            }
+            beg = z;
+        }
+    }
+    std::cout << "PASSED\n";
+}
+
+/**
+ * Test: serialization and loading
+ */
+void test_serialization() {
+    std::cout << "Testing serialization... ";
+    auto triples = generate_triples(3);
+    cltj::compact_ltj index(triples);
+    const cltj::compact_trie& trie = *index.get_trie(0);
+    cltj::compact_trie_hashed hashed(cltj::compact_trie(trie), 8);
+
+    std::stringstream ss;
+    hashed.serialize(ss);
+    cltj::compact_trie_hashed loaded;
+    loaded.load(ss);
+    assert(loaded.children_index().nodes() == hashed.children_index().nodes());
+    assert(loaded.children_index().keys() == hashed.children_index().keys());
+    uint64_t beg = 0;
+    for (uint64_t z = 1; z < trie.bv.size(); ++z) {
+        if (trie.bv[z])
+            continue;
+        for (uint64_t p = beg; p < z; ++p) {
+            assert(loaded.binary_search_seek(trie.seq[p], beg, z - 1) == trie.binary_search_seek(trie.seq[p], beg, z - 1));
+        }
+        beg = z;
+    }
+    std::cout << "PASSED\n";
+}
+
+int main() {
+    std::cout << "=== ChildIndex Tests ===\n\n";
+
+    try {
+        test_find_all_tries();
+        test_wide_symbols();
+        test_hashed_trie_seeks();
+        test_serialization();
+
+        std::cout << "\n✅ All tests passed!\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n❌ Test failed: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -167,7 +167,8 @@ void test_transformation_only() {
       ltj::ltj_iterator_lite<cltj::compact_dyn_ltj, uint8_t, uint64_t>,
       ltj::veo::veo_simple<
           ltj::ltj_iterator_lite<cltj::compact_dyn_ltj, uint8_t, uint64_t>,
-          ltj::util::trait_size>>
+          ltj::util::trait_size>,
+      ltj::stats::stats_full>
       algorithm_type;
 
   algorithm_type ltj(&setup.patterns, &setup.index);
@@ -249,7 +250,8 @@ void test_case(
       ltj::ltj_iterator_lite<cltj::compact_dyn_ltj, uint8_t, uint64_t>,
       ltj::veo::veo_simple<
           ltj::ltj_iterator_lite<cltj::compact_dyn_ltj, uint8_t, uint64_t>,
-          ltj::util::trait_size>>
+          ltj::util::trait_size>,
+      ltj::stats::stats_full>
       algorithm_type;
 
   algorithm_type ltj(&setup.patterns, &setup.index);
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cds/partitioned_ef.hpp>
+#include <random>
+#include <trie/cltj_compact_trie.hpp>
+#include <trie/cltj_compact_trie_ef.hpp>
+
+#include "test_util.hpp"
+
+using namespace std;
+
+/*
+    Checks operator[] and next_geq of partitioned_ef against a plain vector.
+    Constant and dense sequences have blocks of width 0, and the jumps of
+    the sparse ones leave empty buckets inside the blocks. Some of the
+    ranges end before the value, so the seek misses and must return
+    (0, f + 1).
+*/
+template <uint32_t t_block>
+uint64_t check_partitioned_ef(std::mt19937_64 &gen, const uint64_t tests) {
+  uint64_t errors = 0;
+  for (uint64_t t = 0; t < tests; ++t) {
+    const uint64_t n = 1 + gen() % (8 * t_block);
+    vector<uint64_t> v(n);
+    uint64_t x = gen() % 50;
+    for (auto &e : v) {
+      switch (t % 4) {
+      case 0: // Width 0
+        break;
+      case 1: // Dense
+        x += gen() % 3;
+        break;
+      case 2: // Sparse
+        x += gen() % 1000;
+        break;
+      default: // Empty buckets
+        x += (gen() % 10 == 0) ? gen() % (1ULL << 40) : gen() % 2;
+      }
+      e = x;
+    }
+    cds::partitioned_ef<t_block> ef(v);
+    if (ef.size() != n)
+      ++errors;
+    for (uint64_t i = 0; i < n; ++i) {
+      if (ef[i] != v[i])
+        ++errors;
+    }
+    for (uint64_t q = 0; q < 500; ++q) {
+      const uint64_t i = gen() % n, f = i + gen() % (n - i);
+      // Around a value of the sequence, or past the end of the range
+      const uint64_t w = v[gen() % n];
+      const uint64_t val = (q % 8 == 0) ? v[f] + 1 : w - (w > 0) + gen() % 3;
+      const auto r = ef.next_geq(val, i, f);
+      const uint64_t p =
+          lower_bound(v.begin() + i, v.begin() + f + 1, val) - v.begin();
+      if (r.second != p)
+        ++errors;
+      if (p <= f && r.first != v[p])
+        ++errors;
+      if (p > f && r.first != 0)
+        ++errors;
+    }
+  }
+  return errors;
+}
+
+/*
+    Builds a compact_trie and a compact_trie_ef from the same symbols and
+    checks seq, child, nodeselect, children and the seeks of every run. The
+    long runs cross the blocks of 128 elements of the Elias-Fano sequence,
+    and the runs of consecutive symbols give blocks of width 0.
+*/
+uint64_t check_compact_trie_ef(std::mt19937_64 &gen, const uint64_t runs) {
+  vector<uint32_t> syms;
+  vector<uint64_t> lengths;
+  for (uint64_t k = 0; k < runs; ++k) {
+    const uint64_t len = (k % 7 == 0) ? 100 + gen() % 400 : 1 + gen() % 20;
+    uint32_t sym = gen() % 10;
+    for (uint64_t j = 0; j < len; ++j) {
+      switch (k % 3) {
+      case 0: // Consecutive
+        sym += 1;
+        break;
+      case 1:
+        sym += 1 + gen() % 100;
+        break;
+      default: // Large gaps
+        sym += 1 + ((gen() % 5 == 0) ? gen() % 1000000 : gen() % 4);
+      }
+      syms.push_back(sym);
+    }
+    lengths.push_back(len);
+  }
+  cltj::compact_trie trie(syms, lengths);
+  cltj::compact_trie_ef built(syms, lengths);
+
+  // The copies must not share the rank/select directory with the original
+  cltj::compact_trie_ef ef;
+  copy_move_load(built, ef);
+
+  uint64_t errors = 0;
+  if (ef.seq.size() != syms.size())
+    ++errors;
+  for (uint64_t i = 0; i < syms.size(); ++i) {
+    if (ef.seq[i] != trie.seq[i])
+      ++errors;
+  }
+  for (uint64_t it = 0; it + 1 < runs; ++it) {
+    if (ef.child(it, 1) != trie.child(it, 1))
+      ++errors;
+    if (ef.nodeselect(it, 0) != trie.nodeselect(it, 0))
+      ++errors;
+  }
+  uint64_t s = 0;
+  for (const auto &len : lengths) {
+    const uint64_t f = s + len - 1;
+    if (ef.children(s) != trie.children(s) || ef.children(s) != len)
+      ++errors;
+    for (uint64_t p = s; p <= f; ++p) {
+      const uint32_t sym = syms[p];
+      for (const uint32_t val : {sym - 1, sym, sym + 1}) {
+        if (ef.binary_search_seek(val, s, f) !=
+            trie.binary_search_seek(val, s, f))
+          ++errors;
+        if (ef.gallop_seek(val, p, f) != trie.gallop_seek(val, p, f))
+          ++errors;
+      }
+    }
+    // All the symbols of the run are smaller
+    const auto miss = ef.binary_search_seek(syms[f] + 1, s, f);
+    if (miss.first != 0 || miss.second != f + 1)
+      ++errors;
+    s += len;
+  }
+  return errors;
+}
+
+int main() {
+  std::mt19937_64 gen(7);
+  uint64_t errors = 0;
+  errors += check_partitioned_ef<16>(gen, 200);
+  errors += check_partitioned_ef<128>(gen, 100);
+  errors += check_compact_trie_ef(gen, 2000);
+  return report(errors);
+}
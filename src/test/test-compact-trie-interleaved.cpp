@@ -0,0 +1,107 @@
+#include <random>
+#include <trie/cltj_compact_trie.hpp>
+#include <trie/cltj_compact_trie_interleaved.hpp>
+
+#include "test_util.hpp"
+
+using namespace std;
+
+/*
+    Builds a compact_trie and a compact_trie_interleaved from the same
+    symbols and checks bv, seq, child, nodeselect, children and the seeks of
+    the runs. Only one position out of every stride is checked in the long
+    runs.
+*/
+uint64_t check_interleaved(
+    const vector<uint32_t> &syms,
+    const vector<uint64_t> &lengths,
+    const uint64_t stride
+) {
+  cltj::compact_trie trie(syms, lengths);
+  cltj::compact_trie_interleaved built(syms, lengths);
+
+  // Copied, moved and loaded, so the lines must be realigned every time
+  cltj::compact_trie_interleaved il;
+  copy_move_load(built, il);
+
+  uint64_t errors = 0;
+  if (il.seq.size() != syms.size())
+    ++errors;
+  for (uint64_t i = 0; i < syms.size(); i += stride) {
+    if (il.seq[i] != trie.seq[i] || il.bv[i] != trie.bv[i])
+      ++errors;
+  }
+  for (uint64_t it = 0; it + 1 < lengths.size(); it += stride) {
+    if (il.child(it, 1) != trie.child(it, 1))
+      ++errors;
+    if (il.nodeselect(it, 0) != trie.nodeselect(it, 0))
+      ++errors;
+  }
+  uint64_t s = 0;
+  for (const auto &len : lengths) {
+    const uint64_t f = s + len - 1;
+    if (il.children(s) != trie.children(s) || il.children(s) != len)
+      ++errors;
+    for (uint64_t p = s; p <= f; p += (len > 1000) ? stride : 1) {
+      const uint32_t sym = syms[p];
+      for (const uint32_t val : {sym - 1, sym, sym + 1}) {
+        if (il.binary_search_seek(val, s, f) !=
+            trie.binary_search_seek(val, s, f))
+          ++errors;
+        if (il.gallop_seek(val, p, f) != trie.gallop_seek(val, p, f))
+          ++errors;
+      }
+    }
+    if (il.binary_search_seek(syms[f] + 1, s, f) !=
+        trie.binary_search_seek(syms[f] + 1, s, f))
+      ++errors;
+    s += len;
+  }
+  return errors;
+}
+
+/*
+    The width of the symbols fixes the number of positions of each line, so
+    the random runs use small and large symbols, and some of them span
+    several lines.
+*/
+uint64_t check_random(std::mt19937_64 &gen, const uint32_t max_gap) {
+  vector<uint32_t> syms;
+  vector<uint64_t> lengths;
+  for (uint64_t k = 0; k < 3000; ++k) {
+    const uint64_t len = (k % 7 == 0) ? 50 + gen() % 300 : 1 + gen() % 10;
+    uint32_t sym = gen() % 10;
+    for (uint64_t j = 0; j < len; ++j) {
+      sym += 1 + gen() % max_gap;
+      syms.push_back(sym);
+    }
+    lengths.push_back(len);
+  }
+  return check_interleaved(syms, lengths, 1);
+}
+
+/*
+    A run longer than the saturated distance to the next zero, so succ0
+    falls back to select0 inside it.
+*/
+uint64_t check_long_run() {
+  const uint64_t len = cltj::compact_trie_interleaved::dist_cap + 1000;
+  vector<uint32_t> syms;
+  vector<uint64_t> lengths = {3, len, 2};
+  for (const auto &l : lengths) {
+    for (uint64_t j = 0; j < l; ++j) {
+      syms.push_back(2 * j + 1);
+    }
+  }
+  return check_interleaved(syms, lengths, 997);
+}
+
+int main() {
+  std::mt19937_64 gen(7);
+  uint64_t errors = 0;
+  errors += check_random(gen, 1);
+  errors += check_random(gen, 100);
+  errors += check_random(gen, 1000000);
+  errors += check_long_run();
+  return report(errors);
+}
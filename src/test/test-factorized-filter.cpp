@@ -0,0 +1,84 @@
+#include <index/cltj_index_spo_lite.hpp>
+#include <iostream>
+#include <query/ltj_algorithm.hpp>
+#include <set>
+#include <util/rdf_util.hpp>
+
+#include "test_util.hpp"
+
+using namespace std;
+
+typedef ltj::ltj_algorithm<> algorithm_type;
+typedef algorithm_type::tuple_type tuple_type;
+typedef algorithm_type::results_factorized_type results_factorized_type;
+typedef vector<pair<uint8_t, uint64_t>> sorted_tuple_type;
+
+struct results_set {
+  set<sorted_tuple_type> tuples;
+  void add(const tuple_type &t) {
+    sorted_tuple_type s(t.begin(), t.end());
+    sort(s.begin(), s.end());
+    tuples.insert(s);
+  }
+  uint64_t size() const {
+    return tuples.size();
+  }
+};
+
+/*
+    Joins ?x 1 ?y . ?y 2 ?z with a range filter on ?z, where ?x and ?z are
+    lonely variables of the factorized join. The kth value of ?y has the
+    objects 20 + k, ..., 20 + 2k, so the filter clips the range of ?z to
+    empty for some of them. Those bindings of ?y must not be reported, and
+    the unfolded results must be the ones of the plain join.
+*/
+int main() {
+  vector<cltj::spo_triple> D;
+  for (uint32_t k = 1; k <= 10; ++k) {
+    D.push_back({k, 1, 10 + k});
+    D.push_back({k + 1, 1, 10 + k});
+    for (uint32_t z = 20 + k; z <= 20 + 2 * k; ++z) {
+      D.push_back({10 + k, 2, z});
+    }
+  }
+  cltj::compact_ltj index(D);
+  auto query = ::util::rdf::ids::get_query("?x 1 ?y . ?y 2 ?z");
+  const uint8_t z = 2; // Variables are numbered in order of appearance
+
+  uint64_t errors = 0;
+  for (uint64_t lo = 20; lo <= 42; lo += 2) {
+    const ltj::ltj_filter<uint64_t> f(lo, lo + 3);
+
+    results_set expected;
+    algorithm_type join(&query, &index);
+    join.filter(z, f);
+    join.join(expected);
+
+    results_factorized_type res;
+    algorithm_type factorized(&query, &index);
+    factorized.filter(z, f);
+    factorized.join_factorized(res);
+
+    results_set unfolded;
+    set<uint64_t> bindings; // Bindings of ?y with solutions
+    for (const auto &t : expected.tuples) {
+      bindings.insert(t[1].second);
+    }
+    for (uint64_t i = 0; i < res.size(); ++i) {
+      for (const auto &factor : res.factors(i)) {
+        if (factor.second.empty())
+          ++errors;
+      }
+    }
+    res.unfold([&unfolded](const tuple_type &t) { unfolded.add(t); });
+    if (res.size() != bindings.size() || unfolded.tuples != expected.tuples ||
+        res.cardinality() != expected.size()) {
+      cout << "Error: filter [" << lo << ", " << lo + 3 << "]: " << res.size()
+           << " entries, " << res.cardinality() << " tuples, expected "
+           << bindings.size() << " entries, " << expected.size() << " tuples"
+           << endl;
+      ++errors;
+    }
+  }
+  return report(errors);
+}
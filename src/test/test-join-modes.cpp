@@ -0,0 +1,305 @@
+#include <index/cltj_index_spo_lite.hpp>
+#include <iostream>
+#include <map>
+#include <query/ltj_algorithm.hpp>
+#include <query/ltj_hybrid.hpp>
+#include <query/ltj_prepared_query.hpp>
+#include <random>
+#include <set>
+#include <util/lru_cache.hpp>
+#include <util/rdf_util.hpp>
+
+#include "test_util.hpp"
+
+using namespace std;
+
+typedef ltj::ltj_algorithm<> algorithm_type;
+typedef algorithm_type::tuple_type tuple_type;
+typedef vector<pair<uint8_t, uint64_t>> sorted_tuple_type;
+
+struct results_set {
+  set<sorted_tuple_type> tuples;
+  uint64_t n = 0;
+  void add(const tuple_type &t) {
+    sorted_tuple_type s(t.begin(), t.end());
+    sort(s.begin(), s.end());
+    tuples.insert(s);
+    ++n;
+  }
+  uint64_t size() const {
+    return n;
+  }
+};
+
+// Results in the order they are reported
+struct results_list {
+  vector<tuple_type> tuples;
+  void add(const tuple_type &t) {
+    tuples.push_back(t);
+  }
+  uint64_t size() const {
+    return tuples.size();
+  }
+};
+
+/*
+    Solutions of the query by a scan of the triples for each pattern, the
+    reference of every mode (plain join() included).
+*/
+void scan(
+    const vector<cltj::spo_triple> &D,
+    const vector<ltj::triple_pattern> &query,
+    const uint64_t i,
+    map<uint8_t, uint64_t> &bound,
+    results_set &res
+) {
+  if (i == query.size()) {
+    res.add(tuple_type(bound.begin(), bound.end()));
+    return;
+  }
+  const ltj::term_pattern *terms[3] = {
+      &query[i].term_s, &query[i].term_p, &query[i].term_o};
+  for (const auto &t : D) {
+    map<uint8_t, uint64_t> next = bound;
+    bool ok = true;
+    for (uint64_t k = 0; k < 3 && ok; ++k) {
+      if (!terms[k]->is_variable) {
+        ok = t[k] == terms[k]->value;
+      } else {
+        auto it = next.insert({(uint8_t)terms[k]->value, t[k]}).first;
+        ok = it->second == t[k];
+      }
+    }
+    if (ok)
+      scan(D, query, i + 1, next, res);
+  }
+}
+
+template <class Tuple> uint64_t value_of(const Tuple &t, const uint8_t var) {
+  for (const auto &b : t) {
+    if (b.first == var)
+      return b.second;
+  }
+  return 0;
+}
+
+uint64_t compare(
+    const string &mode,
+    const string &q,
+    const results_set &res,
+    const results_set &expected
+) {
+  if (res.tuples == expected.tuples && res.size() == expected.size())
+    return 0;
+  cout << "Error: " << mode << ": " << q << ": " << res.size()
+       << " results, expected " << expected.size() << endl;
+  return 1;
+}
+
+/*
+    Runs every join mode on the query and compares its solutions with the
+    ones of the scan.
+*/
+uint64_t check_modes(
+    const vector<cltj::spo_triple> &D,
+    cltj::compact_ltj &index,
+    const string &q
+) {
+  auto query = ::util::rdf::ids::get_query(q);
+  results_set expected;
+  map<uint8_t, uint64_t> bound;
+  scan(D, query, 0, bound, expected);
+  set<uint8_t> vars;
+  for (const auto &t : expected.tuples) {
+    for (const auto &b : t) {
+      vars.insert(b.first);
+    }
+  }
+
+  uint64_t errors = 0;
+  {
+    algorithm_type join(&query, &index);
+    results_set res;
+    join.join(res);
+    errors += compare("join", q, res, expected);
+    // Prefetch and skewed seeks are part of every search, and a cancelled
+    // search must leave the object ready for the next one
+    ::util::deadline cancelled;
+    cancelled.cancel();
+    results_set none;
+    join.join(none, 0, cancelled);
+    if (none.size() != 0)
+      ++errors;
+    results_set again;
+    join.join(again);
+    errors += compare("deadline", q, again, expected);
+  }
+  {
+    algorithm_type join(&query, &index);
+    results_set res;
+    join.join_parallel(res, 4);
+    errors += compare("parallel", q, res, expected);
+  }
+  {
+    algorithm_type join(&query, &index);
+    if (join.count() != expected.size()) {
+      cout << "Error: count: " << q << endl;
+      ++errors;
+    }
+  }
+  {
+    algorithm_type join(&query, &index);
+    algorithm_type::results_factorized_type factorized;
+    join.join_factorized(factorized);
+    results_set res;
+    factorized.unfold([&res](const tuple_type &t) { res.add(t); });
+    errors += compare("factorized", q, res, expected);
+  }
+  {
+    // The cursor does not split disconnected queries into components, so
+    // it also checks the join of the components
+    algorithm_type join(&query, &index);
+    results_set res;
+    tuple_type t;
+    while (join.next(t)) {
+      res.add(t);
+    }
+    errors += compare("cursor", q, res, expected);
+  }
+  {
+    results_set res;
+    algorithm_type::continuation_type token;
+    bool more = true;
+    while (more) {
+      algorithm_type::continuation_type decoded;
+      if (!decoded.decode(token.encode())) {
+        ++errors;
+        break;
+      }
+      algorithm_type join(&query, &index);
+      more = join.join_page(res, 50, decoded);
+      token = decoded;
+    }
+    errors += compare("pages", q, res, expected);
+  }
+  {
+    algorithm_type join(&query, &index);
+    join.enable_cache(16, 8);
+    results_set res;
+    join.join(res);
+    errors += compare("cache", q, res, expected);
+  }
+  {
+    algorithm_type join(&query, &index);
+    join.semijoin_reduce(1 << 16);
+    results_set res;
+    join.join(res);
+    errors += compare("semijoin", q, res, expected);
+  }
+  {
+    ltj::ltj_hybrid<> hybrid(&query, &index, 40, 7);
+    results_set res;
+    hybrid.join(res);
+    errors += compare("hybrid", q, res, expected);
+  }
+  for (const uint8_t v : vars) {
+    // ORDER BY
+    algorithm_type join(&query, &index);
+    results_list ordered;
+    join.join_ordered(ordered, v, 0);
+    results_set res;
+    for (uint64_t i = 0; i < ordered.size(); ++i) {
+      res.add(ordered.tuples[i]);
+      if (i > 0 && value_of(ordered.tuples[i], v) <
+                       value_of(ordered.tuples[i - 1], v))
+        ++errors;
+    }
+    errors += compare("order", q, res, expected);
+
+    // Projection, on the same object (DISTINCT and bag semantics)
+    results_set distinct;
+    for (const auto &t : expected.tuples) {
+      distinct.add(tuple_type(1, {v, value_of(t, v)}));
+    }
+    distinct.n = distinct.tuples.size();
+    results_set bag = distinct;
+    bag.n = expected.size();
+    results_set res_distinct, res_bag;
+    join.join_projected(res_distinct, vector<uint8_t>(1, v), true);
+    errors += compare("distinct", q, res_distinct, distinct);
+    join.join_projected(res_bag, vector<uint8_t>(1, v), false);
+    errors += compare("projection", q, res_bag, bag);
+  }
+  return errors;
+}
+
+/*
+    A prepared template, with parameters instead of constants, has the
+    solutions of the query with the constants written in it, and the cache
+    of templates evicts the least recently used one.
+*/
+uint64_t check_prepared(cltj::compact_ltj &index) {
+  uint64_t errors = 0;
+  ltj::ltj_prepared_query<uint64_t> prepared(
+      ::util::rdf::ids::get_query_terms("?x $p ?y . ?y $p $o"),
+      [](string &term) { return ::util::rdf::get_constant(term); }
+  );
+  for (uint64_t p = 1; p <= 3; ++p) {
+    for (uint64_t o = 1; o <= 20; ++o) {
+      vector<ltj::triple_pattern> query;
+      prepared.bind(
+          {p, o},
+          [](const uint64_t &c, const state_type, uint64_t &id) {
+            id = c;
+            return true;
+          },
+          query
+      );
+      algorithm_type join(&query, &index, prepared.plan());
+      auto constants = ::util::rdf::ids::get_query(
+          "?x " + to_string(p) + " ?y . ?y " + to_string(p) + " " +
+          to_string(o)
+      );
+      algorithm_type expected(&constants, &index);
+      if (join.count() != expected.count())
+        ++errors;
+    }
+  }
+  ::util::lru_cache<string, uint64_t> cache(2);
+  cache.insert("a", 1);
+  cache.insert("b", 2);
+  cache.find("a");
+  cache.insert("c", 3);
+  if (cache.find("a") == nullptr || cache.find("b") != nullptr ||
+      cache.find("c") == nullptr)
+    ++errors;
+  return errors;
+}
+
+int main() {
+  std::mt19937_64 gen(13);
+  set<cltj::spo_triple> triples;
+  // Dense predicates 1 to 3, and the predicate 4 with 40 times more
+  // subjects, so the seeks on ?x of ?x 1 ?y . ?x 4 ?z are skewed
+  while (triples.size() < 300) {
+    triples.insert(
+        {(uint32_t)(gen() % 20 + 1), (uint32_t)(gen() % 3 + 1),
+         (uint32_t)(gen() % 20 + 1)}
+    );
+  }
+  for (uint32_t s = 1; s <= 800; ++s) {
+    triples.insert({s, 4, (uint32_t)(gen() % 20 + 1)});
+  }
+  vector<cltj::spo_triple> D(triples.begin(), triples.end());
+  cltj::compact_ltj index(D);
+
+  const vector<string> queries = {
+      "?x 1 ?y . ?y 2 ?z", "?x 1 ?y . ?y 2 ?z . ?z 3 ?x",
+      "?x 1 ?a . ?x 2 ?b . ?x 3 ?c", "?x ?p ?y . ?y 1 ?z",
+      "?x 1 ?y . ?a 2 ?b", "?x 1 ?y . ?x 4 ?z"};
+  uint64_t errors = check_prepared(index);
+  for (const auto &q : queries) {
+    errors += check_modes(D, index, q);
+  }
+  return report(errors);
+}
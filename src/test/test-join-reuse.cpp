@@ -0,0 +1,106 @@
+#include <index/cltj_index_spo_lite.hpp>
+#include <iostream>
+#include <query/ltj_algorithm.hpp>
+#include <random>
+#include <set>
+#include <util/rdf_util.hpp>
+
+#include "test_util.hpp"
+
+using namespace std;
+
+typedef ltj::ltj_algorithm<> algorithm_type;
+typedef algorithm_type::tuple_type tuple_type;
+typedef vector<pair<uint8_t, uint64_t>> sorted_tuple_type;
+
+struct results_set {
+  set<sorted_tuple_type> tuples;
+  uint64_t n = 0;
+  void add(const tuple_type &t) {
+    sorted_tuple_type s(t.begin(), t.end());
+    sort(s.begin(), s.end());
+    tuples.insert(s);
+    ++n;
+  }
+  uint64_t size() const {
+    return n;
+  }
+};
+
+/*
+    The searches that stop at a limit leave the query in the middle of the
+    VEO, and they must undo it before returning. Runs a limited
+    join_projected, join_ordered or join on an object and then a full
+    join() on the same object, which must report the results of a new one.
+*/
+uint64_t check_reuse(cltj::compact_ltj &index, const string &q) {
+  auto query = ::util::rdf::ids::get_query(q);
+  results_set expected;
+  algorithm_type fresh(&query, &index);
+  fresh.join(expected);
+
+  set<uint8_t> vars;
+  for (const auto &tp : query) {
+    if (tp.term_s.is_variable)
+      vars.insert(tp.term_s.value);
+    if (tp.term_p.is_variable)
+      vars.insert(tp.term_p.value);
+    if (tp.term_o.is_variable)
+      vars.insert(tp.term_o.value);
+  }
+
+  uint64_t errors = 0;
+  for (const uint8_t v : vars) {
+    for (uint64_t mode = 0; mode < 4; ++mode) {
+      algorithm_type join(&query, &index);
+      results_set limited;
+      switch (mode) {
+      case 0:
+        join.join_projected(limited, vector<uint8_t>(1, v), true, 2);
+        break;
+      case 1:
+        join.join_projected(limited, vector<uint8_t>(1, v), false, 2);
+        break;
+      case 2:
+        join.join_ordered(limited, v, 3);
+        break;
+      default:
+        join.join(limited, 1);
+      }
+      results_set res;
+      join.join(res);
+      if (res.tuples != expected.tuples || res.size() != expected.size()) {
+        cout << "Error: " << q << ": mode " << mode << " on variable "
+             << (uint64_t)v << ": " << res.size() << " results, expected "
+             << expected.size() << endl;
+        ++errors;
+      }
+    }
+  }
+  return errors;
+}
+
+int main() {
+  std::mt19937_64 gen(11);
+  set<cltj::spo_triple> triples;
+  while (triples.size() < 400) {
+    triples.insert(
+        {(uint32_t)(gen() % 20 + 1), (uint32_t)(gen() % 4 + 1),
+         (uint32_t)(gen() % 20 + 1)}
+    );
+  }
+  vector<cltj::spo_triple> D(triples.begin(), triples.end());
+  cltj::compact_ltj index(D);
+
+  const vector<string> queries = {
+      "?x 1 ?y . ?y 2 ?z",
+      "?x 1 ?y . ?y 2 ?z . ?z 3 ?x",
+      "?x 1 ?a . ?x 2 ?b . ?x 3 ?c",
+      "?x ?p ?y . ?y 1 ?z",
+      "?x 1 ?y . ?x 2 ?z . ?x ?p ?w"};
+  uint64_t errors = 0;
+  for (const auto &q : queries) {
+    errors += check_reuse(index, q);
+  }
+  return report(errors);
+}
@@ -0,0 +1,171 @@
+#include <index/cltj_index_spo_lite.hpp>
+#include <iostream>
+#include <query/ltj_algorithm.hpp>
+#include <random>
+#include <set>
+#include <trie/cltj_compact_trie.hpp>
+#include <util/rdf_util.hpp>
+
+using namespace std;
+
+typedef ltj::ltj_iterator_lite<cltj::compact_ltj_64, uint8_t, uint64_t>
+    iterator_64_type;
+typedef ltj::ltj_algorithm<
+    iterator_64_type,
+    ltj::veo::veo_adaptive<iterator_64_type, ltj::util::trait_size>>
+    algorithm_64_type;
+
+struct results_set {
+  set<vector<uint64_t>> tuples;
+  void add(const algorithm_64_type::tuple_type &t) {
+    vector<uint64_t> v(t.size());
+    for (const auto &b : t) {
+      v[b.first] = b.second;
+    }
+    tuples.insert(v);
+  }
+  uint64_t size() const {
+    return tuples.size();
+  }
+};
+
+/*
+    IDs above 2^32: the seeks of a compact_trie_t<uint64_t> must not cut
+    the values to 32 bits (2^32 + 5 is not 5), and neither must the
+    iterators and the join on a compact_ltj_64.
+*/
+uint64_t check_wide_ids() {
+  const uint64_t big = 1ULL << 32;
+  uint64_t errors = 0;
+
+  // Runs {1, 3, 5, 2^32 + 5} and {7, 2^32 + 3, 2^32 + 9}
+  vector<uint64_t> syms = {1, 3, 5, big + 5, 7, big + 3, big + 9};
+  vector<uint64_t> lengths = {4, 3};
+  cltj::compact_trie_t<uint64_t> trie(syms, lengths);
+  const auto a = trie.binary_search_seek(big + 5, 0, 3);
+  const auto b = trie.gallop_seek(big + 4, 4, 6);
+  const auto c = trie.gallop_seek(big + 10, 4, 6);
+  if (a.first != big + 5 || a.second != 3)
+    ++errors;
+  if (b.first != big + 9 || b.second != 6)
+    ++errors;
+  if (c.second != 7)
+    ++errors;
+
+  // Subjects and objects above 2^32, with the predicates 1 and 2
+  vector<cltj::spo_triple_t<uint64_t>> D;
+  for (uint64_t k = 0; k < 20; ++k) {
+    D.push_back({big + k, 1, big + k + 100});
+    D.push_back({big + k + 100, 2, k % 5 + 1});
+    D.push_back({k + 1, 2, big + k}); // Same low 32 bits as big + k
+  }
+  const vector<cltj::spo_triple_t<uint64_t>> triples = D;
+  cltj::compact_ltj_64 index(D);
+
+  const string x = to_string(big + 3);
+  auto query = ::util::rdf::ids::get_query(x + " 1 ?y . ?y 2 ?z");
+  algorithm_64_type join(&query, &index);
+  results_set res;
+  join.join(res);
+  // ?y = 2^32 + 103, ?z = 4 (variables in order of appearance)
+  if (res.tuples != set<vector<uint64_t>>{{big + 103, 4}})
+    ++errors;
+
+  auto all = ::util::rdf::ids::get_query("?x 1 ?y . ?y 2 ?z");
+  algorithm_64_type join_all(&all, &index);
+  results_set res_all;
+  join_all.join(res_all);
+  set<vector<uint64_t>> expected;
+  for (const auto &t : triples) {
+    for (const auto &u : triples) {
+      if (t[1] == 1 && u[1] == 2 && t[2] == u[0])
+        expected.insert({t[0], t[2], u[2]});
+    }
+  }
+  if (res_all.tuples != expected)
+    ++errors;
+  return errors;
+}
+
+/*
+    Checks the IDs above 2^32 first. Then builds a compact_trie and checks
+    child, nodeselect, children and the seeks, biased to its last positions.
+
+    Every run of siblings has the same length r, so the trie is a complete
+    r-ary tree in BFS order: the kth run starts at (k - 1) * r and the jth
+    sibling of a run stores 2j + 1. By default the trie is small; with
+    --large it has more than 2^32 nodes (it needs more than 6 GB of memory),
+    and with r = 2 also more than 2^32 runs, so the positions and the ranks
+    passed to select0 do not fit in 32 bits. The size and r can also be
+    given as arguments. bv and seq are written in place and moved into the
+    trie, without the vectors of symbols and lengths of the other
+    constructor.
+*/
+int main(int argc, char **argv) {
+  uint64_t n = 1ULL << 20;
+  uint64_t r = 2;
+  uint64_t queries = 1000000;
+  int arg = 1;
+  if (argc > arg && string(argv[arg]) == "--large") {
+    n = (1ULL << 33) + 1024;
+    ++arg;
+  } else if (argc > arg) {
+    n = std::atoll(argv[arg++]);
+  }
+  if (argc > arg)
+    r = std::atoll(argv[arg]);
+
+  if (check_wide_ids()) {
+    cout << "Error: wrong results with IDs above 2^32" << endl;
+    return 1;
+  }
+  n = (n + r - 1) / r * r;
+
+  cout << "Building a trie of " << n << " nodes (runs of " << r << ")"
+       << endl;
+  sdsl::bit_vector bv(n + 1, 1);
+  sdsl::int_vector<> seq(n, 0, sdsl::bits::hi(2 * r - 1) + 1);
+  for (uint64_t i = 0; i < n; ++i) {
+    if (i % r == 0)
+      bv[i] = 0;
+    seq[i] = 2 * (i % r) + 1;
+  }
+  bv[n] = 0;
+  cltj::compact_trie trie(std::move(bv), std::move(seq));
+  cout << "Trie: " << sdsl::size_in_bytes(trie) << " bytes." << endl;
+
+  const uint64_t runs = n / r, tail = 1ULL << 20;
+  std::mt19937_64 gen(42);
+  uint64_t errors = 0;
+  for (uint64_t q = 0; q < queries; ++q) {
+    // Biased to the last runs, whose positions do not fit in 32 bits
+    const uint64_t k = (q % 2) ? runs - gen() % std::min(runs, tail)
+                               : 1 + gen() % runs;
+    const uint64_t s = (k - 1) * r;
+    // select0(it + gap + n) is the start of the kth run
+    if (k >= 2) {
+      if (trie.child(k - 2, 1) != s || trie.nodeselect(k - 2) != s)
+        ++errors;
+      if (trie.child(k - 1, 1, 0) != s || trie.nodeselect(k - 1, 0) != s)
+        ++errors;
+    }
+    if (trie.children(s) != r)
+      ++errors;
+    const uint64_t j = gen() % (r + 1);
+    const auto b = trie.binary_search_seek(2 * j, s, s + r - 1);
+    const auto g = trie.gallop_seek(2 * j, s, s + r - 1);
+    if (b != g)
+      ++errors;
+    if (j < r && (b.first != 2 * j + 1 || b.second != s + j))
+      ++errors;
+    if (j == r && b.second != s + r)
+      ++errors;
+  }
+
+  if (errors) {
+    cout << "Error: " << errors << " wrong results" << endl;
+    return 1;
+  }
+  cout << "OK: " << queries << " queries" << endl;
+  return 0;
+}
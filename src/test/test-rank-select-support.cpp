@@ -0,0 +1,92 @@
+#include <cds/rank_select_support.hpp>
+#include <random>
+#include <vector>
+
+#include "test_util.hpp"
+
+using namespace std;
+
+/*
+    Checks rank, select and succ of every position and every pattern bit
+    against a scan of the bitvector. Small sample logs put many select
+    samples in each block, and every k is checked, so the ones just before
+    and after each sample too.
+*/
+template <uint8_t t_b, uint8_t t_sample_log>
+uint64_t check(const sdsl::bit_vector &bv) {
+  typedef cds::rank_select_support<t_b, t_sample_log> rs_type;
+  const uint64_t n = bv.size();
+  rs_type built(&bv);
+
+  // Copied, moved and loaded from the serialized directory
+  rs_type rs;
+  copy_move_load(built, rs, &bv);
+
+  uint64_t errors = 0;
+  vector<uint64_t> pos;
+  for (uint64_t i = 0; i < n; ++i) {
+    if (bv[i] == t_b)
+      pos.push_back(i);
+  }
+  if (rs.count() != pos.size() || rs.size() != n)
+    ++errors;
+  for (uint64_t k = 1; k <= pos.size(); ++k) {
+    if (rs.select(k) != pos[k - 1] || rs(k) != pos[k - 1])
+      ++errors;
+  }
+  uint64_t r = 0, next = 0;
+  for (uint64_t i = 0; i <= n + 2; ++i) {
+    if (i <= n && rs.rank(i) != r)
+      ++errors;
+    while (next < pos.size() && pos[next] < i) {
+      ++next;
+    }
+    if (rs.succ(i) != ((next < pos.size()) ? pos[next] : n))
+      ++errors;
+    if (i < n && bv[i] == t_b)
+      ++r;
+  }
+  return errors;
+}
+
+template <uint8_t t_b> uint64_t check_all(const sdsl::bit_vector &bv) {
+  return check<t_b, 0>(bv) + check<t_b, 3>(bv) + check<t_b, 9>(bv);
+}
+
+int main() {
+  std::mt19937_64 gen(5);
+  // Sizes around the words and the blocks of 512 bits, and random ones
+  vector<uint64_t> sizes = {0, 1, 63, 64, 65, 511, 512, 513, 1023, 1025};
+  for (uint64_t t = 0; t < 100; ++t) {
+    sizes.push_back(gen() % 20000);
+  }
+
+  uint64_t errors = 0;
+  for (uint64_t t = 0; t < sizes.size(); ++t) {
+    const uint64_t n = sizes[t];
+    sdsl::bit_vector bv(n, 1);
+    for (uint64_t i = 0; i < n; ++i) {
+      bool zero;
+      switch (t % 5) {
+      case 0:
+        zero = gen() % 2;
+        break;
+      case 1: // Sparse zeros
+        zero = gen() % 50 == 0;
+        break;
+      case 2: // Blocks without zeros
+        zero = gen() % 3000 == 0;
+        break;
+      case 3: // Only zeros
+        zero = true;
+        break;
+      default: // Long runs of each bit
+        zero = (i / 700) % 2;
+      }
+      if (zero)
+        bv[i] = 0;
+    }
+    errors += check_all<0>(bv) + check_all<1>(bv);
+  }
+  return report(errors);
+}
@@ -0,0 +1,48 @@
+#ifndef CLTJ_TEST_UTIL_HPP
+#define CLTJ_TEST_UTIL_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+/*
+    Copies x, moves the copy, and serializes the moved one into ss. A
+    structure that keeps pointers (a support to its bit_vector, the lines
+    of a trie) must fix them in each of those steps.
+*/
+template <class T> void serialize_moved(const T &x, std::stringstream &ss) {
+  T copied(x), moved;
+  moved = std::move(copied);
+  moved.serialize(ss);
+}
+
+/*
+    Receives a structure x
+    Loads into res the serialization of a moved copy of x
+*/
+template <class T> void copy_move_load(const T &x, T &res) {
+  std::stringstream ss;
+  serialize_moved(x, ss);
+  res.load(ss);
+}
+
+// Same, for the supports that are loaded over their bit_vector v
+template <class T, class t_vector>
+void copy_move_load(const T &x, T &res, const t_vector *v) {
+  std::stringstream ss;
+  serialize_moved(x, ss);
+  res.load(ss, v);
+}
+
+// Prints the result of a test and returns its exit code
+inline int report(const uint64_t errors) {
+  if (errors) {
+    std::cout << "Error: " << errors << " wrong results" << std::endl;
+    return 1;
+  }
+  std::cout << "OK" << std::endl;
+  return 0;
+}
+
+#endif // CLTJ_TEST_UTIL_HPP